@@ -0,0 +1,291 @@
+// model/core_cycle_model.h
+// Modelo a nivel de transaccion de bilinear_core_scalar / bilinear_core_simd.
+//
+// Recorre la misma FSM que el RTL (S_IDLE -> S_ISSUE -> S_COMP) un estado por
+// ciclo, con los N lanes del SIMD agrupados por fila y las 4 lecturas de
+// vecinos por lane. Da los pixeles (misma aritmetica entera que el core,
+// incluido el registro inv_scale_q de 16 bits) y los contadores como los
+// cuenta el top:
+//   - perf_cyc: ciclos con busy && !done (PERF_CYC de dsa_top_seq y
+//     bilinear_top). Cada grupo es ISSUE + COMP = 2 ciclos, asi que da
+//     2 * ceil(out_w / N) * out_h.
+//   - perf_pix: escrituras con wr_valid (popcount en el SIMD).
+// lanes = 1 es el core escalar. Con lanes > 1 se asume que el SIMD tiene los
+// mismos puertos de tiling que el escalar (hoy no los tiene; sin tiling
+// src = in y org/off = 0, y da lo mismo que el RTL actual).
+//
+// Se valida contra los contadores del RTL con scripts/check_core_model.py
+// (iverilog + tb/top/tb_core_cycles.sv).
+//
+// run_box_core_model hace lo mismo con box_core_scalar (REG_MODE[1]): una
+// salida por vez, S_SPAN + un S_ACC por pixel de la huella + 8 S_DIV (un bit
+// del cociente por ciclo) + S_WRITE.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "downscale_kernels.h"
+#include "downscale_tiles.h"
+
+struct core_params {
+    int lanes = 1;              // 1 = escalar, N = SIMD
+    int in_w = 0, in_h = 0;     // lo que hay en la BRAM de entrada
+    int out_w = 0, out_h = 0;
+    uint32_t inv_scale_q = 0x100;   // se trunca a 16 bits como el registro
+
+    // Tiling (ver bilinear_core_scalar); src_w = 0 es sin tiling
+    int src_w = 0, src_h = 0;
+    int org_x = 0, org_y = 0;
+    int off_x = 0, off_y = 0;
+
+    // Pixeles de la BRAM: las lecturas fuera de [0, bram) dan 0. 0 = in_w *
+    // in_h (como los tb); dsa_top_seq usa IMG_MAX_W * IMG_MAX_H
+    int bram = 0;
+};
+
+struct core_stats {
+    uint64_t perf_cyc = 0;     // como PERF_CYC
+    uint64_t perf_pix = 0;     // como PERF_PIX
+    uint64_t groups = 0;       // pasadas ISSUE + COMP
+    uint64_t lane_slots = 0;   // groups * lanes (para la ocupacion de lanes)
+    uint64_t bram_reads = 0;   // 4 por lane activo
+    uint64_t oob_reads = 0;    // lecturas fuera de in_w * in_h (dan 0, como en los tb)
+
+    // Del flanco que escribe START hasta que done se ve en 1: un ciclo de
+    // start_pulse/S_IDLE mas los de la corrida
+    uint64_t start_to_done() const { return perf_cyc + 1; }
+
+    void add(const core_stats &o) {
+        perf_cyc += o.perf_cyc;
+        perf_pix += o.perf_pix;
+        groups += o.groups;
+        lane_slots += o.lane_slots;
+        bram_reads += o.bram_reads;
+        oob_reads += o.oob_reads;
+    }
+};
+
+// inv_scale_q como lo carga dsa_top_seq al START: 65536/scale en 16 bits
+// (0x100 con escala 0). Con scale_q8_8 = 1 el cociente no entra y queda 0.
+static inline uint32_t core_inv_scale_q(uint32_t scale_q8_8) {
+    return hw_q88_rounding::inv_scale_q(scale_q8_8) & 0xFFFFu;
+}
+
+// Corre el core una vez. Con in == nullptr solo cuenta (no lee ni escribe
+// pixeles, es lo que usa el barrido); si no, out tiene out_w * out_h bytes.
+static inline core_stats run_core_model(const core_params &p, const uint8_t *in, uint8_t *out) {
+    const int ONE_Q = 256;
+    const int N = p.lanes < 1 ? 1 : p.lanes;
+    const int src_w = p.src_w ? p.src_w : p.in_w;
+    const int src_h = p.src_w ? p.src_h : p.in_h;
+    const int64_t bram = p.bram ? p.bram : (int64_t)p.in_w * p.in_h;
+    const uint32_t inv = p.inv_scale_q & 0xFFFFu;
+
+    // Lo que ISSUE deja registrado por lane para COMP
+    struct lane_regs {
+        bool active;
+        int64_t addr[4];
+        int tx, ty;
+    };
+    std::vector<lane_regs> lr(N);
+
+    // Coordenada del eje: misma cuenta que S_ISSUE (producto en 32 bits sin
+    // signo, como integer * reg[15:0] en el RTL)
+    auto axis = [&](int o, int n, int &i0, int &i1, int &t) {
+        int o_q = (o << 8) + ONE_Q / 2;
+        int s_q = (int)(((uint32_t)o_q * inv) >> 8) - ONE_Q / 2;
+        int a = s_q >> 8;
+        if (a < 0) a = 0;
+        else if (a > n - 1) a = n - 1;
+        i0 = a;
+        i1 = (a + 1 <= n - 1) ? a + 1 : a;
+        t = s_q & (ONE_Q - 1);
+    };
+    auto rd = [&](int64_t a, core_stats &st) -> int {
+        ++st.bram_reads;
+        if (a < 0 || a >= bram) {
+            ++st.oob_reads;
+            return 0;
+        }
+        return in[a];
+    };
+
+    enum { S_IDLE, S_ISSUE, S_COMP } state = S_IDLE;
+    core_stats st;
+    int cur_x = 0, cur_y = 0;
+    bool busy = false, done = false;
+
+    // start llega en S_IDLE; cada vuelta es un flanco de reloj
+    for (bool start = true;; start = false) {
+        if (busy && !done) ++st.perf_cyc;
+
+        switch (state) {
+        case S_IDLE:
+            if (!start) return st;
+            busy = true;
+            done = false;
+            cur_x = cur_y = 0;
+            state = S_ISSUE;
+            break;
+
+        case S_ISSUE:
+            ++st.groups;
+            st.lane_slots += N;
+            for (int l = 0; l < N; ++l) {
+                lane_regs &r = lr[l];
+                r.active = cur_x + l < p.out_w;
+                if (!r.active) continue;
+                if (!in) {   // solo cuenta: las lecturas no cambian los ciclos
+                    st.bram_reads += 4;
+                    continue;
+                }
+                int x0, x1, y0, y1;
+                axis(cur_x + l + p.org_x, src_w, x0, x1, r.tx);
+                axis(cur_y + p.org_y, src_h, y0, y1, r.ty);
+                r.addr[0] = (int64_t)(y0 - p.off_y) * p.in_w + (x0 - p.off_x);
+                r.addr[1] = (int64_t)(y0 - p.off_y) * p.in_w + (x1 - p.off_x);
+                r.addr[2] = (int64_t)(y1 - p.off_y) * p.in_w + (x0 - p.off_x);
+                r.addr[3] = (int64_t)(y1 - p.off_y) * p.in_w + (x1 - p.off_x);
+            }
+            state = S_COMP;
+            break;
+
+        case S_COMP:
+            for (int l = 0; l < N; ++l) {
+                const lane_regs &r = lr[l];
+                if (!r.active) continue;
+                ++st.perf_pix;
+                if (!in) continue;
+                int wx0 = ONE_Q - r.tx, wy0 = ONE_Q - r.ty;
+                int acc = rd(r.addr[0], st) * wx0 * wy0 + rd(r.addr[1], st) * r.tx * wy0 +
+                          rd(r.addr[2], st) * wx0 * r.ty + rd(r.addr[3], st) * r.tx * r.ty;
+                int pix = (acc + (1 << 15)) >> 16;
+                out[(size_t)cur_y * p.out_w + cur_x + l] = (uint8_t)(pix > 255 ? 255 : pix);
+            }
+            if (cur_x + N < p.out_w) {
+                cur_x += N;
+            } else {
+                cur_x = 0;
+                if (cur_y + 1 < p.out_h) {
+                    ++cur_y;
+                } else {
+                    busy = false;
+                    done = true;
+                    state = S_IDLE;
+                    break;
+                }
+            }
+            state = S_ISSUE;
+            break;
+        }
+    }
+}
+
+// Corre box_core_scalar una vez (lanes no se usa). Cada salida cuesta
+// n + 10 ciclos (n = pixeles de la huella) y lee n veces la BRAM; in/out
+// como en run_core_model.
+static inline core_stats run_box_core_model(const core_params &p, const uint8_t *in,
+                                            uint8_t *out) {
+    const int src_w = p.src_w ? p.src_w : p.in_w;
+    const int src_h = p.src_w ? p.src_h : p.in_h;
+    const int64_t bram = p.bram ? p.bram : (int64_t)p.in_w * p.in_h;
+    const int64_t inv = p.inv_scale_q & 0xFFFFu;
+
+    // Huella del eje: misma cuenta que S_SPAN
+    auto span = [&](int o, int n, int &b, int &e) {
+        b = (int)(((int64_t)o * inv) >> 8);
+        e = (int)(((int64_t)(o + 1) * inv) >> 8);
+        if (b > n - 1) b = n - 1;
+        if (e > n) e = n;
+        if (e <= b) e = b + 1;
+    };
+
+    core_stats st;
+    for (int cy = 0; cy < p.out_h; ++cy) {
+        int yb, ye;
+        span(cy + p.org_y, src_h, yb, ye);
+        for (int cx = 0; cx < p.out_w; ++cx) {
+            int xb, xe;
+            span(cx + p.org_x, src_w, xb, xe);
+            const int cnt = (xe - xb) * (ye - yb);
+            st.perf_cyc += (uint64_t)cnt + 10;
+            ++st.perf_pix;
+            ++st.groups;
+            ++st.lane_slots;
+            st.bram_reads += cnt;
+            if (!in) continue;
+
+            uint32_t acc = 0;
+            for (int y = yb; y < ye; ++y) {
+                for (int x = xb; x < xe; ++x) {
+                    const int64_t a = (int64_t)(y - p.off_y) * p.in_w + (x - p.off_x);
+                    if (a < 0 || a >= bram) {
+                        ++st.oob_reads;
+                        continue;
+                    }
+                    acc += in[a];
+                }
+            }
+            const uint32_t pix = (acc + (cnt >> 1)) / cnt;
+            out[(size_t)cy * p.out_w + cx] = (uint8_t)(pix > 255 ? 255 : pix);
+        }
+    }
+    return st;
+}
+
+// -----------------------------------------------------------------------------
+// Imagen entera en un core con BRAM de max_w x max_h (tiles como el driver)
+// -----------------------------------------------------------------------------
+
+struct core_image_stats {
+    int out_w = 0, out_h = 0;
+    int tiles = 0;
+    core_stats core;   // sumado sobre los tiles
+};
+
+// Parte la imagen como dsa_jtag_driver (plan_hw_tiles) y corre cada tile en
+// el modelo. src/out como en run_core_model (src == nullptr: solo cuenta).
+// box: core box y tiles con las huellas enteras (como el driver con --box).
+// Si la huella de una salida no entra en max_w x max_h no hay tiles
+// (r.tiles == 0) y out queda sin tocar.
+static inline core_image_stats run_core_model_image(int W, int H, uint32_t scale_q8_8,
+                                                    int lanes, int max_w, int max_h,
+                                                    const uint8_t *src, uint8_t *out,
+                                                    bool box = false) {
+    core_image_stats r;
+    hw_out_dims(W, H, scale_q8_8, 0, 0, r.out_w, r.out_h);
+    std::vector<hw_tile> tiles = plan_hw_tiles(W, H, r.out_w, r.out_h, scale_q8_8, max_w, max_h,
+                                               box);
+    r.tiles = (int)tiles.size();
+
+    std::vector<uint8_t> tin, tout;
+    for (const hw_tile &t : tiles) {
+        core_params p;
+        p.lanes = lanes;
+        p.in_w = t.iw;
+        p.in_h = t.ih;
+        p.out_w = t.ow;
+        p.out_h = t.oh;
+        p.inv_scale_q = core_inv_scale_q(scale_q8_8);
+        p.src_w = W;
+        p.src_h = H;
+        p.org_x = t.ox;
+        p.org_y = t.oy;
+        p.off_x = t.ix;
+        p.off_y = t.iy;
+        if (src) {
+            tin.resize((size_t)t.iw * t.ih);
+            tout.resize((size_t)t.ow * t.oh);
+            crop_tile_input(src, W, t, tin.data());
+            r.core.add(box ? run_box_core_model(p, tin.data(), tout.data())
+                           : run_core_model(p, tin.data(), tout.data()));
+            stitch_tile_output(tout.data(), t, out, r.out_w);
+        } else {
+            r.core.add(box ? run_box_core_model(p, nullptr, nullptr)
+                           : run_core_model(p, nullptr, nullptr));
+        }
+    }
+    return r;
+}
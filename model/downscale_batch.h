@@ -0,0 +1,158 @@
+// model/downscale_batch.h
+// Modo lote: corre todos los casos de un manifest.csv en un solo proceso.
+//
+// Formato (el mismo que lee scripts/make_golden.py):
+//   name,w,h,scale,in_path,out_raw,out_pgm      (out_pgm puede ir vacio)
+// Las lineas vacias o que empiezan con # se ignoran.
+//
+//  - Las tablas de coordenadas se construyen una vez por (W, H, scale) y
+//    las comparten todos los casos iguales.
+//  - Los casos son independientes y se reparten en el thread_pool (un caso
+//    por tarea, sin bandas adentro: parallel_for no se anida).
+//  - Cada hilo guarda sus buffers de entrada, salida y scratch SIMD y los
+//    reutiliza de un caso a otro; solo crecen.
+//  - Con cache (model/result_cache.h) un caso cuya entrada ya se vio con la
+//    misma escala copia la salida guardada en vez de recalcularla; los
+//    archivos de salida se escriben igual.
+
+#pragma once
+
+#include <map>
+#include <tuple>
+
+#include "downscale_kernels.h"
+#include "image_io.h"
+#include "result_cache.h"
+#include "thread_pool.h"
+
+struct manifest_case {
+    std::string name;
+    int w = 0, h = 0;
+    double scale = 1.0;
+    std::string in_path, out_raw, out_pgm;
+};
+
+static inline std::string trim_field(const std::string &s) {
+    size_t b = s.find_first_not_of(" \t\r\n");
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return b == std::string::npos ? std::string() : s.substr(b, e - b + 1);
+}
+
+static inline std::vector<manifest_case> read_manifest(const std::string &path) {
+    std::vector<uint8_t> buf;
+    size_t n = read_file_into(path, buf);
+    std::vector<manifest_case> cases;
+
+    size_t pos = 0;
+    int line_no = 0;
+    while (pos < n) {
+        size_t end = pos;
+        while (end < n && buf[end] != '\n') ++end;
+        std::string line = trim_field(std::string((const char *)buf.data() + pos, end - pos));
+        pos = end + 1;
+        ++line_no;
+        if (line.empty() || line[0] == '#') continue;
+
+        std::vector<std::string> f;
+        size_t a = 0;
+        for (;;) {
+            size_t c = line.find(',', a);
+            f.push_back(trim_field(line.substr(a, c == std::string::npos ? std::string::npos : c - a)));
+            if (c == std::string::npos) break;
+            a = c + 1;
+        }
+        const std::string where = path + ":" + std::to_string(line_no);
+        if (f.size() != 6 && f.size() != 7)
+            throw std::runtime_error(where + ": se esperaban 7 campos (name,w,h,scale,in_path,out_raw,out_pgm)");
+
+        manifest_case mc;
+        try {
+            mc.name = f[0];
+            mc.w = std::stoi(f[1]);
+            mc.h = std::stoi(f[2]);
+            mc.scale = std::stod(f[3]);
+        } catch (const std::exception &) {
+            throw std::runtime_error(where + ": w, h o scale no son numeros");
+        }
+        mc.in_path = f[4];
+        mc.out_raw = f[5];
+        if (f.size() == 7) mc.out_pgm = f[6];
+        if (mc.w <= 0 || mc.h <= 0 || mc.scale <= 0 || mc.in_path.empty() || mc.out_raw.empty())
+            throw std::runtime_error(where + ": caso invalido");
+        cases.push_back(mc);
+    }
+    return cases;
+}
+
+struct batch_result {
+    int ok = 0;
+    int total = 0;
+    std::vector<std::string> errors;   // "name: mensaje", en el orden del manifest
+};
+
+static inline batch_result run_manifest(const std::vector<manifest_case> &cases,
+                                        thread_pool &pool,
+                                        simd_level lvl = default_simd_level(),
+                                        result_cache *cache = nullptr) {
+    // Tablas por (W, H, scale): se arman antes, en serie, asi los hilos solo
+    // las leen y no hace falta candado.
+    std::map<std::tuple<int, int, double>, coord_tables> tables;
+    std::vector<const coord_tables *> case_tab(cases.size());
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const manifest_case &c = cases[i];
+        auto key = std::make_tuple(c.w, c.h, c.scale);
+        auto it = tables.find(key);
+        if (it == tables.end())
+            it = tables.emplace(key, build_coord_tables(c.w, c.h, c.scale)).first;
+        case_tab[i] = &it->second;
+    }
+
+    std::vector<std::string> err(cases.size());
+    pool.parallel_for((int)cases.size(), [&](int i) {
+        struct buffers {
+            std::vector<uint8_t> in, out;
+            std::vector<uint16_t> v;
+        };
+        thread_local buffers b;
+
+        const manifest_case &c = cases[i];
+        const coord_tables &t = *case_tab[i];
+        try {
+            size_t n = read_file_into(c.in_path, b.in);
+            size_t off = 0;
+            if (has_pgm_ext(c.in_path)) {
+                int pw = 0, ph = 0;
+                off = parse_pgm_header(b.in.data(), n, pw, ph);
+                if (!off || pw != c.w || ph != c.h)
+                    throw std::runtime_error("el PGM no es P5 de " + std::to_string(c.w) +
+                                             "x" + std::to_string(c.h));
+            }
+            if (n < off + (size_t)c.w * c.h)
+                throw std::runtime_error("tamano incorrecto en " + c.in_path + " (se esperaba W*H)");
+
+            const size_t out_n = (size_t)t.W2 * t.H2;
+            if (b.out.size() < out_n) b.out.resize(out_n);
+            if (b.v.size() < simd_scratch_len(c.w)) b.v.resize(simd_scratch_len(c.w));
+
+            const uint8_t *pix = b.in.data() + off;
+            const uint64_t key = cache ? result_cache_key(pix, c.w, c.h, 1, cache_model_golden(c.scale)) : 0;
+            if (!cache || !cache->get(key, b.out.data(), t.W2, t.H2, 1)) {
+                downscale_u8_rows(pix, c.w, t, b.out.data(), 0, t.H2, lvl, b.v.data());
+                if (cache) cache->put(key, b.out.data(), t.W2, t.H2, 1);
+            }
+            write_image_u8(c.out_raw, b.out.data(), t.W2, t.H2);
+            if (!c.out_pgm.empty())
+                write_image_u8(c.out_pgm, b.out.data(), t.W2, t.H2, true);
+        } catch (const std::exception &e) {
+            err[i] = c.name + ": " + e.what();
+        }
+    });
+
+    batch_result r;
+    r.total = (int)cases.size();
+    for (auto &e : err) {
+        if (e.empty()) ++r.ok;
+        else r.errors.push_back(e);
+    }
+    return r;
+}
@@ -0,0 +1,125 @@
+// model/downscale_box.h
+// Modo box (promedio de area) para reducciones fuertes.
+//
+// Con escala < 0.5 el bilineal mira 2x2 entradas por salida y saltea el
+// resto, asi que aparece aliasing. En modo box cada salida es el promedio
+// de todas las entradas de su huella:
+//   eje: [b(o), e(o)) con b(o) = (o * inv_scale_q) >> 8
+//                         e(o) = ((o+1) * inv_scale_q) >> 8
+//   (clamp a n_in y como minimo una entrada, hw_q88_rounding::box_span)
+//   pix = (suma + n/2) / n,   n = (xe-xb)*(ye-yb)
+// Todo entero y con el inv_scale_q del core, igual que box_core_scalar.sv
+// (REG_MODE[1] en dsa_top_seq), asi que el modelo y el HW dan los mismos
+// bytes. Las dimensiones de salida son las del HW (hw_out_dims). Con 0x01
+// pasa lo mismo que en el bilineal: 65536 no entra en el registro de 16
+// bits y el core usa 0.
+//
+// El kernel va por filas de salida: suma en u16 las filas de la huella
+// (a lo sumo ceil(inv_scale_q/256) <= 256 filas de 255, cabe) en una
+// pasada contigua que el compilador vectoriza, y despues suma las columnas
+// de cada salida y divide.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "downscale_kernels.h"
+#include "downscale_parallel.h"
+
+struct box_tables {
+    int W2 = 0, H2 = 0;
+    int chans = 1;                 // >1: filas intercaladas de W*chans bytes
+    std::vector<int> xb, xe;       // huella en x (en pixeles) de cada columna
+    std::vector<int> yb, ye;       // huella en y de cada fila
+};
+
+// Tablas del box con out_w/out_h ya calculados (hw_out_dims)
+static inline box_tables build_box_tables(int W, int H, int out_w, int out_h,
+                                          uint32_t scale_q8_8, int chans = 1) {
+    box_tables t;
+    t.W2 = out_w;
+    t.H2 = out_h;
+    t.chans = chans;
+    t.xb.resize(out_w);
+    t.xe.resize(out_w);
+    t.yb.resize(out_h);
+    t.ye.resize(out_h);
+    for (int xo = 0; xo < out_w; ++xo) {
+        axis_coord c = hw_q88_rounding::box_span(xo, W, scale_q8_8);
+        t.xb[xo] = c.i0;
+        t.xe[xo] = c.i1 + 1;
+    }
+    for (int yo = 0; yo < out_h; ++yo) {
+        axis_coord c = hw_q88_rounding::box_span(yo, H, scale_q8_8);
+        t.yb[yo] = c.i0;
+        t.ye[yo] = c.i1 + 1;
+    }
+    return t;
+}
+
+// Filas de salida [yo_begin, yo_end); W en pixeles. col es scratch de
+// W*chans entradas.
+static inline void downscale_box_u8_rows(const uint8_t *img, int W, const box_tables &t,
+                                         uint8_t *out, int yo_begin, int yo_end,
+                                         uint16_t *col) {
+    const int C = t.chans;
+    const size_t row_bytes = (size_t)W * C;
+    for (int yo = yo_begin; yo < yo_end; ++yo) {
+        const int y0 = t.yb[yo], ny = t.ye[yo] - y0;
+        const uint8_t *r = img + (size_t)y0 * row_bytes;
+        for (size_t i = 0; i < row_bytes; ++i) col[i] = r[i];
+        for (int y = 1; y < ny; ++y) {
+            r += row_bytes;
+            for (size_t i = 0; i < row_bytes; ++i) col[i] += r[i];
+        }
+
+        uint8_t *o = out + (size_t)yo * t.W2 * C;
+        for (int xo = 0; xo < t.W2; ++xo) {
+            const int x0 = t.xb[xo], x1 = t.xe[xo];
+            const uint32_t n = (uint32_t)(x1 - x0) * ny;
+            for (int c = 0; c < C; ++c) {
+                uint32_t sum = 0;
+                for (int x = x0; x < x1; ++x) sum += col[(size_t)x * C + c];
+                o[(size_t)xo * C + c] = (uint8_t)((sum + n / 2) / n);
+            }
+        }
+    }
+}
+
+// Imagen completa: W x H -> t.W2 x t.H2
+static inline void downscale_box_u8(const uint8_t *img, int W, const box_tables &t,
+                                    uint8_t *out) {
+    std::vector<uint16_t> col((size_t)W * t.chans);
+    downscale_box_u8_rows(img, W, t, out, 0, t.H2, col.data());
+}
+
+// Pixeles y bytes de las filas [yo_begin, yo_end): las huellas en y enteras
+// (W pixeles de chans bytes por fila) mas la salida
+static inline perf_traffic box_band_traffic(const box_tables &t, int W,
+                                            int yo_begin, int yo_end) {
+    perf_traffic tr;
+    if (yo_end <= yo_begin) return tr;
+    tr.pixels = (uint64_t)(yo_end - yo_begin) * t.W2;
+    tr.bytes = ((uint64_t)(t.ye[yo_end - 1] - t.yb[yo_begin]) * W +
+                (uint64_t)(yo_end - yo_begin) * t.W2) * t.chans;
+    return tr;
+}
+
+// Por bandas de filas sobre el pool, como downscale_u8_bands (tambien con
+// perf_probe)
+static inline void downscale_box_u8_bands(const uint8_t *img, int W, const box_tables &t,
+                                          uint8_t *out, thread_pool &pool,
+                                          perf_probe *probe = nullptr) {
+    const int rows = band_rows_for(t.H2, pool.size());
+    const int n_bands = (t.H2 + rows - 1) / rows;
+    pool.parallel_for(n_bands, [&](int b) {
+        std::vector<uint16_t> col((size_t)W * t.chans);
+        const int yo_begin = b * rows;
+        const int yo_end = std::min(t.H2, yo_begin + rows);
+        perf_band_scope ps(probe, yo_begin, yo_end,
+                           probe ? box_band_traffic(t, W, yo_begin, yo_end) : perf_traffic());
+        downscale_box_u8_rows(img, W, t, out, yo_begin, yo_end, col.data());
+    });
+}
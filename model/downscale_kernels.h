@@ -0,0 +1,1096 @@
+// model/downscale_kernels.h
+// Kernels bilineales compartidos por downscale_ref_cpp y dsa_jtag_driver.
+//
+//  - coord_tables: coordenadas y pesos separables (por columna y por fila).
+//  - make_coord_tables<R>: tablas con una politica de redondeo
+//    (downscale_policy.h); build_coord_tables es la del golden Python y
+//    build_coord_tables_hw la del core (Q8.8 con inv_scale_q).
+//  - downscale_u8_rows: kernel entero sobre las tablas, con versiones
+//    escalar, SSE4.1 y AVX2 elegidas en tiempo de ejecucion (CPUID).
+//  - interleave_tables: las mismas tablas para RGB/RGBA intercalado, asi
+//    los kernels de gris sirven para color en una sola pasada.
+//
+// Todas las versiones dan exactamente los mismos bytes: el acumulador es
+//   acc = I00*wx0*wy0 + I10*tx*wy0 + I01*wx0*ty + I11*tx*ty
+// y la version SIMD lo evalua como
+//   v[x] = I(x,y0)*wy0 + I(x,y1)*ty          (cabe en 16 bits, <= 65280)
+//   acc  = v[x0]*wx0 + v[x1]*tx              (32 bits)
+// que es la misma suma entera reordenada. Igual que el core SIMD en RTL
+// procesa N lanes por grupo, aqui se hacen 16 (SSE4.1) o 32 (AVX2) píxeles
+// de salida por iteracion.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "downscale_policy.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DSA_HAVE_X86 1
+#else
+#define DSA_HAVE_X86 0
+#endif
+
+static inline uint8_t clamp_u8(int x) {
+    if (x < 0)   return 0;
+    if (x > 255) return 255;
+    return static_cast<uint8_t>(x);
+}
+
+// Kernel de fila para una escala fija: columnas de salida [0, xo_end)
+typedef void (*fixed_row_fn)(const uint8_t *r0, const uint8_t *r1,
+                             int wy0, int ty_q, uint8_t *o, int xo_end);
+
+struct fixed_row_kernels {
+    const char *name;
+    fixed_row_fn sse41, avx2;
+    // Promedio 2x2 sobre RGB/RGBA intercalado, solo para filas con
+    // wy0 == ty == 128 ([0] con 3 canales, [1] con 4; xo_end en bytes).
+    // nullptr salvo en 2:1 y 4:1 con el golden (pair_avg).
+    fixed_row_fn color_sse41[2], color_avx2[2];
+};
+
+// Tablas separables de coordenadas y pesos.
+// Los terminos en x dependen solo de xo y los de y solo de yo, asi que se
+// calculan una vez por columna/fila y el lazo interno queda en puros enteros.
+// Invariante que usan los kernels SIMD: x1 == x0+1 salvo en el borde
+// derecho, donde x1 == x0 == W-1 (igual en y), y 0 <= t_q <= 255.
+// Con escala > 1 el golden da fracciones negativas en el borde
+// (ej. t_q = -43 en xo=0 con s=1.5); en ese caso weights_u8 = false y solo
+// se usa el kernel escalar.
+struct coord_tables {
+    int W2 = 0, H2 = 0;
+    bool weights_u8 = true;
+    std::vector<int> x0, x1, tx_q, wx0;   // por columna de salida
+    std::vector<int> y0, y1, ty_q, wy0;   // por fila de salida
+
+    // Kernel de escala fija (ver "Kernels de escala fija"): vale para las
+    // columnas [0, fx_end); el resto va por el escalar. nullptr si no hay.
+    const fixed_row_kernels *fixed = nullptr;
+    int fx_end = 0;
+
+    // Canales intercalados (1 = gris). Con chans > 1 las tablas en x son por
+    // byte de salida (ver interleave_tables) y W2 cuenta bytes, no píxeles.
+    int chans = 1;
+};
+
+// Llena un eje con la politica R (downscale_policy.h): n_in muestras de
+// entrada, n_out de salida
+template <class R>
+static inline void fill_axis(int n_in, int n_out, typename R::scale_type scale,
+                             std::vector<int> &i0, std::vector<int> &i1,
+                             std::vector<int> &t_q, std::vector<int> &w0) {
+    i0.resize(n_out); i1.resize(n_out); t_q.resize(n_out); w0.resize(n_out);
+    for (int o = 0; o < n_out; ++o) {
+        axis_coord c = R::coord(o, n_in, scale);
+        i0[o] = c.i0; i1[o] = c.i1; t_q[o] = c.t_q; w0[o] = 256 - c.t_q;
+    }
+}
+
+template <class R>
+static inline void attach_fixed_kernel(coord_tables &t, int W, typename R::scale_type scale);
+
+// Tablas con la politica R y dimensiones de salida ya calculadas. Si la
+// escala es una de las fijas (0x40, 0x80, 0xC0, 0x100) y el patron vale, queda
+// enganchado el kernel especializado. La version _into escribe sobre t y
+// reusa la capacidad de sus vectores (sin reservas si la geometria no crece).
+template <class R>
+static inline void make_coord_tables_into(coord_tables &t, int W, int H, int W2, int H2,
+                                          typename R::scale_type scale) {
+    t.W2 = W2;
+    t.H2 = H2;
+    t.chans = 1;
+    t.fixed = nullptr;
+    t.fx_end = 0;
+    fill_axis<R>(W, t.W2, scale, t.x0, t.x1, t.tx_q, t.wx0);
+    fill_axis<R>(H, t.H2, scale, t.y0, t.y1, t.ty_q, t.wy0);
+    auto in_u8 = [](int q) { return q >= 0 && q <= 255; };
+    t.weights_u8 = std::all_of(t.tx_q.begin(), t.tx_q.end(), in_u8) &&
+                   std::all_of(t.ty_q.begin(), t.ty_q.end(), in_u8);
+    attach_fixed_kernel<R>(t, W, scale);
+}
+
+template <class R>
+static inline coord_tables make_coord_tables(int W, int H, int W2, int H2,
+                                             typename R::scale_type scale) {
+    coord_tables t;
+    make_coord_tables_into<R>(t, W, H, W2, H2, scale);
+    return t;
+}
+
+// Dimensiones de salida del golden: round(W*scale), como el Python
+static inline void golden_out_dims(int W, int H, double scale, int &out_w, int &out_h) {
+    out_w = std::max(1, (int)std::round(W * scale));
+    out_h = std::max(1, (int)std::round(H * scale));
+}
+
+// Tablas con semantica del golden (Python / downscale_ref_cpp)
+static inline coord_tables build_coord_tables(int W, int H, double scale) {
+    int W2, H2;
+    golden_out_dims(W, H, scale, W2, H2);
+    return make_coord_tables<golden_rounding>(W, H, W2, H2, scale);
+}
+
+// Tablas para una imagen de chans canales intercalados (RGB, RGBA) a partir
+// de las de gris. El canal c del píxel x esta en el byte x*chans + c, asi
+// que basta con expandir el eje x: el byte de salida xo*chans + c lee los
+// bytes x0*chans + c y x1*chans + c con los pesos de xo. Las coordenadas se
+// calculan una sola vez para todos los canales, y con W*chans como ancho de
+// fila los kernels de gris recorren la imagen intercalada en una pasada, sin
+// separar canales. Cada canal da los mismos bytes que el kernel de gris
+// sobre ese plano. El eje y no cambia.
+// Si g tiene kernel de escala fija con promedio de color (2:1 y 4:1) queda
+// enganchado para las mismas columnas, contadas en bytes.
+// interleave_tables_into escribe sobre t reusando su capacidad, como
+// make_coord_tables_into.
+static inline void interleave_tables_into(const coord_tables &g, int chans, coord_tables &t) {
+    t.W2 = g.W2 * chans;
+    t.H2 = g.H2;
+    t.weights_u8 = g.weights_u8;
+    t.chans = chans;
+    const bool color_fixed = g.fixed && g.fixed->color_sse41[0] && (chans == 3 || chans == 4);
+    t.fixed = color_fixed ? g.fixed : nullptr;
+    t.fx_end = color_fixed ? g.fx_end * chans : 0;
+    t.x0.resize(t.W2); t.x1.resize(t.W2); t.tx_q.resize(t.W2); t.wx0.resize(t.W2);
+    for (int xo = 0; xo < g.W2; ++xo) {
+        for (int c = 0; c < chans; ++c) {
+            const int k = xo * chans + c;
+            t.x0[k] = g.x0[xo] * chans + c;
+            t.x1[k] = g.x1[xo] * chans + c;
+            t.tx_q[k] = g.tx_q[xo];
+            t.wx0[k] = g.wx0[xo];
+        }
+    }
+    t.y0 = g.y0; t.y1 = g.y1; t.ty_q = g.ty_q; t.wy0 = g.wy0;
+}
+
+static inline coord_tables interleave_tables(const coord_tables &g, int chans) {
+    if (chans == 1) return g;
+    coord_tables t;
+    interleave_tables_into(g, chans, t);
+    return t;
+}
+
+// Dimensiones de salida como en dsa_top_seq. max_w/max_h es el limite del
+// core (HW_IMG_MAX_*); 0 = sin limite, para modelar el mismo pipeline Q8.8
+// sobre imagenes grandes.
+static inline void hw_out_dims(int W, int H, uint32_t scale_q8_8, int max_w, int max_h,
+                               int &out_w, int &out_h) {
+    out_w = std::max(1, (int)(((uint64_t)W * scale_q8_8) >> 8));
+    out_h = std::max(1, (int)(((uint64_t)H * scale_q8_8) >> 8));
+    if (max_w > 0) out_w = std::min(out_w, max_w);
+    if (max_h > 0) out_h = std::min(out_h, max_h);
+    out_w = std::min(out_w, W);
+    out_h = std::min(out_h, H);
+}
+
+// Tablas con semantica del HW; out_w/out_h ya calculados como en dsa_top_seq
+static inline coord_tables build_coord_tables_hw(int W, int H, int out_w, int out_h,
+                                                 uint32_t scale_q8_8) {
+    return make_coord_tables<hw_q88_rounding>(W, H, out_w, out_h, scale_q8_8);
+}
+
+// -----------------------------------------------------------------------------
+// Kernel escalar (referencia)
+// -----------------------------------------------------------------------------
+
+// Una fila de salida a partir de sus dos filas de entrada r0 (y0) y r1 (y1).
+// acc maximo = 255*256*256 + 2^15, cabe en int de 32 bits.
+// Solo las columnas [xo_begin, xo_end) (por defecto toda la fila).
+static inline void downscale_u8_row_scalar(const uint8_t *r0, const uint8_t *r1,
+                                           int wy0, int ty_q,
+                                           const coord_tables &t, uint8_t *o,
+                                           int xo_begin = 0, int xo_end = -1) {
+    if (xo_end < 0) xo_end = t.W2;
+    for (int xo = xo_begin; xo < xo_end; ++xo) {
+        const int x0 = t.x0[xo], x1 = t.x1[xo];
+        const int tx_q = t.tx_q[xo], wx0 = t.wx0[xo];
+
+        // mismo acumulador que en Python: I*wx*wy + ...
+        int acc = r0[x0] * wx0 * wy0
+                + r0[x1] * tx_q * wy0
+                + r1[x0] * wx0 * ty_q
+                + r1[x1] * tx_q * ty_q;
+
+        acc = (acc + (1<<15)) >> 16; // redondeo
+        o[xo] = clamp_u8(acc);
+    }
+}
+
+// Scratch que necesitan las filas SIMD: W+1 entradas u16 (W+4 con color)
+// mas relleno para las lecturas de 32 y 128 bits
+static inline size_t simd_scratch_len(int W) {
+    return (size_t)W + 4 + 32;
+}
+
+// -----------------------------------------------------------------------------
+// Kernels SIMD (x86)
+// -----------------------------------------------------------------------------
+//
+// Por fila de salida:
+//  1) pasada vertical contigua: v[x] = r0[x]*wy0 + r1[x]*ty en u16, con
+//     v[W] = v[W-1] para que el vecino derecho del borde sea el mismo píxel;
+//  2) pasada horizontal: se lee una palabra de 32 bits en &v[x0], que trae
+//     v[x0] en la mitad baja y v[x0+1] (== v[x1]) en la alta, y se hace
+//     (lo*wx0 + hi*tx + 2^15) >> 16 en lanes de 32 bits.
+//
+// Con canales intercalados (RGB/RGBA) la pasada vertical es la misma sobre
+// W*chans bytes. En la horizontal los chans canales de x0 y los de x1 estan
+// contiguos en v, asi que una lectura de 128 bits en &v[x0*chans] trae los
+// dos vecinos de todos los canales del píxel, sin gathers; el borde derecho
+// se cubre copiando el ultimo píxel de v una posicion mas alla.
+//
+// La pasada vertical recorre las W columnas de entrada, asi que solo
+// conviene cuando W no es mucho mayor que W2; ademas necesita pesos en
+// [0, 256] para que v quepa en 16 bits (ver simd_row_ok).
+
+#if DSA_HAVE_X86
+
+static inline bool simd_row_ok(int W, const coord_tables &t) {
+    return t.weights_u8 && W <= 4 * t.W2 + 64;
+}
+
+__attribute__((target("sse4.1")))
+static inline void vpass_sse41(const uint8_t *r0, const uint8_t *r1, int W,
+                               int wy0, int ty_q, uint16_t *v) {
+    const __m128i z   = _mm_setzero_si128();
+    const __m128i vw0 = _mm_set1_epi16((short)wy0);
+    const __m128i vt  = _mm_set1_epi16((short)ty_q);
+    int x = 0;
+    for (; x + 16 <= W; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(r0 + x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(r1 + x));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, z), vw0),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(b, z), vt));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, z), vw0),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(b, z), vt));
+        _mm_storeu_si128((__m128i *)(v + x), lo);
+        _mm_storeu_si128((__m128i *)(v + x + 8), hi);
+    }
+    for (; x < W; ++x)
+        v[x] = (uint16_t)(r0[x] * wy0 + r1[x] * ty_q);
+    v[W] = v[W - 1];
+}
+
+static inline uint32_t load_u32(const uint16_t *p) {
+    uint32_t w;
+    std::memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i hpass4_sse41(const uint16_t *v, const coord_tables &t, int xo) {
+    const int *x0 = t.x0.data() + xo;
+    __m128i g = _mm_set_epi32((int)load_u32(v + x0[3]), (int)load_u32(v + x0[2]),
+                              (int)load_u32(v + x0[1]), (int)load_u32(v + x0[0]));
+    __m128i lo = _mm_and_si128(g, _mm_set1_epi32(0xFFFF));
+    __m128i hi = _mm_srli_epi32(g, 16);
+    __m128i w0 = _mm_loadu_si128((const __m128i *)(t.wx0.data() + xo));
+    __m128i tx = _mm_loadu_si128((const __m128i *)(t.tx_q.data() + xo));
+    __m128i acc = _mm_add_epi32(_mm_mullo_epi32(lo, w0), _mm_mullo_epi32(hi, tx));
+    acc = _mm_add_epi32(acc, _mm_set1_epi32(1 << 15));
+    return _mm_srli_epi32(acc, 16);
+}
+
+__attribute__((target("sse4.1")))
+static inline void downscale_u8_row_sse41(const uint8_t *r0, const uint8_t *r1, int W,
+                                          int wy0, int ty_q,
+                                          const coord_tables &t, uint8_t *o,
+                                          uint16_t *v) {
+    vpass_sse41(r0, r1, W, wy0, ty_q, v);
+
+    int xo = 0;
+    for (; xo + 16 <= t.W2; xo += 16) {
+        __m128i a = hpass4_sse41(v, t, xo);
+        __m128i b = hpass4_sse41(v, t, xo + 4);
+        __m128i c = hpass4_sse41(v, t, xo + 8);
+        __m128i d = hpass4_sse41(v, t, xo + 12);
+        // acc <= 255, el empaquetado con saturacion equivale al clamp
+        __m128i p = _mm_packus_epi16(_mm_packus_epi32(a, b), _mm_packus_epi32(c, d));
+        _mm_storeu_si128((__m128i *)(o + xo), p);
+    }
+    for (; xo < t.W2; ++xo) {
+        uint32_t g = load_u32(v + t.x0[xo]);
+        int acc = (int)(g & 0xFFFF) * t.wx0[xo] + (int)(g >> 16) * t.tx_q[xo];
+        o[xo] = clamp_u8((acc + (1<<15)) >> 16);
+    }
+}
+
+__attribute__((target("avx2")))
+static inline void vpass_avx2(const uint8_t *r0, const uint8_t *r1, int W,
+                              int wy0, int ty_q, uint16_t *v) {
+    const __m256i vw0 = _mm256_set1_epi16((short)wy0);
+    const __m256i vt  = _mm256_set1_epi16((short)ty_q);
+    int x = 0;
+    for (; x + 32 <= W; x += 32) {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(r0 + x));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(r0 + x + 16));
+        __m128i b0 = _mm_loadu_si128((const __m128i *)(r1 + x));
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(r1 + x + 16));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(a0), vw0),
+                                      _mm256_mullo_epi16(_mm256_cvtepu8_epi16(b0), vt));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(a1), vw0),
+                                      _mm256_mullo_epi16(_mm256_cvtepu8_epi16(b1), vt));
+        _mm256_storeu_si256((__m256i *)(v + x), lo);
+        _mm256_storeu_si256((__m256i *)(v + x + 16), hi);
+    }
+    for (; x < W; ++x)
+        v[x] = (uint16_t)(r0[x] * wy0 + r1[x] * ty_q);
+    v[W] = v[W - 1];
+}
+
+__attribute__((target("avx2")))
+static inline __m256i hpass8_avx2(const uint16_t *v, const coord_tables &t, int xo) {
+    __m256i idx = _mm256_loadu_si256((const __m256i *)(t.x0.data() + xo));
+    // escala 2: cada indice es un u16; se leen v[x0] y v[x0+1] de una vez
+    __m256i g  = _mm256_i32gather_epi32((const int *)v, idx, 2);
+    __m256i lo = _mm256_and_si256(g, _mm256_set1_epi32(0xFFFF));
+    __m256i hi = _mm256_srli_epi32(g, 16);
+    __m256i w0 = _mm256_loadu_si256((const __m256i *)(t.wx0.data() + xo));
+    __m256i tx = _mm256_loadu_si256((const __m256i *)(t.tx_q.data() + xo));
+    __m256i acc = _mm256_add_epi32(_mm256_mullo_epi32(lo, w0), _mm256_mullo_epi32(hi, tx));
+    acc = _mm256_add_epi32(acc, _mm256_set1_epi32(1 << 15));
+    return _mm256_srli_epi32(acc, 16);
+}
+
+__attribute__((target("avx2")))
+static inline void downscale_u8_row_avx2(const uint8_t *r0, const uint8_t *r1, int W,
+                                         int wy0, int ty_q,
+                                         const coord_tables &t, uint8_t *o,
+                                         uint16_t *v) {
+    // packus trabaja por mitades de 128 bits; esto reordena los 8 dwords
+    const __m256i perm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    vpass_avx2(r0, r1, W, wy0, ty_q, v);
+
+    int xo = 0;
+    for (; xo + 32 <= t.W2; xo += 32) {
+        __m256i a = hpass8_avx2(v, t, xo);
+        __m256i b = hpass8_avx2(v, t, xo + 8);
+        __m256i c = hpass8_avx2(v, t, xo + 16);
+        __m256i d = hpass8_avx2(v, t, xo + 24);
+        __m256i p = _mm256_packus_epi16(_mm256_packus_epi32(a, b),
+                                        _mm256_packus_epi32(c, d));
+        p = _mm256_permutevar8x32_epi32(p, perm);
+        _mm256_storeu_si256((__m256i *)(o + xo), p);
+    }
+    for (; xo < t.W2; ++xo) {
+        uint32_t g = load_u32(v + t.x0[xo]);
+        int acc = (int)(g & 0xFFFF) * t.wx0[xo] + (int)(g >> 16) * t.tx_q[xo];
+        o[xo] = clamp_u8((acc + (1<<15)) >> 16);
+    }
+}
+
+// Canales del píxel de salida con vecinos en v[x0e ..] y v[x0e + C ..]
+// (x0e = x0*C) y pesos del píxel; lanes 0..C-1 validos
+template <int C>
+__attribute__((target("sse4.1")))
+static inline __m128i hpass_px_sse41(const uint16_t *v, int x0e, int wx0, int tx_q) {
+    __m128i q  = _mm_loadu_si128((const __m128i *)(v + x0e));
+    __m128i lo = _mm_cvtepu16_epi32(q);
+    __m128i hi = _mm_cvtepu16_epi32(_mm_srli_si128(q, 2 * C));
+    __m128i acc = _mm_add_epi32(_mm_mullo_epi32(lo, _mm_set1_epi32(wx0)),
+                                _mm_mullo_epi32(hi, _mm_set1_epi32(tx_q)));
+    acc = _mm_add_epi32(acc, _mm_set1_epi32(1 << 15));
+    return _mm_srli_epi32(acc, 16);
+}
+
+// Pasada horizontal de una fila intercalada (t de interleave_tables): 4
+// píxeles por vuelta. Con RGB quedan 12 bytes utiles de 16; los 4 de mas
+// los pisa la vuelta siguiente y nunca se escriben fuera de la fila.
+template <int C>
+__attribute__((target("sse4.1")))
+static inline void hpass_color_sse41(const uint16_t *v, const coord_tables &t, uint8_t *o) {
+    const __m128i rgb = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    int e = 0;   // byte de salida (píxel * C)
+    for (; e + 4 * C <= t.W2 && e + 16 <= t.W2; e += 4 * C) {
+        __m128i p0 = hpass_px_sse41<C>(v, t.x0[e],         t.wx0[e],         t.tx_q[e]);
+        __m128i p1 = hpass_px_sse41<C>(v, t.x0[e + C],     t.wx0[e + C],     t.tx_q[e + C]);
+        __m128i p2 = hpass_px_sse41<C>(v, t.x0[e + 2 * C], t.wx0[e + 2 * C], t.tx_q[e + 2 * C]);
+        __m128i p3 = hpass_px_sse41<C>(v, t.x0[e + 3 * C], t.wx0[e + 3 * C], t.tx_q[e + 3 * C]);
+        __m128i b = _mm_packus_epi16(_mm_packus_epi32(p0, p1), _mm_packus_epi32(p2, p3));
+        if (C == 3) b = _mm_shuffle_epi8(b, rgb);
+        _mm_storeu_si128((__m128i *)(o + e), b);
+    }
+    for (; e < t.W2; ++e) {
+        int acc = v[t.x0[e]] * t.wx0[e] + v[t.x1[e]] * t.tx_q[e];
+        o[e] = clamp_u8((acc + (1<<15)) >> 16);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static inline void hpass_color_sse41(const uint16_t *v, const coord_tables &t, uint8_t *o) {
+    if (t.chans == 3) hpass_color_sse41<3>(v, t, o);
+    else hpass_color_sse41<4>(v, t, o);
+}
+
+// AVX2: dos píxeles por registro de 256 bits, cada uno en 4 lanes (con RGB
+// el cuarto queda en 0). Devuelve los píxeles de los bytes e y e + C.
+template <int C>
+__attribute__((target("avx2")))
+static inline __m256i hpass_px2_avx2(const uint16_t *v, const coord_tables &t, int e) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(v + t.x0[e]));
+    __m128i b = _mm_loadu_si128((const __m128i *)(v + t.x0[e + C]));
+    __m256i w0 = _mm256_loadu_si256((const __m256i *)(t.wx0.data() + e));
+    __m256i tx = _mm256_loadu_si256((const __m256i *)(t.tx_q.data() + e));
+    if (C == 3) {
+        // [c0 c1 c2 n0 n1 n2 . .] -> [c0 c1 c2 0 n0 n1 n2 0] y pesos [A x4, B x4]
+        const __m128i sp = _mm_setr_epi8(0, 1, 2, 3, 4, 5, -1, -1, 6, 7, 8, 9, 10, 11, -1, -1);
+        const __m256i wp = _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3);
+        a = _mm_shuffle_epi8(a, sp);
+        b = _mm_shuffle_epi8(b, sp);
+        w0 = _mm256_permutevar8x32_epi32(w0, wp);
+        tx = _mm256_permutevar8x32_epi32(tx, wp);
+    }
+    __m256i lo = _mm256_cvtepu16_epi32(_mm_unpacklo_epi64(a, b));
+    __m256i hi = _mm256_cvtepu16_epi32(_mm_unpackhi_epi64(a, b));
+    __m256i acc = _mm256_add_epi32(_mm256_mullo_epi32(lo, w0), _mm256_mullo_epi32(hi, tx));
+    acc = _mm256_add_epi32(acc, _mm256_set1_epi32(1 << 15));
+    return _mm256_srli_epi32(acc, 16);
+}
+
+// 8 píxeles por vuelta. Con RGB cada mitad de 128 bits tiene 4 píxeles en
+// 12 bytes utiles; se escriben las dos mitades solapadas (16 bytes en e y
+// en e + 12) sin pasar del final de la fila.
+template <int C>
+__attribute__((target("avx2")))
+static inline void hpass_color_avx2(const uint16_t *v, const coord_tables &t, uint8_t *o) {
+    const __m256i perm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256i rgb = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    int e = 0;
+    for (; e + 8 * C <= t.W2 && e + 12 + 16 <= t.W2; e += 8 * C) {
+        __m256i p01 = hpass_px2_avx2<C>(v, t, e);
+        __m256i p23 = hpass_px2_avx2<C>(v, t, e + 2 * C);
+        __m256i p45 = hpass_px2_avx2<C>(v, t, e + 4 * C);
+        __m256i p67 = hpass_px2_avx2<C>(v, t, e + 6 * C);
+        // packus por mitades: [p0 p2 p4 p6 | p1 p3 p5 p7], perm lo ordena
+        __m256i p = _mm256_packus_epi16(_mm256_packus_epi32(p01, p23),
+                                        _mm256_packus_epi32(p45, p67));
+        p = _mm256_permutevar8x32_epi32(p, perm);
+        if (C == 4) {
+            _mm256_storeu_si256((__m256i *)(o + e), p);
+        } else {
+            p = _mm256_shuffle_epi8(p, rgb);
+            _mm_storeu_si128((__m128i *)(o + e), _mm256_castsi256_si128(p));
+            _mm_storeu_si128((__m128i *)(o + e + 12), _mm256_extracti128_si256(p, 1));
+        }
+    }
+    for (; e < t.W2; ++e) {
+        int acc = v[t.x0[e]] * t.wx0[e] + v[t.x1[e]] * t.tx_q[e];
+        o[e] = clamp_u8((acc + (1<<15)) >> 16);
+    }
+}
+
+__attribute__((target("avx2")))
+static inline void hpass_color_avx2(const uint16_t *v, const coord_tables &t, uint8_t *o) {
+    if (t.chans == 3) hpass_color_avx2<3>(v, t, o);
+    else hpass_color_avx2<4>(v, t, o);
+}
+
+// v[W..W+C-1] = ultimo píxel, para que el vecino derecho del borde sea el
+// mismo (W en bytes, como en vpass)
+static inline void pad_color_edge(uint16_t *v, int W, int chans) {
+    for (int c = 0; c < chans; ++c)
+        v[W + c] = v[W - chans + c];
+}
+
+#endif // DSA_HAVE_X86
+
+// -----------------------------------------------------------------------------
+// Kernels de escala fija (0x40, 0x80, 0xC0, 0x100)
+// -----------------------------------------------------------------------------
+//
+// Con un patron periodico (fixed_pattern) los vecinos y pesos horizontales
+// son constantes de compilacion, asi que no hacen falta tablas ni gathers:
+// por cada bloque de N salidas (G periodos, N = G*P <= 8) se carga 16 bytes
+// de cada fila de entrada y con pshufb se arman I(x0) e I(x1) ya en u16.
+// El orden de la suma cambia (primero horizontal y despues vertical) pero
+// el acumulador es el mismo entero:
+//   h(y)  = I(x0,y)*wx0 + I(x1,y)*tx          (u16, <= 65280)
+//   acc   = h(y0)*wy0 + h(y1)*ty              (32 bits)
+// AVX2 hace dos bloques por iteracion, uno en cada mitad de 128 bits.
+// Con 0x100 el patron es la identidad y, si ty == 0, la fila es un memcpy.
+// Con 0x80 y 0x40 (pair_avg) y ty == 128 la fila es un promedio 2x2 exacto.
+
+template <class R, uint32_t ScaleQ>
+struct fixed_kernel {
+    using pat = fixed_pattern<R, ScaleQ>;
+    static constexpr int P = pat::P, Q = pat::Q;
+
+    static constexpr int max_dx() {
+        int m = 0;
+        for (int j = 0; j < P; ++j) m = std::max(m, pat::ph.dx[j]);
+        return m;
+    }
+    // periodos por bloque: N <= 8 salidas y todos los x1 dentro de 16 bytes
+    static constexpr int groups() {
+        int g = 0;
+        while (P * (g + 1) <= 8 && Q * g + max_dx() + 1 <= 15) ++g;
+        return g;
+    }
+    static constexpr int G = groups();
+    static constexpr int N = G * P;    // salidas por bloque
+    static constexpr int STEP = G * Q; // entradas por bloque
+    static_assert(!pat::periodic || G >= 1, "periodo demasiado largo para un bloque");
+
+    static constexpr int dx(int j) { return (j / P) * Q + pat::ph.dx[j % P]; }
+    static constexpr int tq(int j) { return pat::ph.tq[j % P]; }
+
+    struct consts {
+        alignas(16) uint8_t m0[16], m1[16];   // pshufb: byte de x0 / x1 en cada u16
+        alignas(16) uint16_t w0[8], tx[8];
+    };
+    static constexpr consts make_consts() {
+        consts c{};
+        for (int j = 0; j < 8; ++j) {
+            bool on = j < N;
+            c.m0[2 * j] = on ? (uint8_t)dx(j) : 0x80;
+            c.m1[2 * j] = on ? (uint8_t)(dx(j) + 1) : 0x80;
+            c.m0[2 * j + 1] = c.m1[2 * j + 1] = 0x80;
+            c.w0[j] = on ? (uint16_t)(256 - tq(j)) : 0;
+            c.tx[j] = on ? (uint16_t)tq(j) : 0;
+        }
+        return c;
+    }
+    static constexpr consts k = make_consts();
+
+    // Cuantas columnas desde 0 siguen el patron (multiplo de N), con las
+    // lecturas de 16 bytes y las escrituras de 8 dentro de la fila
+    static int valid_columns(const coord_tables &t, int W) {
+        int xo = 0;
+        for (; xo + 8 <= t.W2; xo += N) {
+            const int xi = (xo / N) * STEP;
+            if (xi + 16 > W) break;
+            bool ok = true;
+            for (int j = 0; j < N && ok; ++j)
+                ok = t.x0[xo + j] == xi + dx(j) && t.x1[xo + j] == xi + dx(j) + 1 &&
+                     t.tx_q[xo + j] == tq(j);
+            if (!ok) break;
+        }
+        return xo;
+    }
+
+#if DSA_HAVE_X86
+    __attribute__((target("sse4.1")))
+    static inline __m128i hpass_sse41(__m128i a) {
+        const __m128i x0 = _mm_shuffle_epi8(a, _mm_load_si128((const __m128i *)k.m0));
+        const __m128i x1 = _mm_shuffle_epi8(a, _mm_load_si128((const __m128i *)k.m1));
+        return _mm_add_epi16(_mm_mullo_epi16(x0, _mm_load_si128((const __m128i *)k.w0)),
+                             _mm_mullo_epi16(x1, _mm_load_si128((const __m128i *)k.tx)));
+    }
+
+    __attribute__((target("sse4.1")))
+    static inline __m128i vpass_sse41(__m128i h0, __m128i h1, __m128i wy, __m128i ty) {
+        const __m128i a_lo = _mm_mullo_epi16(h0, wy), a_hi = _mm_mulhi_epu16(h0, wy);
+        const __m128i b_lo = _mm_mullo_epi16(h1, ty), b_hi = _mm_mulhi_epu16(h1, ty);
+        const __m128i rnd = _mm_set1_epi32(1 << 15);
+        __m128i lo = _mm_add_epi32(_mm_unpacklo_epi16(a_lo, a_hi), _mm_unpacklo_epi16(b_lo, b_hi));
+        __m128i hi = _mm_add_epi32(_mm_unpackhi_epi16(a_lo, a_hi), _mm_unpackhi_epi16(b_lo, b_hi));
+        lo = _mm_srli_epi32(_mm_add_epi32(lo, rnd), 16);
+        hi = _mm_srli_epi32(_mm_add_epi32(hi, rnd), 16);
+        __m128i p = _mm_packus_epi32(lo, hi);
+        return _mm_packus_epi16(p, p);
+    }
+
+    // Promedio 2x2 (pat::pair_avg con wy0 = ty = 128): el acumulador es
+    //   (a+b+c+d)*128*128 + 2^15  ->  (a+b+c+d + 2) >> 2
+    // y no hacen falta multiplicaciones de 16 bits: maddubs contra unos suma
+    // los pares de bytes de cada fila. Con 4:1 solo cuenta un par de cada
+    // cuatro bytes (mascara 1,1,0,0), que queda como u32 y se compacta con
+    // packus. r0/r1 apuntan a la entrada Q*xo + dx de la primera salida.
+    static constexpr int AVG_D = pat::ph.dx[0];
+
+    __attribute__((target("sse4.1")))
+    static inline __m128i avg16_sse41(const uint8_t *r0, const uint8_t *r1) {
+        __m128i lo, hi;
+        if constexpr (Q == 2) {
+            const __m128i ones = _mm_set1_epi8(1);
+            lo = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)r0), ones),
+                               _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)r1), ones));
+            hi = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(r0 + 16)), ones),
+                               _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(r1 + 16)), ones));
+        } else {
+            const __m128i ones = _mm_set1_epi32(0x0101);
+            __m128i p[4];
+            for (int k = 0; k < 4; ++k)
+                p[k] = _mm_add_epi32(
+                    _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(r0 + 16 * k)), ones),
+                    _mm_maddubs_epi16(_mm_loadu_si128((const __m128i *)(r1 + 16 * k)), ones));
+            lo = _mm_packus_epi32(p[0], p[1]);
+            hi = _mm_packus_epi32(p[2], p[3]);
+        }
+        const __m128i two = _mm_set1_epi16(2);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+        return _mm_packus_epi16(lo, hi);
+    }
+
+    // Bloques de 16 salidas desde xo y el ultimo solapado hacia atras (pisa
+    // con los mismos valores); las lecturas no pasan de Q*xo_end, que
+    // valid_columns ya dejo dentro de la fila. Necesita xo_end >= 16.
+    __attribute__((target("sse4.1")))
+    static void avg_row_sse41(const uint8_t *r0, const uint8_t *r1, uint8_t *o,
+                              int xo, int xo_end) {
+        for (;; xo += 16) {
+            if (xo + 16 > xo_end) {
+                if (xo == xo_end) return;
+                xo = xo_end - 16;
+            }
+            const int xi = Q * xo + AVG_D;
+            _mm_storeu_si128((__m128i *)(o + xo), avg16_sse41(r0 + xi, r1 + xi));
+            if (xo + 16 == xo_end) return;
+        }
+    }
+
+    // Promedio 2x2 con C canales intercalados: la salida xo lee los bytes de
+    // los píxeles Q*xo + AVG_D y el siguiente, 2C bytes seguidos. Cada
+    // registro junta los de dos salidas (a 2C bytes con 2:1, a 8 con 4:1) y
+    // pshufb deja cada canal al lado de su vecino, asi maddubs suma los
+    // pares como en avg16_sse41. Las lecturas son de 16 bytes (dos de 8 con
+    // 4:1) y pueden pasar de los 2C utiles, asi que el lazo vectorial para
+    // antes del ultimo píxel de entrada que lee el patron y el resto va
+    // escalar.
+    template <int C>
+    struct color_consts {
+        alignas(16) int8_t pair[16];   // lane u16 k*C + c <- bytes c y C + c del span k
+        alignas(16) int8_t pack[16];   // C == 3: junta 6 + 6 bytes de packus
+    };
+    template <int C>
+    static constexpr color_consts<C> make_color_consts() {
+        color_consts<C> c{};
+        const int span = Q == 2 ? 2 * C : 8;   // distancia entre los spans del registro
+        for (int i = 0; i < 16; ++i) c.pair[i] = c.pack[i] = -1;
+        for (int k = 0; k < 2; ++k)
+            for (int ch = 0; ch < C; ++ch) {
+                c.pair[2 * (k * C + ch)] = (int8_t)(span * k + ch);
+                c.pair[2 * (k * C + ch) + 1] = (int8_t)(span * k + C + ch);
+            }
+        for (int i = 0; i < 2 * C; ++i) {
+            c.pack[i] = (int8_t)i;
+            c.pack[2 * C + i] = (int8_t)(8 + i);
+        }
+        return c;
+    }
+    template <int C>
+    static constexpr color_consts<C> ck = make_color_consts<C>();
+
+    // Bytes que lee load_spans desde el span de xo
+    template <int C>
+    static constexpr int color_read() { return Q == 2 ? 16 : Q * C + 8; }
+    template <int C>
+    static constexpr int color_at(int xo) { return (Q * xo + AVG_D) * C; }
+
+    // Spans de las salidas xo y xo+1
+    template <int C>
+    __attribute__((target("sse4.1")))
+    static inline __m128i load_spans(const uint8_t *r, int xo) {
+        const uint8_t *p = r + color_at<C>(xo);
+        if constexpr (Q == 2)
+            return _mm_loadu_si128((const __m128i *)p);
+        else
+            return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)p),
+                                      _mm_loadl_epi64((const __m128i *)(p + Q * C)));
+    }
+
+    // Sumas de los 4 bytes (u16) de cada canal de las salidas xo y xo+1
+    template <int C>
+    __attribute__((target("sse4.1")))
+    static inline __m128i color_sums_sse41(const uint8_t *r0, const uint8_t *r1, int xo) {
+        const __m128i m = _mm_load_si128((const __m128i *)ck<C>.pair);
+        const __m128i ones = _mm_set1_epi8(1);
+        return _mm_add_epi16(_mm_maddubs_epi16(_mm_shuffle_epi8(load_spans<C>(r0, xo), m), ones),
+                             _mm_maddubs_epi16(_mm_shuffle_epi8(load_spans<C>(r1, xo), m), ones));
+    }
+
+    // Salidas [xo, n) desde xo: de a 4 mientras las lecturas no pasen del
+    // ultimo byte que lee el patron, y el resto escalar
+    template <int C>
+    __attribute__((target("sse4.1")))
+    static void avg_color_from_sse41(const uint8_t *r0, const uint8_t *r1, uint8_t *o,
+                                     int xo, int n) {
+        const int limit = color_at<C>(n - 1) + 2 * C;
+        const __m128i two = _mm_set1_epi16(2);
+        for (; xo + 4 <= n && color_at<C>(xo + 2) + color_read<C>() <= limit; xo += 4) {
+            __m128i a = _mm_srli_epi16(_mm_add_epi16(color_sums_sse41<C>(r0, r1, xo), two), 2);
+            __m128i b = _mm_srli_epi16(_mm_add_epi16(color_sums_sse41<C>(r0, r1, xo + 2), two), 2);
+            __m128i p = _mm_packus_epi16(a, b);
+            uint8_t *d = o + xo * C;
+            if constexpr (C == 4) {
+                _mm_storeu_si128((__m128i *)d, p);
+            } else {
+                p = _mm_shuffle_epi8(p, _mm_load_si128((const __m128i *)ck<C>.pack));
+                _mm_storel_epi64((__m128i *)d, p);
+                const int w = _mm_extract_epi32(p, 2);
+                std::memcpy(d + 8, &w, 4);
+            }
+        }
+        for (; xo < n; ++xo)
+            for (int c = 0; c < C; ++c) {
+                const int i = color_at<C>(xo) + c;
+                o[xo * C + c] = (uint8_t)((r0[i] + r0[i + C] + r1[i] + r1[i + C] + 2) >> 2);
+            }
+    }
+
+    template <int C>
+    __attribute__((target("sse4.1")))
+    static void avg_color_sse41(const uint8_t *r0, const uint8_t *r1,
+                                int, int, uint8_t *o, int xo_end) {
+        avg_color_from_sse41<C>(r0, r1, o, 0, xo_end / C);
+    }
+
+    __attribute__((target("sse4.1")))
+    static void row_sse41(const uint8_t *r0, const uint8_t *r1,
+                          int wy0, int ty_q, uint8_t *o, int xo_end) {
+        if (pat::identity && ty_q == 0) {
+            std::memcpy(o, r0, xo_end);
+            return;
+        }
+        if constexpr (pat::pair_avg) {
+            if (wy0 == 128 && ty_q == 128 && xo_end >= 16) {
+                avg_row_sse41(r0, r1, o, 0, xo_end);
+                return;
+            }
+        }
+        const __m128i wy = _mm_set1_epi16((short)wy0), ty = _mm_set1_epi16((short)ty_q);
+        for (int xo = 0, xi = 0; xo < xo_end; xo += N, xi += STEP) {
+            __m128i h0 = hpass_sse41(_mm_loadu_si128((const __m128i *)(r0 + xi)));
+            __m128i h1 = hpass_sse41(_mm_loadu_si128((const __m128i *)(r1 + xi)));
+            _mm_storel_epi64((__m128i *)(o + xo), vpass_sse41(h0, h1, wy, ty));
+        }
+    }
+
+    __attribute__((target("avx2")))
+    static inline __m256i load2(const uint8_t *p) {
+        return _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+            _mm_loadu_si128((const __m128i *)(p + STEP)), 1);
+    }
+
+    __attribute__((target("avx2")))
+    static inline __m256i hpass_avx2(__m256i a) {
+        const __m256i x0 = _mm256_shuffle_epi8(a, _mm256_broadcastsi128_si256(
+                                                      _mm_load_si128((const __m128i *)k.m0)));
+        const __m256i x1 = _mm256_shuffle_epi8(a, _mm256_broadcastsi128_si256(
+                                                      _mm_load_si128((const __m128i *)k.m1)));
+        const __m256i w0 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)k.w0));
+        const __m256i tx = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)k.tx));
+        return _mm256_add_epi16(_mm256_mullo_epi16(x0, w0), _mm256_mullo_epi16(x1, tx));
+    }
+
+    // 32 salidas por vuelta; packus trabaja por mitades de 128 bits, asi
+    // que al final se reordena (qwords 0,2,1,3 con 2:1, dwords con 4:1)
+    __attribute__((target("avx2")))
+    static inline __m256i avg32_avx2(const uint8_t *r0, const uint8_t *r1) {
+        __m256i lo, hi;
+        if constexpr (Q == 2) {
+            const __m256i ones = _mm256_set1_epi8(1);
+            lo = _mm256_add_epi16(
+                _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)r0), ones),
+                _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)r1), ones));
+            hi = _mm256_add_epi16(
+                _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(r0 + 32)), ones),
+                _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(r1 + 32)), ones));
+        } else {
+            const __m256i ones = _mm256_set1_epi32(0x0101);
+            __m256i p[4];
+            for (int k = 0; k < 4; ++k)
+                p[k] = _mm256_add_epi32(
+                    _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(r0 + 32 * k)), ones),
+                    _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(r1 + 32 * k)), ones));
+            lo = _mm256_packus_epi32(p[0], p[1]);
+            hi = _mm256_packus_epi32(p[2], p[3]);
+        }
+        const __m256i two = _mm256_set1_epi16(2);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, two), 2);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2);
+        const __m256i p = _mm256_packus_epi16(lo, hi);
+        if constexpr (Q == 2)
+            return _mm256_permute4x64_epi64(p, 0xD8);
+        else
+            return _mm256_permutevar8x32_epi32(p, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+    }
+
+    // AVX2: spans de xo, xo+1 en la mitad baja y de xo+2, xo+3 en la alta.
+    // Con 2:1 son 4C bytes seguidos: una lectura de 32 (con RGB el permute
+    // lleva los bytes 12..27 a la mitad alta).
+    template <int C>
+    static constexpr int color_read4() { return Q == 2 ? 32 : 2 * Q * C + color_read<C>(); }
+
+    template <int C>
+    __attribute__((target("avx2")))
+    static inline __m256i load_spans4(const uint8_t *r, int xo) {
+        if constexpr (Q == 2) {
+            const __m256i a = _mm256_loadu_si256((const __m256i *)(r + color_at<C>(xo)));
+            if constexpr (C == 4) return a;
+            else return _mm256_permutevar8x32_epi32(a, _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6));
+        } else {
+            return _mm256_inserti128_si256(_mm256_castsi128_si256(load_spans<C>(r, xo)),
+                                           load_spans<C>(r, xo + 2), 1);
+        }
+    }
+
+    template <int C>
+    __attribute__((target("avx2")))
+    static inline __m256i color_sums_avx2(const uint8_t *r0, const uint8_t *r1, int xo) {
+        const __m256i m = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)ck<C>.pair));
+        const __m256i ones = _mm256_set1_epi8(1);
+        const __m256i a = load_spans4<C>(r0, xo);
+        const __m256i b = load_spans4<C>(r1, xo);
+        return _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_shuffle_epi8(a, m), ones),
+                                _mm256_maddubs_epi16(_mm256_shuffle_epi8(b, m), ones));
+    }
+
+    // 8 salidas por vuelta; packus deja los pares de salidas en qwords
+    // 0,2,1,3 y el permute los ordena. Con RGB cada qword trae 6 bytes
+    // utiles y cada mitad se compacta a 12.
+    template <int C>
+    __attribute__((target("avx2")))
+    static void avg_color_avx2(const uint8_t *r0, const uint8_t *r1,
+                               int, int, uint8_t *o, int xo_end) {
+        const int n = xo_end / C;
+        const int limit = color_at<C>(n - 1) + 2 * C;
+        const __m256i two = _mm256_set1_epi16(2);
+        int xo = 0;
+        for (; xo + 8 <= n && color_at<C>(xo + 4) + color_read4<C>() <= limit; xo += 8) {
+            __m256i a = _mm256_srli_epi16(_mm256_add_epi16(color_sums_avx2<C>(r0, r1, xo), two), 2);
+            __m256i b = _mm256_srli_epi16(_mm256_add_epi16(color_sums_avx2<C>(r0, r1, xo + 4), two), 2);
+            __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+            uint8_t *d = o + xo * C;
+            if constexpr (C == 4) {
+                _mm256_storeu_si256((__m256i *)d, p);
+            } else {
+                p = _mm256_shuffle_epi8(p, _mm256_broadcastsi128_si256(
+                                               _mm_load_si128((const __m128i *)ck<C>.pack)));
+                const __m128i lo = _mm256_castsi256_si128(p), hi = _mm256_extracti128_si256(p, 1);
+                int w;
+                _mm_storel_epi64((__m128i *)d, lo);
+                w = _mm_extract_epi32(lo, 2);
+                std::memcpy(d + 8, &w, 4);
+                _mm_storel_epi64((__m128i *)(d + 12), hi);
+                w = _mm_extract_epi32(hi, 2);
+                std::memcpy(d + 20, &w, 4);
+            }
+        }
+        avg_color_from_sse41<C>(r0, r1, o, xo, n);
+    }
+
+    __attribute__((target("avx2")))
+    static void row_avx2(const uint8_t *r0, const uint8_t *r1,
+                         int wy0, int ty_q, uint8_t *o, int xo_end) {
+        if (pat::identity && ty_q == 0) {
+            std::memcpy(o, r0, xo_end);
+            return;
+        }
+        if constexpr (pat::pair_avg) {
+            if (wy0 == 128 && ty_q == 128 && xo_end >= 16) {
+                int xo = 0;
+                for (; xo + 32 <= xo_end; xo += 32) {
+                    const int xi = Q * xo + AVG_D;
+                    _mm256_storeu_si256((__m256i *)(o + xo), avg32_avx2(r0 + xi, r1 + xi));
+                }
+                // el resto (o el ultimo bloque solapado) con SSE
+                if (xo < xo_end) avg_row_sse41(r0, r1, o, xo_end - xo >= 16 ? xo : xo_end - 16, xo_end);
+                return;
+            }
+        }
+        const __m256i wy = _mm256_set1_epi16((short)wy0), ty = _mm256_set1_epi16((short)ty_q);
+        const __m256i rnd = _mm256_set1_epi32(1 << 15);
+        int xo = 0, xi = 0;
+        // dos bloques por vuelta (xo_end es multiplo de N y cada bloque por
+        // debajo ya se valido con sus lecturas y escrituras)
+        for (; xo + 2 * N <= xo_end; xo += 2 * N, xi += 2 * STEP) {
+            __m256i h0 = hpass_avx2(load2(r0 + xi));
+            __m256i h1 = hpass_avx2(load2(r1 + xi));
+            const __m256i a_lo = _mm256_mullo_epi16(h0, wy), a_hi = _mm256_mulhi_epu16(h0, wy);
+            const __m256i b_lo = _mm256_mullo_epi16(h1, ty), b_hi = _mm256_mulhi_epu16(h1, ty);
+            __m256i lo = _mm256_add_epi32(_mm256_unpacklo_epi16(a_lo, a_hi),
+                                          _mm256_unpacklo_epi16(b_lo, b_hi));
+            __m256i hi = _mm256_add_epi32(_mm256_unpackhi_epi16(a_lo, a_hi),
+                                          _mm256_unpackhi_epi16(b_lo, b_hi));
+            lo = _mm256_srli_epi32(_mm256_add_epi32(lo, rnd), 16);
+            hi = _mm256_srli_epi32(_mm256_add_epi32(hi, rnd), 16);
+            __m256i p = _mm256_packus_epi32(lo, hi);
+            p = _mm256_packus_epi16(p, p);
+            // cada mitad trae sus N bytes al principio; la segunda pisa el
+            // sobrante de la primera
+            _mm_storel_epi64((__m128i *)(o + xo), _mm256_castsi256_si128(p));
+            _mm_storel_epi64((__m128i *)(o + xo + N), _mm256_extracti128_si256(p, 1));
+        }
+        if (xo < xo_end) {
+            const __m128i wy1 = _mm_set1_epi16((short)wy0), ty1 = _mm_set1_epi16((short)ty_q);
+            for (; xo < xo_end; xo += N, xi += STEP) {
+                __m128i h0 = hpass_sse41(_mm_loadu_si128((const __m128i *)(r0 + xi)));
+                __m128i h1 = hpass_sse41(_mm_loadu_si128((const __m128i *)(r1 + xi)));
+                _mm_storel_epi64((__m128i *)(o + xo), vpass_sse41(h0, h1, wy1, ty1));
+            }
+        }
+    }
+
+    static const fixed_row_kernels *kernels() {
+        static const fixed_row_kernels kk = [] {
+            fixed_row_kernels k{R::name, &row_sse41, &row_avx2, {}, {}};
+            if constexpr (pat::pair_avg) {
+                k.color_sse41[0] = &avg_color_sse41<3>;
+                k.color_sse41[1] = &avg_color_sse41<4>;
+                k.color_avx2[0] = &avg_color_avx2<3>;
+                k.color_avx2[1] = &avg_color_avx2<4>;
+            }
+            return k;
+        }();
+        return &kk;
+    }
+#else
+    static const fixed_row_kernels *kernels() { return nullptr; }
+#endif
+};
+
+template <class R, uint32_t ScaleQ>
+static inline void try_attach_fixed(coord_tables &t, int W) {
+    if constexpr (fixed_pattern<R, ScaleQ>::periodic) {
+        using fk = fixed_kernel<R, ScaleQ>;
+        if (!t.weights_u8) return;
+        const int n = fk::valid_columns(t, W);
+        if (n > 0 && fk::kernels()) {
+            t.fixed = fk::kernels();
+            t.fx_end = n;
+        }
+    } else {
+        (void)t; (void)W;   // sin patron (ej. HW a 0xC0): queda el generico
+    }
+}
+
+template <class R>
+static inline void attach_fixed_kernel(coord_tables &t, int W, typename R::scale_type scale) {
+    uint32_t q = 0;
+    if (!R::to_q8_8(scale, q)) return;
+    switch (q) {
+        case 0x40:  try_attach_fixed<R, 0x40>(t, W);  break;
+        case 0x80:  try_attach_fixed<R, 0x80>(t, W);  break;
+        case 0xC0:  try_attach_fixed<R, 0xC0>(t, W);  break;
+        case 0x100: try_attach_fixed<R, 0x100>(t, W); break;
+        default: break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Despacho en tiempo de ejecucion
+// -----------------------------------------------------------------------------
+
+enum class simd_level { scalar = 0, sse41 = 1, avx2 = 2 };
+
+static inline const char *simd_level_name(simd_level l) {
+    switch (l) {
+        case simd_level::avx2:  return "avx2";
+        case simd_level::sse41: return "sse4.1";
+        default:                return "escalar";
+    }
+}
+
+// Mejor nivel soportado por la CPU (CPUID via __builtin_cpu_supports)
+static inline simd_level detect_simd_level() {
+#if DSA_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))   return simd_level::avx2;
+    if (__builtin_cpu_supports("sse4.1")) return simd_level::sse41;
+#endif
+    return simd_level::scalar;
+}
+
+// Nivel por defecto: el detectado, limitado por DSA_SIMD=escalar|sse4.1|avx2
+// (sirve para comparar las versiones en la misma maquina).
+static inline simd_level default_simd_level() {
+    static const simd_level lvl = [] {
+        simd_level l = detect_simd_level();
+        const char *env = std::getenv("DSA_SIMD");
+        if (env) {
+            std::string e = env;
+            simd_level want = l;
+            if (e == "escalar" || e == "scalar") want = simd_level::scalar;
+            else if (e == "sse4.1" || e == "sse41") want = simd_level::sse41;
+            else if (e == "avx2") want = simd_level::avx2;
+            if (want < l) l = want;
+        }
+        return l;
+    }();
+    return lvl;
+}
+
+// Una fila de salida con el kernel elegido. v es scratch del que llama,
+// de simd_scratch_len(W) entradas (no se usa en el kernel escalar).
+static inline void downscale_u8_row(const uint8_t *r0, const uint8_t *r1, int W,
+                                    int wy0, int ty_q,
+                                    const coord_tables &t, uint8_t *o,
+                                    simd_level lvl, uint16_t *v) {
+#if DSA_HAVE_X86
+    if (lvl != simd_level::scalar && t.fixed && t.chans > 1 && wy0 == 128 && ty_q == 128) {
+        const int c = t.chans == 3 ? 0 : 1;
+        (lvl == simd_level::avx2 ? t.fixed->color_avx2[c] : t.fixed->color_sse41[c])(
+            r0, r1, wy0, ty_q, o, t.fx_end);
+        downscale_u8_row_scalar(r0, r1, wy0, ty_q, t, o, t.fx_end, t.W2);
+        return;
+    }
+    if (lvl != simd_level::scalar && t.chans > 1 && (t.chans == 3 || t.chans == 4) &&
+        simd_row_ok(W, t)) {
+        if (lvl == simd_level::avx2) {
+            vpass_avx2(r0, r1, W, wy0, ty_q, v);
+            pad_color_edge(v, W, t.chans);
+            hpass_color_avx2(v, t, o);
+        } else {
+            vpass_sse41(r0, r1, W, wy0, ty_q, v);
+            pad_color_edge(v, W, t.chans);
+            hpass_color_sse41(v, t, o);
+        }
+        return;
+    }
+    if (lvl != simd_level::scalar && t.fixed && t.chans == 1) {
+        (lvl == simd_level::avx2 ? t.fixed->avx2 : t.fixed->sse41)(r0, r1, wy0, ty_q, o, t.fx_end);
+        downscale_u8_row_scalar(r0, r1, wy0, ty_q, t, o, t.fx_end, t.W2);
+        return;
+    }
+    if (lvl != simd_level::scalar && simd_row_ok(W, t)) {
+        if (lvl == simd_level::avx2)
+            downscale_u8_row_avx2(r0, r1, W, wy0, ty_q, t, o, v);
+        else
+            downscale_u8_row_sse41(r0, r1, W, wy0, ty_q, t, o, v);
+        return;
+    }
+#endif
+    (void)lvl; (void)v; (void)W;
+    downscale_u8_row_scalar(r0, r1, wy0, ty_q, t, o);
+}
+
+// Calcula las filas de salida [yo_begin, yo_end) con el kernel elegido.
+// v es scratch de simd_scratch_len(W) entradas, como en downscale_u8_row.
+static inline void downscale_u8_rows(const uint8_t *img, int W,
+                                     const coord_tables &t, uint8_t *out,
+                                     int yo_begin, int yo_end,
+                                     simd_level lvl, uint16_t *v) {
+    for (int yo = yo_begin; yo < yo_end; ++yo) {
+        downscale_u8_row(img + (size_t)t.y0[yo] * W, img + (size_t)t.y1[yo] * W, W,
+                         t.wy0[yo], t.ty_q[yo], t, out + (size_t)yo * t.W2, lvl, v);
+    }
+}
+
+// Igual, con scratch propio (una reserva por llamada)
+static inline void downscale_u8_rows(const uint8_t *img, int W,
+                                     const coord_tables &t, uint8_t *out,
+                                     int yo_begin, int yo_end,
+                                     simd_level lvl = default_simd_level()) {
+    std::vector<uint16_t> v(simd_scratch_len(W));
+    downscale_u8_rows(img, W, t, out, yo_begin, yo_end, lvl, v.data());
+}
+
+// Imagen completa: W x H -> t.W2 x t.H2
+static inline void downscale_u8(const uint8_t *img, int W,
+                                const coord_tables &t, uint8_t *out,
+                                simd_level lvl = default_simd_level()) {
+    downscale_u8_rows(img, W, t, out, 0, t.H2, lvl);
+}
@@ -0,0 +1,76 @@
+// model/downscale_parallel.h
+// Motor por bandas de filas: reparte las filas de salida en bandas y las
+// corre sobre un thread_pool. Cada banda escribe solo sus filas, asi que la
+// salida es la misma (byte a byte) con cualquier numero de hilos.
+// Con un perf_probe (model/perf_counters.h) cada banda se mide con los
+// contadores de la CPU; sin probe no cambia nada.
+
+#pragma once
+
+#include "downscale_kernels.h"
+#include "perf_counters.h"
+#include "thread_pool.h"
+
+// Unas 4 bandas por hilo para que el robo de trabajo compense filas
+// desiguales; como minimo 8 filas por banda para no fragmentar de mas.
+static inline int band_rows_for(int H2, unsigned n_threads) {
+    int n_bands = std::max(1, (int)n_threads * 4);
+    int rows = (H2 + n_bands - 1) / n_bands;
+    return std::max(8, rows);
+}
+
+// Pixeles de salida de las filas [yo_begin, yo_end) y bytes que mueven: las
+// filas de entrada distintas que leen (enteras, W bytes cada una; con
+// escala < 0.5 se saltean filas) mas la salida. Solo se llama con probe.
+static inline perf_traffic bilinear_band_traffic(const coord_tables &t, int W,
+                                                 int yo_begin, int yo_end) {
+    perf_traffic tr;
+    if (yo_end <= yo_begin) return tr;
+    uint64_t rows = 0;
+    int last = -1;   // y0/y1 no bajan de una fila de salida a la siguiente
+    for (int yo = yo_begin; yo < yo_end; ++yo) {
+        if (t.y0[yo] > last) ++rows;
+        if (t.y1[yo] > t.y0[yo] && t.y1[yo] > last) ++rows;
+        last = std::max(last, t.y1[yo]);
+    }
+    tr.pixels = (uint64_t)(yo_end - yo_begin) * (t.W2 / t.chans);
+    tr.bytes = rows * W + (uint64_t)(yo_end - yo_begin) * t.W2;
+    return tr;
+}
+
+static inline void downscale_u8_bands(const uint8_t *img, int W,
+                                      const coord_tables &t, uint8_t *out,
+                                      thread_pool &pool,
+                                      simd_level lvl = default_simd_level(),
+                                      perf_probe *probe = nullptr) {
+    const int rows = band_rows_for(t.H2, pool.size());
+    const int n_bands = (t.H2 + rows - 1) / rows;
+    pool.parallel_for(n_bands, [&](int b) {
+        int yo_begin = b * rows;
+        int yo_end = std::min(t.H2, yo_begin + rows);
+        perf_band_scope ps(probe, yo_begin, yo_end,
+                           probe ? bilinear_band_traffic(t, W, yo_begin, yo_end) : perf_traffic());
+        downscale_u8_rows(img, W, t, out, yo_begin, yo_end, lvl);
+    });
+}
+
+// Modelo de referencia en C++ con la misma logica que el Python (Q8.8 y Q10.8)
+// Con pool, las filas de salida se reparten en bandas entre los hilos; sin
+// pool, con probe, la imagen entera cuenta como una banda.
+static inline std::vector<uint8_t> downscale_bilinear_u8_cpp(
+        const std::vector<uint8_t> &img, int W, int H,
+        double scale, int &W2, int &H2, thread_pool *pool = nullptr,
+        perf_probe *probe = nullptr) {
+
+    coord_tables t = build_coord_tables(W, H, scale);
+    W2 = t.W2;
+    H2 = t.H2;
+    std::vector<uint8_t> out(W2 * H2, 0);
+    if (pool) {
+        downscale_u8_bands(img.data(), W, t, out.data(), *pool, default_simd_level(), probe);
+    } else {
+        perf_band_scope ps(probe, 0, H2, probe ? bilinear_band_traffic(t, W, 0, H2) : perf_traffic());
+        downscale_u8(img.data(), W, t, out.data());
+    }
+    return out;
+}
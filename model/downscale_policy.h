@@ -0,0 +1,167 @@
+// model/downscale_policy.h
+// Politicas de redondeo para las coordenadas del bilineal.
+//
+// Hay dos semanticas y las dos se usan:
+//  - golden_rounding: la del modelo Python y downscale_ref_cpp. La escala es
+//    un double, xs = (o+0.5)/scale - 0.5 y t_q = min(255, round(t*256)).
+//  - hw_q88_rounding: la del core en RTL (dsa_top_seq + bilinear_core_*).
+//    La escala es Q8.8, inv_scale_q = 65536/scale y todo es entero.
+//
+// Cada politica da la coordenada de una muestra de salida (con el clamp de
+// bordes) como funcion constexpr. La misma funcion llena las tablas en
+// tiempo de ejecucion y arma en compilacion los patrones de las escalas fijas
+// (fixed_pattern), asi que no hay dos copias de la formula.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+struct axis_coord {
+    int i0, i1, t_q;   // vecinos y fraccion Q8.8 (w0 = 256 - t_q)
+};
+
+// floor/round de double en constexpr (std::floor/std::round no lo son en
+// C++17). Dan lo mismo que las de <cmath> en el rango de las coordenadas:
+// x - floor(x) es exacto en double, asi que no hay doble redondeo.
+constexpr long long cx_floor(double x) {
+    long long i = (long long)x;
+    return (x < (double)i) ? i - 1 : i;
+}
+
+constexpr long long cx_round(double x) {   // mitad lejos de cero, como std::round
+    if (x < 0) return -cx_round(-x);
+    long long i = cx_floor(x);
+    return (x - (double)i >= 0.5) ? i + 1 : i;
+}
+
+struct golden_rounding {
+    using scale_type = double;
+    static constexpr const char *name = "golden";
+
+    static constexpr scale_type from_q8_8(uint32_t q) { return q / 256.0; }
+
+    // true y q si la escala es exactamente q/256
+    static constexpr bool to_q8_8(scale_type s, uint32_t &q) {
+        double x = s * 256.0;
+        if (!(x >= 1.0 && x <= 65535.0) || x != (double)cx_floor(x)) return false;
+        q = (uint32_t)x;
+        return true;
+    }
+
+    static constexpr axis_coord coord(int o, int n_in, scale_type scale) {
+        double s = ((double)o + 0.5) / scale - 0.5;
+        long long a = cx_floor(s);
+        if (a < 0) a = 0;
+        if (a > n_in - 1) a = n_in - 1;
+        int b = (a + 1 < n_in) ? (int)a + 1 : (int)a;
+        double t = s - (double)a;
+        long long tq = cx_round(t * 256.0);
+        if (tq > 255) tq = 255;
+        return {(int)a, b, (int)tq};
+    }
+};
+
+struct hw_q88_rounding {
+    using scale_type = uint32_t;   // scale_q8_8, como REG_SCALE
+    static constexpr const char *name = "hw_q8.8";
+
+    static constexpr scale_type from_q8_8(uint32_t q) { return q; }
+
+    static constexpr bool to_q8_8(scale_type s, uint32_t &q) {
+        q = s;
+        return s != 0;
+    }
+
+    static constexpr uint32_t inv_scale_q(scale_type scale_q8_8) {
+        return scale_q8_8 == 0 ? 0x0100u : 65536u / scale_q8_8;
+    }
+
+    //   s_q = ((o << 8) + 128) * inv_scale_q >> 8 - 128, parte entera con >>>,
+    //   fraccion con & 0xFF (igual que bilinear_core_scalar/simd)
+    static constexpr axis_coord coord(int o, int n_in, scale_type scale_q8_8) {
+        const int ONE_Q = 256;
+        int o_q = (o << 8) + (ONE_Q / 2);
+        int temp_q = (int)(((int64_t)o_q * (int64_t)inv_scale_q(scale_q8_8)) >> 8);
+        int s_q = temp_q - (ONE_Q / 2);
+
+        int a = s_q >> 8; // shift aritmetico, como >>> en SV
+        if (a < 0) a = 0;
+        else if (a > n_in - 1) a = n_in - 1;
+        int b = (a + 1 <= n_in - 1) ? (a + 1) : a;
+        return {a, b, s_q & (ONE_Q - 1)};
+    }
+
+    // Huella de la salida o en modo box (downscale_box.h), entradas
+    // [i0, i1] inclusive:
+    //   [(o * inv_scale_q) >> 8, ((o+1) * inv_scale_q) >> 8), al menos una
+    static constexpr axis_coord box_span(int o, int n_in, scale_type scale_q8_8) {
+        const int64_t inv = inv_scale_q(scale_q8_8);
+        int64_t b = ((int64_t)o * inv) >> 8;
+        int64_t e = ((int64_t)(o + 1) * inv) >> 8;
+        if (b > n_in - 1) b = n_in - 1;
+        if (e > n_in) e = n_in;
+        if (e <= b) e = b + 1;
+        return {(int)b, (int)e - 1, 0};
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Patron de una escala fija
+// -----------------------------------------------------------------------------
+//
+// Con escala q/256 = P/Q (reducida), cada P muestras de salida avanzan Q de
+// entrada y, lejos de los bordes, los vecinos y pesos se repiten:
+//   x0(k*P + j) = k*Q + dx[j],  x1 = x0 + 1,  t_q(k*P + j) = tq[j]
+// Ej. 0x80 -> P=1, Q=2, dx={0}, tq={128}; 0x100 -> identidad.
+// Se verifica en compilacion sobre varios periodos; con la semantica HW a
+// 0xC0 (inv_scale_q = 341, no 341.33) el error se acumula y no hay patron.
+// Las tablas reales se vuelven a comparar en ejecucion (ver
+// attach_fixed_kernel), porque en los bordes manda el clamp.
+
+constexpr uint32_t cx_gcd(uint32_t a, uint32_t b) { return b ? cx_gcd(b, a % b) : a; }
+
+template <class R, uint32_t ScaleQ>
+struct fixed_pattern {
+    static_assert(ScaleQ > 0 && ScaleQ <= 0x100, "solo escalas de reduccion (0 < q <= 0x100)");
+
+    static constexpr int P = (int)(ScaleQ / cx_gcd(ScaleQ, 256));
+    static constexpr int Q = (int)(256 / cx_gcd(ScaleQ, 256));
+    static constexpr int REF_PERIOD = 4;    // periodo de referencia, lejos del borde izquierdo
+    static constexpr int CHECK_PERIODS = 64;
+    static constexpr int BIG_N = 1 << 20;   // n_in "infinito": sin clamp derecho
+
+    struct phases {
+        std::array<int, P> dx{};
+        std::array<int, P> tq{};
+        bool periodic = true;
+    };
+
+    static constexpr phases compute() {
+        phases ph;
+        const auto s = R::from_q8_8(ScaleQ);
+        const int base_o = REF_PERIOD * P, base_x = REF_PERIOD * Q;
+        for (int j = 0; j < P; ++j) {
+            axis_coord c = R::coord(base_o + j, BIG_N, s);
+            ph.dx[j] = c.i0 - base_x;
+            ph.tq[j] = c.t_q;
+        }
+        for (int k = 1; k < CHECK_PERIODS && ph.periodic; ++k) {
+            for (int j = 0; j < P; ++j) {
+                axis_coord c = R::coord(k * P + j, BIG_N, s);
+                if (c.i0 != k * Q + ph.dx[j] || c.i1 != c.i0 + 1 || c.t_q != ph.tq[j] ||
+                    c.t_q < 0 || c.t_q > 255)
+                    ph.periodic = false;
+            }
+        }
+        return ph;
+    }
+
+    static constexpr phases ph = compute();
+    static constexpr bool periodic = ph.periodic;
+    static constexpr bool identity = P == 1 && Q == 1 && ph.dx[0] == 0 && ph.tq[0] == 0;
+    // 0x80 (2:1) y 0x40 (4:1): cada salida cae justo entre dos entradas
+    // (t_q = 128), asi que con ty = 128 el bilineal es el promedio 2x2
+    static constexpr bool pair_avg = P == 1 && (Q == 2 || Q == 4) &&
+                                     ph.dx[0] == Q / 2 - 1 && ph.tq[0] == 128;
+};
@@ -1,97 +1,200 @@
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <memory>
 #include <vector>
 #include <cstdint>
 #include <cmath>
 #include <string>
 #include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
 
-static uint8_t clamp_u8(int x) {
-    if (x < 0)   return 0;
-    if (x > 255) return 255;
-    return static_cast<uint8_t>(x);
-}
+#include "downscale_kernels.h"
+#include "downscale_parallel.h"
+#include "downscale_stream.h"
+#include "image_io.h"
+#include "downscale_batch.h"
+#include "downscale_box.h"
+#include "frame_stream.h"
+#include "result_cache.h"
+#include "perf_counters.h"
 
-std::vector<uint8_t> read_raw_u8(const std::string &path, int W, int H) {
-    std::ifstream f(path, std::ios::binary);
-    if (!f) throw std::runtime_error("no se pudo abrir archivo de entrada " + path);
-    std::vector<uint8_t> data(W*H);
-    f.read(reinterpret_cast<char*>(data.data()), data.size());
-    if (!f) throw std::runtime_error("tamano incorrecto en RAW (se esperaba W*H)");
-    return data;
-}
+// Modo streaming: lee filas de un archivo o de stdin ("-") y escribe cada
+// fila de salida apenas esta lista (a un archivo o a stdout con "-").
+// Solo mantiene en memoria las filas y0/y1 que pide la fila de salida actual.
+// chans > 1: filas RGB/RGBA intercaladas de W*chans bytes.
+void downscale_stream_u8(const std::string &in_path, int W, int H, int chans, double scale,
+                         const std::string &out_raw_path,
+                         const std::string &out_pgm_path,
+                         int &W2, int &H2) {
+    std::ifstream fin;
+    std::istream *in = &std::cin;
+    if (in_path != "-") {
+        fin.open(in_path, std::ios::binary);
+        if (!fin) throw std::runtime_error("no se pudo abrir archivo de entrada " + in_path);
+        in = &fin;
+    }
+
+    std::ofstream fraw;
+    std::ostream *out = &std::cout;
+    if (out_raw_path != "-") {
+        fraw.open(out_raw_path, std::ios::binary);
+        if (!fraw) throw std::runtime_error("no se pudo abrir archivo de salida " + out_raw_path);
+        out = &fraw;
+    }
+
+    coord_tables g = build_coord_tables(W, H, scale);
+    W2 = g.W2;
+    H2 = g.H2;
+    coord_tables t = interleave_tables(g, chans);
+    const int row_bytes = W * chans, out_row_bytes = W2 * chans;
 
-void write_raw_u8(const std::string &path, const std::vector<uint8_t> &img) {
-    std::ofstream f(path, std::ios::binary);
-    if (!f) throw std::runtime_error("no se pudo abrir archivo de salida " + path);
-    f.write(reinterpret_cast<const char*>(img.data()), img.size());
+    // El encabezado PGM/PPM se conoce de antemano, asi que tambien va por filas
+    std::ofstream fpgm;
+    if (!out_pgm_path.empty()) {
+        fpgm.open(out_pgm_path, std::ios::binary);
+        if (!fpgm) throw std::runtime_error("no se pudo abrir PGM de salida " + out_pgm_path);
+        fpgm << pnm_header(W2, H2, chans);
+    }
+
+    row_stream_downscaler ds(row_bytes, H, t);
+    auto emit = [&](int, const uint8_t *row) {
+        out->write(reinterpret_cast<const char*>(row), out_row_bytes);
+        if (fpgm.is_open()) fpgm.write(reinterpret_cast<const char*>(row), out_row_bytes);
+    };
+
+    // Se leen todas las filas aunque las ultimas ya no hagan falta, para no
+    // cortar la tuberia de quien escribe en stdin.
+    while (ds.need_more()) {
+        in->read(reinterpret_cast<char*>(ds.slot()), row_bytes);
+        if (!*in) throw std::runtime_error("RAW truncado: se leyeron " +
+                                           std::to_string(ds.next_y()) + " de " +
+                                           std::to_string(H) + " filas");
+        ds.push(emit);
+    }
+
+    out->flush();
+    if (!*out) throw std::runtime_error("fallo al escribir la salida " + out_raw_path);
 }
 
-void write_pgm_u8(const std::string &path, const std::vector<uint8_t> &img, int W, int H) {
-    std::ofstream f(path, std::ios::binary);
-    if (!f) throw std::runtime_error("no se pudo abrir PGM de salida " + path);
-    f << "P5\n" << W << " " << H << "\n255\n";
-    f.write(reinterpret_cast<const char*>(img.data()), img.size());
+static std::vector<std::string> split_list(const std::string &s) {
+    std::vector<std::string> out;
+    size_t i = 0;
+    while (i <= s.size()) {
+        size_t j = s.find(',', i);
+        if (j == std::string::npos) j = s.size();
+        if (j > i) out.push_back(s.substr(i, j - i));
+        i = j + 1;
+    }
+    return out;
 }
 
-// Modelo de referencia en C++ con la misma logica que el Python (Q8.8 y Q10.8)
-std::vector<uint8_t> downscale_bilinear_u8_cpp(
-        const std::vector<uint8_t> &img, int W, int H,
-        double scale, int &W2, int &H2) {
+// Modo piramide: varias escalas de la misma entrada leyendola una sola vez.
+// Cada nivel sale de la imagen original (no del nivel anterior), asi que los
+// bytes son los mismos que con una corrida por escala. La entrada puede ser
+// stdin ("-", RAW con W/H) o un archivo (RAW/PGM/PPM, mapeado); las salidas
+// se escriben fila por fila, una por nivel.
+void downscale_pyramid_u8(const std::string &in_path, int W, int H, int chans,
+                          const std::vector<double> &scales,
+                          const std::vector<std::string> &out_raw_paths,
+                          const std::vector<std::string> &out_pgm_paths,
+                          std::vector<coord_tables> &dims) {
+    std::ifstream fin;
+    mapped_image img;
+    if (in_path == "-") {
+        chans = chans ? chans : 1;
+    } else {
+        img = map_image_u8(in_path, W, H, false, chans);
+        W = img.w;
+        H = img.h;
+        chans = img.chans;
+    }
+
+    const size_t n = scales.size();
+    dims.clear();
+    std::vector<coord_tables> levels;
+    std::vector<std::ofstream> fraw(n), fpgm(n);
+    for (size_t l = 0; l < n; ++l) {
+        coord_tables g = build_coord_tables(W, H, scales[l]);
+        levels.push_back(interleave_tables(g, chans));
+        dims.push_back(std::move(g));
 
-    H2 = std::max(1, (int)std::round(H * scale));
-    W2 = std::max(1, (int)std::round(W * scale));
-    std::vector<uint8_t> out(W2 * H2, 0);
+        fraw[l].open(out_raw_paths[l], std::ios::binary);
+        if (!fraw[l]) throw std::runtime_error("no se pudo abrir archivo de salida " + out_raw_paths[l]);
+        if (l < out_pgm_paths.size()) {
+            fpgm[l].open(out_pgm_paths[l], std::ios::binary);
+            if (!fpgm[l]) throw std::runtime_error("no se pudo abrir PGM de salida " + out_pgm_paths[l]);
+            fpgm[l] << pnm_header(dims[l].W2, dims[l].H2, chans);
+        }
+    }
 
-    auto at = [&](int x, int y) -> uint8_t {
-        return img[y*W + x];
+    const int row_bytes = W * chans;
+    pyramid_stream_downscaler ds(row_bytes, H, levels);
+    auto emit = [&](int l, int, const uint8_t *row) {
+        const std::streamsize len = (std::streamsize)dims[l].W2 * chans;
+        fraw[l].write(reinterpret_cast<const char*>(row), len);
+        if (fpgm[l].is_open()) fpgm[l].write(reinterpret_cast<const char*>(row), len);
     };
 
-    for (int yo = 0; yo < H2; ++yo) {
-        double ys = ( (double)yo + 0.5 ) / scale - 0.5;
-        int y0 = (int)std::floor(ys);
-        if (y0 < 0) y0 = 0;
-        if (y0 > H-1) y0 = H-1;
-        int y1 = (y0 + 1 < H) ? y0 + 1 : y0;
-        double ty = ys - y0;
-        int ty_q = std::min(255, (int)std::round(ty * 256.0)); // Q8.8
-
-        for (int xo = 0; xo < W2; ++xo) {
-            double xs = ( (double)xo + 0.5 ) / scale - 0.5;
-            int x0 = (int)std::floor(xs);
-            if (x0 < 0) x0 = 0;
-            if (x0 > W-1) x0 = W-1;
-            int x1 = (x0 + 1 < W) ? x0 + 1 : x0;
-            double tx = xs - x0;
-            int tx_q = std::min(255, (int)std::round(tx * 256.0)); // Q8.8
-
-            int I00 = at(x0, y0);
-            int I10 = at(x1, y0);
-            int I01 = at(x0, y1);
-            int I11 = at(x1, y1);
-
-            int wx0 = 256 - tx_q;
-            int wy0 = 256 - ty_q;
-
-            // mismo acumulador que en Python: I*wx*wy + ...
-            long long acc = 0;
-            acc += 1LL * I00 * wx0 * wy0;
-            acc += 1LL * I10 * tx_q * wy0;
-            acc += 1LL * I01 * wx0 * ty_q;
-            acc += 1LL * I11 * tx_q * ty_q;
-
-            acc = (acc + (1LL<<15)) >> 16; // redondeo
-            out[yo*W2 + xo] = clamp_u8((int)acc);
+    while (ds.need_more()) {
+        if (img.pix) {
+            ds.push_row(img.pix + (size_t)ds.next_y() * row_bytes, emit);
+            continue;
         }
+        std::cin.read(reinterpret_cast<char*>(ds.slot()), row_bytes);
+        if (!std::cin) throw std::runtime_error("RAW truncado: se leyeron " +
+                                                std::to_string(ds.next_y()) + " de " +
+                                                std::to_string(H) + " filas");
+        ds.push(emit);
     }
 
-    return out;
+    for (size_t l = 0; l < n; ++l) {
+        fraw[l].flush();
+        if (!fraw[l]) throw std::runtime_error("fallo al escribir la salida " + out_raw_paths[l]);
+    }
+}
+
+// meta.json con el esquema de scripts/make_meta.py (el que lee
+// pc/summarize_perf.py) y los contadores de la CPU en "cpu_perf". Si hay
+// ciclos, perf_cyc/perf_pix son los de la CPU (sumados sobre los hilos), asi
+// summarize_perf.py da pixeles/ciclo igual que para la FPGA.
+static void write_perf_meta(const std::string &path, int W, int H, double scale,
+                            int W2, int H2, unsigned threads, bool box, const perf_probe &probe) {
+    std::ofstream f(path);
+    if (!f) throw std::runtime_error("no se pudo abrir " + path + " para escritura");
+    const perf_values v = probe.total();
+    const perf_traffic t = probe.traffic();
+    f << std::setprecision(6);
+    f << "{\n"
+      << "  \"w_in\": " << W << ", \"h_in\": " << H << ",\n"
+      << "  \"scale\": " << scale << ",\n"
+      << "  \"w_out\": " << W2 << ", \"h_out\": " << H2 << ",\n"
+      << "  \"mode\": \"sw\", \"units\": " << threads << ",\n";
+    if (v.has(PEV_CYCLES))
+        f << "  \"perf_cyc\": " << v.v[PEV_CYCLES] << ", \"perf_pix\": " << t.pixels << ",\n";
+    f << "  \"filter\": \"" << (box ? "box" : "bilinear") << "\", \"simd\": \""
+      << (box ? "scalar" : simd_level_name(default_simd_level())) << "\",\n"
+      << "  \"cpu_perf\": ";
+    write_probe_json(f, probe, "  ");
+    f << "\n}\n";
+    if (!f) throw std::runtime_error("fallo al escribir " + path);
 }
 
 int main(int argc, char **argv) {
-    std::string in_path, out_raw_path, out_pgm_path;
+    std::string in_path, out_raw_path, out_pgm_path, manifest_path, cache_dir, perf_meta;
+    long cache_mb = 0;   // 0 = DSA_CACHE_MAX_MB o el default
     int W = 0, H = 0;
-    double scale = 1.0;
+    std::string scale_s = "1.0";
+    int threads = 0;   // 0 = un hilo por nucleo
+    int chans = 0;     // 0 = 1 para RAW, lo del encabezado para PGM/PPM
+    bool stream = false;
+    bool box = false;
+    bool frames = false;
+    int queue_depth = 4;
 
     // parseo sencillo de argumentos estilo --clave valor
     for (int i = 1; i < argc; ++i) {
@@ -99,28 +202,229 @@ int main(int argc, char **argv) {
         if (a == "--in" && i+1 < argc) in_path = argv[++i];
         else if (a == "--w" && i+1 < argc) W = std::stoi(argv[++i]);
         else if (a == "--h" && i+1 < argc) H = std::stoi(argv[++i]);
-        else if (a == "--scale" && i+1 < argc) scale = std::stod(argv[++i]);
+        else if (a == "--scale" && i+1 < argc) scale_s = argv[++i];
         else if (a == "--out-raw" && i+1 < argc) out_raw_path = argv[++i];
-        else if (a == "--out-pgm" && i+1 < argc) out_pgm_path = argv[++i];
+        else if ((a == "--out-pgm" || a == "--out-ppm") && i+1 < argc) out_pgm_path = argv[++i];
+        else if (a == "--channels" && i+1 < argc) chans = std::stoi(argv[++i]);
+        else if (a == "--threads" && i+1 < argc) threads = std::stoi(argv[++i]);
+        else if (a == "--stream") stream = true;
+        else if (a == "--box") box = true;
+        else if (a == "--frames") frames = true;
+        else if (a == "--queue" && i+1 < argc) queue_depth = std::stoi(argv[++i]);
+        else if (a == "--manifest" && i+1 < argc) manifest_path = argv[++i];
+        else if (a == "--cache" && i+1 < argc) cache_dir = argv[++i];
+        else if (a == "--cache-max-mb" && i+1 < argc) cache_mb = std::stol(argv[++i]);
+        else if (a == "--perf-meta" && i+1 < argc) perf_meta = argv[++i];
+    }
+
+    // Modo lote: todos los casos del manifest en este proceso (con --threads
+    // negativo cae al uso de abajo)
+    if (!manifest_path.empty() && threads >= 0) {
+        try {
+            auto t0 = std::chrono::steady_clock::now();
+            auto cases = read_manifest(manifest_path);
+            auto cache = open_result_cache(cache_dir, cache_mb);
+            thread_pool pool(threads);
+            batch_result r = run_manifest(cases, pool, default_simd_level(), cache.get());
+            double ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - t0).count();
+            for (auto &e : r.errors) std::cerr << "error: " << e << "\n";
+            std::cout << "C++ ref (manifest): " << r.ok << " de " << r.total
+                      << " casos en " << ms << " ms con " << pool.size() << " hilos"
+                      << std::endl;
+            if (cache) std::cout << "C++ ref (manifest): " << cache->summary() << std::endl;
+            return r.ok == r.total ? 0 : 1;
+        } catch (const std::exception &e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
     }
 
-    if (in_path.empty() || W <= 0 || H <= 0 || out_raw_path.empty()) {
+    // Con varias escalas (--scale 1,0.5,0.25) es una piramide: --out-raw y
+    // --out-pgm pasan a ser listas con un archivo por nivel.
+    std::vector<double> scales;
+    std::vector<std::string> out_raws = split_list(out_raw_path);
+    std::vector<std::string> out_pgms = split_list(out_pgm_path);
+    try {
+        for (const auto &s : split_list(scale_s)) scales.push_back(std::stod(s));
+    } catch (const std::exception &) {
+        scales.clear();
+    }
+    const bool pyramid = scales.size() > 1;
+    const bool bad_lists = pyramid && (out_raws.size() != scales.size() ||
+                                       (!out_pgms.empty() && out_pgms.size() != scales.size()) ||
+                                       stream);
+
+    // --w/--h se pueden omitir si la entrada es un PGM/PPM (salen del encabezado)
+    // El box usa la escala en Q8.8 del HW: una sola y sin stream
+    const bool bad_box = box && (scales.empty() || stream || pyramid ||
+                                 std::lround(scales[0] * 256.0) < 1 ||
+                                 std::lround(scales[0] * 256.0) > 0x100);
+    // Secuencia de cuadros: una escala, sin otros modos; W/H salen del Y4M
+    const bool bad_frames = frames && (stream || pyramid || box || queue_depth < 2);
+
+    if (in_path.empty() || out_raw_path.empty() || scales.empty() || bad_lists || bad_box ||
+        bad_frames || threads < 0 ||
+        ((stream || (pyramid && in_path == "-")) && (W <= 0 || H <= 0)) ||
+        (chans != 0 && chans != 1 && chans != 3 && chans != 4)) {
         std::cerr << "uso: " << argv[0]
-                  << " --in ruta.raw --w W --h H --scale s"
-                  << " --out-raw salida.raw [--out-pgm salida.pgm]\n";
+                  << " --in ruta.raw|ruta.pgm|ruta.ppm [--w W --h H] [--channels 1|3|4] --scale s"
+                  << " --out-raw salida.raw [--out-pgm salida.pgm | --out-ppm salida.ppm]"
+                  << " [--threads N] [--stream | --box | --frames [--queue N]]\n"
+                  << "   o: " << argv[0] << " --manifest vectors/manifest.csv [--threads N]\n"
+                  << "  [--cache dir [--cache-max-mb N]] en los dos casos\n"
+                  << "  --w y --h son obligatorios para RAW y para --stream\n"
+                  << "  --channels: RAW RGB (3) o RGBA (4) intercalado; un .ppm ya es de 3\n"
+                  << "  con --stream, --in - lee de stdin y --out-raw - escribe a stdout\n"
+                  << "  --scale 1,0.5,0.25: piramide en una pasada, con --out-raw (y --out-pgm)\n"
+                  << "    como lista de un archivo por escala; --in - lee RAW de stdin\n"
+                  << "  --box: promedio de area (para escalas < 0.5), con la escala en Q8.8\n"
+                  << "    y las dimensiones del HW, igual que REG_MODE[1] en dsa_top_seq\n"
+                  << "  --frames: secuencia de cuadros RAW (--w/--h) o Y4M (solo luma) de --in\n"
+                  << "    a --out-raw (\"-\" = stdin/stdout), leyendo, escalando y escribiendo\n"
+                  << "    en paralelo con --queue cuadros en vuelo (4)\n"
+                  << "  --cache: guarda y reusa salidas por hash de la entrada y la escala\n"
+                  << "    (o DSA_CACHE_DIR), LRU hasta --cache-max-mb (DSA_CACHE_MAX_MB, 256);\n"
+                  << "    solo imagen unica y --manifest, no --stream/--frames/piramide\n"
+                  << "  --perf-meta meta.json: mide el kernel con los contadores de la CPU\n"
+                  << "    (perf_event_open) por banda y los escribe con el esquema de\n"
+                  << "    summarize_perf.py; solo imagen unica, sin cache\n";
         return 1;
     }
+    const double scale = scales[0];
 
     try {
-        auto img = read_raw_u8(in_path, W, H);
-        int W2 = 0, H2 = 0;
-        auto out = downscale_bilinear_u8_cpp(img, W, H, scale, W2, H2);
-        write_raw_u8(out_raw_path, out);
+        // Ninguna salida puede ser la entrada: se mapea y despues se truncaria
+        if (in_path != "-") {
+            std::vector<std::string> outs = out_raws;
+            outs.insert(outs.end(), out_pgms.begin(), out_pgms.end());
+            for (const auto &o : outs)
+                if (o != "-" && same_file(in_path, o))
+                    throw std::runtime_error("la salida " + o + " es el mismo archivo que la entrada " +
+                                             in_path);
+        }
+
+        if (pyramid) {
+            std::ios::sync_with_stdio(false);
+            std::vector<coord_tables> dims;
+            downscale_pyramid_u8(in_path, W, H, chans, scales, out_raws, out_pgms, dims);
+            for (size_t l = 0; l < dims.size(); ++l)
+                std::cerr << "C++ ref (piramide): nivel " << l << " escala " << scales[l]
+                          << " salida " << dims[l].W2 << "x" << dims[l].H2
+                          << " generada en " << out_raws[l] << std::endl;
+            return 0;
+        }
+
+        if (frames) {
+            frame_format raw;
+            raw.w = W;
+            raw.h = H;
+            raw.chans = chans ? chans : 1;
+            const int in_fd = in_path == "-" ? 0 : ::open(in_path.c_str(), O_RDONLY);
+            if (in_fd < 0) throw std::runtime_error("no se pudo abrir archivo de entrada " + in_path);
+            const int out_fd = out_raw_path == "-" ? 1 :
+                ::open(out_raw_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (out_fd < 0) throw std::runtime_error("no se pudo abrir archivo de salida " + out_raw_path);
+            thread_pool pool(threads);
+            frame_stream_stats st = run_frame_stream(in_fd, out_fd, raw, scale, queue_depth, pool);
+            if (in_fd != 0) ::close(in_fd);
+            if (out_fd != 1) ::close(out_fd);
+
+            const double s = st.wall_ms / 1e3;
+            std::fprintf(stderr,
+                         "C++ ref (frames): %ld cuadros %dx%d -> %dx%d en %.2f s: %.1f cuadros/s"
+                         " (%.0f Mpix/s de entrada)\n",
+                         st.frames, st.in_w, st.in_h, st.out_w, st.out_h, s, st.fps(),
+                         s > 0 ? st.frames * (double)st.in_w * st.in_h / s / 1e6 : 0.0);
+            std::fprintf(stderr,
+                         "  latencia por cuadro (leido -> escrito): p50 %.2f ms, p90 %.2f ms,"
+                         " p99 %.2f ms, max %.2f ms\n",
+                         st.latency_pct(0.5), st.latency_pct(0.9), st.latency_pct(0.99),
+                         st.latency_pct(1.0));
+            std::fprintf(stderr,
+                         "  por etapa: lectura %.0f ms, calculo %.0f ms (%u hilos), escritura %.0f ms;"
+                         " %d cuadros en vuelo\n",
+                         st.read_ms, st.compute_ms, pool.size(), st.write_ms, queue_depth);
+            return 0;
+        }
+
+        if (stream) {
+            std::ios::sync_with_stdio(false);
+            int W2 = 0, H2 = 0;
+            downscale_stream_u8(in_path, W, H, chans ? chans : 1, scale,
+                                out_raw_path, out_pgm_path, W2, H2);
+            std::cerr << "C++ ref (stream): salida " << W2 << "x" << H2
+                      << " generada en " << out_raw_path << std::endl;
+            return 0;
+        }
+
+        // Entrada y salida mapeadas: el kernel lee de las paginas del archivo
+        // de entrada y escribe directo en las del RAW de salida. Con color
+        // las tablas se expanden por canal y se pasa una vez por la imagen
+        // intercalada.
+        mapped_image img = map_image_u8(in_path, W, H, false, chans);
+        const int C = img.chans;
+        thread_pool pool(threads);
+        // Con --perf-meta se mide el kernel, asi que no se usa la cache
+        auto cache = perf_meta.empty() ? open_result_cache(cache_dir, cache_mb) : nullptr;
+        std::unique_ptr<perf_probe> probe(perf_meta.empty() ? nullptr : new perf_probe);
+        auto report_perf = [&](int W2, int H2, bool is_box) {
+            if (!probe) return;
+            write_perf_meta(perf_meta, img.w, img.h, scale, W2, H2, pool.size(), is_box, *probe);
+            std::cout << "CPU: " << perf_summary_line(probe->total(), probe->traffic())
+                      << "; " << probe->bands().size() << " bandas en " << perf_meta << std::endl;
+        };
+        // Con cache, un acierto copia la salida guardada en el RAW mapeado
+        auto cached = [&](const std::string &model, int W2, int H2, uint8_t *dst,
+                          uint64_t &key) {
+            if (!cache) return false;
+            key = result_cache_key(img.pix, img.w, img.h, C, model);
+            return cache->get(key, dst, W2, H2, C);
+        };
+
+        if (box) {
+            const uint32_t sq = (uint32_t)std::lround(scale * 256.0);
+            int W2 = 0, H2 = 0;
+            hw_out_dims(img.w, img.h, sq, 0, 0, W2, H2);
+            box_tables bt = build_box_tables(img.w, img.h, W2, H2, sq, C);
+            mapped_output out = map_output_u8(out_raw_path, W2, H2, false, C);
+            uint64_t key = 0;
+            if (!cached(cache_model_hw(sq, true), W2, H2, out.pix, key)) {
+                downscale_box_u8_bands(img.pix, img.w, bt, out.pix, pool, probe.get());
+                if (cache) cache->put(key, out.pix, W2, H2, C);
+            }
+            if (!out_pgm_path.empty()) {
+                mapped_output pgm = map_output_u8(out_pgm_path, W2, H2, true, C);
+                std::memcpy(pgm.pix, out.pix, (size_t)W2 * H2 * C);
+            }
+            std::cout << "C++ ref (box, escala 0x" << std::hex << sq << std::dec << "): salida "
+                      << W2 << "x" << H2
+                      << (C > 1 ? " x" + std::to_string(C) + " canales" : "")
+                      << " generada en " << out_raw_path << std::endl;
+            if (cache) std::cout << "C++ ref (box): " << cache->summary() << std::endl;
+            report_perf(W2, H2, true);
+            return 0;
+        }
+
+        coord_tables g = build_coord_tables(img.w, img.h, scale);
+        int W2 = g.W2, H2 = g.H2;
+        coord_tables t = interleave_tables(g, C);
+        mapped_output out = map_output_u8(out_raw_path, W2, H2, false, C);
+        uint64_t key = 0;
+        if (!cached(cache_model_golden(scale), W2, H2, out.pix, key)) {
+            downscale_u8_bands(img.pix, img.w * C, t, out.pix, pool, default_simd_level(),
+                               probe.get());
+            if (cache) cache->put(key, out.pix, W2, H2, C);
+        }
         if (!out_pgm_path.empty()) {
-            write_pgm_u8(out_pgm_path, out, W2, H2);
+            mapped_output pgm = map_output_u8(out_pgm_path, W2, H2, true, C);
+            std::memcpy(pgm.pix, out.pix, (size_t)W2 * H2 * C);
         }
         std::cout << "C++ ref: salida " << W2 << "x" << H2
+                  << (C > 1 ? " x" + std::to_string(C) + " canales" : "")
                   << " generada en " << out_raw_path << std::endl;
+        if (cache) std::cout << "C++ ref: " << cache->summary() << std::endl;
+        report_perf(W2, H2, false);
     } catch (const std::exception &e) {
         std::cerr << "error: " << e.what() << std::endl;
         return 1;
@@ -0,0 +1,126 @@
+// model/downscale_stream.h
+// Downscale por flujo de filas, para imagenes que no caben en RAM.
+//
+// Las filas de entrada llegan en orden (0..H-1) y se guardan en un buffer
+// circular de 2 filas. Como y0 no decrece con yo y y1 es y0 o y0+1, cuando
+// llega la fila y ya se pueden emitir todas las filas de salida con y1 == y:
+// sus dos vecinas (y-1 e y, o solo y) estan en el anillo. Es la misma
+// disciplina de line buffer que necesitaria el core en RTL para pasar del
+// limite de 64x64 de la BRAM. Memoria: 2*W + W2 bytes mas el scratch SIMD.
+//
+// pyramid_stream_downscaler hace lo mismo con varias escalas a la vez sobre
+// un solo anillo: la entrada se lee una vez y cada nivel emite sus filas.
+
+#pragma once
+
+#include "downscale_kernels.h"
+
+class row_stream_downscaler {
+public:
+    row_stream_downscaler(int W, int H, const coord_tables &t,
+                          simd_level lvl = default_simd_level())
+        : W_(W), H_(H), t_(t), lvl_(lvl),
+          ring_(2 * (size_t)W), v_(simd_scratch_len(W)), out_row_(t.W2) {}
+
+    // Slot donde se puede leer directamente la siguiente fila de entrada
+    uint8_t *slot() { return ring_.data() + (size_t)(next_y_ & 1) * W_; }
+
+    // Avisa que slot() ya tiene la fila next_y(); llama emit(yo, fila) por
+    // cada fila de salida que quedo lista.
+    template <class Emit>
+    void push(Emit &&emit) {
+        const int y = next_y_++;
+        while (next_yo_ < t_.H2 && t_.y1[next_yo_] == y) {
+            const int yo = next_yo_++;
+            const uint8_t *r0 = ring_.data() + (size_t)(t_.y0[yo] & 1) * W_;
+            const uint8_t *r1 = ring_.data() + (size_t)(y & 1) * W_;
+            downscale_u8_row(r0, r1, W_, t_.wy0[yo], t_.ty_q[yo], t_,
+                             out_row_.data(), lvl_, v_.data());
+            emit(yo, (const uint8_t *)out_row_.data());
+        }
+    }
+
+    // Igual que push, copiando la fila desde un buffer externo
+    template <class Emit>
+    void push_row(const uint8_t *row, Emit &&emit) {
+        std::memcpy(slot(), row, W_);
+        push(emit);
+    }
+
+    int next_y() const { return next_y_; }
+    int rows_out() const { return next_yo_; }
+    bool need_more() const { return next_y_ < H_; }
+    bool done() const { return next_yo_ == t_.H2; }
+
+private:
+    int W_, H_;
+    const coord_tables &t_;
+    simd_level lvl_;
+    std::vector<uint8_t> ring_;
+    std::vector<uint16_t> v_;
+    std::vector<uint8_t> out_row_;
+    int next_y_ = 0;
+    int next_yo_ = 0;
+};
+
+// Varias escalas (niveles) de la misma entrada en una sola pasada. Cada
+// nivel tiene sus tablas, calculadas sobre la imagen original (no en
+// cascada), asi que da los mismos bytes que una corrida separada. Como en
+// todos los niveles y1 es y0 o y0+1, las filas que piden estan siempre en
+// el mismo anillo de 2 filas: la fila y se guarda una vez y la usan todos.
+// W es el ancho de fila en bytes (W*chans con tablas de interleave_tables).
+class pyramid_stream_downscaler {
+public:
+    pyramid_stream_downscaler(int W, int H, const std::vector<coord_tables> &levels,
+                              simd_level lvl = default_simd_level())
+        : W_(W), H_(H), levels_(levels), lvl_(lvl),
+          ring_(2 * (size_t)W), v_(simd_scratch_len(W)), next_yo_(levels.size(), 0) {
+        size_t w2 = 0;
+        for (const auto &t : levels_) w2 = std::max(w2, (size_t)t.W2);
+        out_row_.resize(w2);
+    }
+
+    uint8_t *slot() { return ring_.data() + (size_t)(next_y_ & 1) * W_; }
+
+    // Avisa que slot() tiene la fila next_y(); llama emit(nivel, yo, fila)
+    // por cada fila de salida que quedo lista, nivel por nivel.
+    template <class Emit>
+    void push(Emit &&emit) {
+        const int y = next_y_++;
+        const uint8_t *r1 = ring_.data() + (size_t)(y & 1) * W_;
+        for (size_t l = 0; l < levels_.size(); ++l) {
+            const coord_tables &t = levels_[l];
+            int &yo = next_yo_[l];
+            for (; yo < t.H2 && t.y1[yo] == y; ++yo) {
+                const uint8_t *r0 = ring_.data() + (size_t)(t.y0[yo] & 1) * W_;
+                downscale_u8_row(r0, r1, W_, t.wy0[yo], t.ty_q[yo], t,
+                                 out_row_.data(), lvl_, v_.data());
+                emit((int)l, yo, (const uint8_t *)out_row_.data());
+            }
+        }
+    }
+
+    template <class Emit>
+    void push_row(const uint8_t *row, Emit &&emit) {
+        std::memcpy(slot(), row, W_);
+        push(emit);
+    }
+
+    int next_y() const { return next_y_; }
+    bool need_more() const { return next_y_ < H_; }
+    bool done() const {
+        for (size_t l = 0; l < levels_.size(); ++l)
+            if (next_yo_[l] != levels_[l].H2) return false;
+        return true;
+    }
+
+private:
+    int W_, H_;
+    const std::vector<coord_tables> &levels_;
+    simd_level lvl_;
+    std::vector<uint8_t> ring_;
+    std::vector<uint16_t> v_;
+    std::vector<uint8_t> out_row_;
+    std::vector<int> next_yo_;
+    int next_y_ = 0;
+};
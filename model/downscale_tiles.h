@@ -0,0 +1,96 @@
+// model/downscale_tiles.h
+// Particion en tiles para correr imagenes grandes en el core del HW.
+//
+// dsa_top_seq tiene BRAM para IMG_MAX_W x IMG_MAX_H (32x32) de entrada y de
+// salida. Para una imagen mas grande se parte la SALIDA en rectangulos y a
+// cada uno se le carga solo la ventana de entrada que lee:
+//   - en cada eje, la salida [o0, o0+on) lee de i0(o0) a i1(o0+on-1), con la
+//     misma coordenada que la imagen entera (hw_q88_rounding::coord sobre
+//     src_w/src_h). El i1 = i0 + 1 del ultimo pixel es el halo de 1 pixel.
+//   - el core recibe el origen de salida (ORG_X/Y) y el origen de la ventana
+//     (OFF_X/Y), asi que las coordenadas y el clamp de bordes son los de la
+//     imagen entera y el resultado cosido es identico byte a byte.
+// Los tiles se eligen greedy por eje: se agregan columnas (filas) de salida
+// mientras la salida y la ventana de entrada entren en el maximo del HW.
+// En modo box (downscale_box.h) la ventana es la union de las huellas.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "downscale_policy.h"
+
+struct axis_span {
+    int o0, on;   // salida [o0, o0+on)
+    int i0, in;   // entrada [i0, i0+in), con el halo
+};
+
+struct hw_tile {
+    int ox, oy, ow, oh;   // rectangulo de salida en la imagen completa
+    int ix, iy, iw, ih;   // ventana de entrada (lo que va a la BRAM)
+};
+
+// Primera y ultima entrada que lee la salida o (bilineal: i0 e i1; box: la
+// huella entera)
+static inline axis_coord hw_axis_reads(int o, int n_in, uint32_t scale_q8_8, bool box) {
+    return box ? hw_q88_rounding::box_span(o, n_in, scale_q8_8)
+               : hw_q88_rounding::coord(o, n_in, scale_q8_8);
+}
+
+// Corta un eje de n_out salidas sobre n_in entradas. Siempre avanza al menos
+// una salida (con escalas muy chicas una sola ya lee 2 entradas). Si una sola
+// salida lee mas de max_in entradas (box con escala < 256/max_in, la huella
+// mide 65536/scale >> 8) no hay particion posible y devuelve vacio.
+static inline std::vector<axis_span> split_axis_hw(int n_in, int n_out, uint32_t scale_q8_8,
+                                                   int max_in, int max_out, bool box = false) {
+    std::vector<axis_span> spans;
+    int o = 0;
+    while (o < n_out) {
+        axis_coord first = hw_axis_reads(o, n_in, scale_q8_8, box);
+        if (first.i1 - first.i0 + 1 > max_in) return {};
+        int end = o + 1;
+        int last_i1 = first.i1;
+        while (end < n_out && end - o < max_out) {
+            axis_coord c = hw_axis_reads(end, n_in, scale_q8_8, box);
+            if (c.i1 - first.i0 + 1 > max_in) break;
+            last_i1 = c.i1;
+            ++end;
+        }
+        spans.push_back({o, end - o, first.i0, last_i1 - first.i0 + 1});
+        o = end;
+    }
+    return spans;
+}
+
+// Tiles en orden de filas (y, luego x); out_w/out_h son los de la imagen
+// completa (hw_out_dims sin limite). Vacio si algun eje no se puede partir
+// (ver split_axis_hw).
+static inline std::vector<hw_tile> plan_hw_tiles(int W, int H, int out_w, int out_h,
+                                                 uint32_t scale_q8_8, int max_w, int max_h,
+                                                 bool box = false) {
+    std::vector<axis_span> xs = split_axis_hw(W, out_w, scale_q8_8, max_w, max_w, box);
+    std::vector<axis_span> ys = split_axis_hw(H, out_h, scale_q8_8, max_h, max_h, box);
+    std::vector<hw_tile> tiles;
+    if (xs.empty() || ys.empty()) return tiles;
+    tiles.reserve(xs.size() * ys.size());
+    for (const axis_span &y : ys)
+        for (const axis_span &x : xs)
+            tiles.push_back({x.o0, y.o0, x.on, y.on, x.i0, y.i0, x.in, y.in});
+    return tiles;
+}
+
+// Copia la ventana de entrada del tile (iw x ih, compacta) a dst.
+static inline void crop_tile_input(const uint8_t *src, int W, const hw_tile &t, uint8_t *dst) {
+    for (int y = 0; y < t.ih; ++y)
+        std::memcpy(dst + (size_t)y * t.iw, src + (size_t)(t.iy + y) * W + t.ix, t.iw);
+}
+
+// Pega la salida del tile (ow x oh, compacta) en la imagen de salida completa.
+static inline void stitch_tile_output(const uint8_t *tile_out, const hw_tile &t,
+                                      uint8_t *dst, int out_w) {
+    for (int y = 0; y < t.oh; ++y)
+        std::memcpy(dst + (size_t)(t.oy + y) * out_w + t.ox, tile_out + (size_t)y * t.ow, t.ow);
+}
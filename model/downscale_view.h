@@ -0,0 +1,279 @@
+// model/downscale_view.h
+// API sin reservas por cuadro: vistas con stride y arena del que llama.
+//
+// downscale_bilinear_u8_cpp devuelve un std::vector nuevo por llamada y
+// arma las tablas cada vez; en un servicio de video eso es un malloc/free
+// por cuadro. Aca la entrada y la salida son vistas (puntero, w, h, stride
+// en bytes, canales), asi que se puede trabajar sobre un subrectangulo de
+// un buffer mas grande sin copiarlo, y todo lo que hace falta reservar
+// (tablas de coordenadas y scratch SIMD por banda) vive en un
+// downscale_arena que el que llama reusa entre cuadros:
+//   - las tablas se rearman solo si cambia la geometria (W, H, escala,
+//     canales, semantica) y, cuando cambia, reusan la capacidad de sus
+//     vectores (make_coord_tables_into);
+//   - el scratch crece solo si un cuadro pide mas que los anteriores.
+// En estado estable (misma geometria o mas chica) un cuadro no toca el
+// heap, tampoco con thread_pool (sus colas reusan capacidad y el trabajo
+// se pasa como una lambda de un puntero). arena.reserve() deja todo listo
+// antes del primer cuadro.
+//
+// std::span es de C++20 y el proyecto compila con -std=c++17, por eso las
+// vistas son structs propios. read_view/write_view leen y escriben un
+// cuadro RAW directo sobre una vista (fila por fila si tiene stride).
+//
+// Los bytes de salida son los de downscale_u8 con las mismas tablas.
+
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "downscale_kernels.h"
+#include "downscale_parallel.h"
+
+// Vista de solo lectura: w x h pixeles de chans bytes; la fila y empieza en
+// data + y*stride (stride >= w*chans)
+struct u8_view {
+    const uint8_t *data = nullptr;
+    int w = 0, h = 0;
+    size_t stride = 0;
+    int chans = 1;
+
+    const uint8_t *row(int y) const { return data + (size_t)y * stride; }
+    size_t row_bytes() const { return (size_t)w * chans; }
+    // Subrectangulo (x, y, sw, sh) en pixeles, con el mismo stride
+    u8_view sub(int x, int y, int sw, int sh) const {
+        return {row(y) + (size_t)x * chans, sw, sh, stride, chans};
+    }
+};
+
+// Vista escribible
+struct u8_mut_view {
+    uint8_t *data = nullptr;
+    int w = 0, h = 0;
+    size_t stride = 0;
+    int chans = 1;
+
+    uint8_t *row(int y) const { return data + (size_t)y * stride; }
+    size_t row_bytes() const { return (size_t)w * chans; }
+    u8_mut_view sub(int x, int y, int sw, int sh) const {
+        return {row(y) + (size_t)x * chans, sw, sh, stride, chans};
+    }
+    operator u8_view() const { return {data, w, h, stride, chans}; }
+};
+
+// Vistas de un buffer contiguo; stride 0 = filas pegadas (w*chans)
+static inline u8_view make_view(const uint8_t *p, int w, int h, int chans = 1,
+                                size_t stride = 0) {
+    return {p, w, h, stride ? stride : (size_t)w * chans, chans};
+}
+
+static inline u8_mut_view make_mut_view(uint8_t *p, int w, int h, int chans = 1,
+                                        size_t stride = 0) {
+    return {p, w, h, stride ? stride : (size_t)w * chans, chans};
+}
+
+// Tablas y scratch reusables entre cuadros. No es thread-safe: una arena por
+// flujo (los hilos del pool usan cada uno su banda de scratch).
+class downscale_arena {
+public:
+    // Reserva para cuadros de hasta W pixeles de ancho y chans canales, con
+    // salida de hasta W2 x H2 y n_bands bandas (band_rows_for), asi ni el
+    // primer cuadro reserva. Es opcional: sin esto la arena crece sola.
+    void reserve(int W, int W2, int H2, int chans = 1, unsigned n_bands = 1) {
+        for (coord_tables *t : {&gray_, &tables_}) {
+            const int wx = t == &gray_ ? W2 : W2 * chans;
+            for (auto *v : {&t->x0, &t->x1, &t->tx_q, &t->wx0}) v->reserve(wx);
+            for (auto *v : {&t->y0, &t->y1, &t->ty_q, &t->wy0}) v->reserve(H2);
+        }
+        scratch(n_bands, W * chans);
+    }
+
+    // Tablas con semantica del golden para W x H (pixeles) a escala scale,
+    // salida round(W*scale) x round(H*scale)
+    const coord_tables &golden_tables(int W, int H, double scale, int chans = 1) {
+        if (!same_key(false, W, H, chans, scale, 0)) {
+            int W2, H2;
+            golden_out_dims(W, H, scale, W2, H2);
+            make_coord_tables_into<golden_rounding>(gray_, W, H, W2, H2, scale);
+            finish(chans);
+        }
+        return *cur_;
+    }
+
+    // Tablas con semantica del HW (Q8.8, dimensiones de hw_out_dims sin limite)
+    const coord_tables &hw_tables(int W, int H, uint32_t scale_q8_8, int chans = 1) {
+        if (!same_key(true, W, H, chans, 0, scale_q8_8)) {
+            int W2, H2;
+            hw_out_dims(W, H, scale_q8_8, 0, 0, W2, H2);
+            make_coord_tables_into<hw_q88_rounding>(gray_, W, H, W2, H2, scale_q8_8);
+            finish(chans);
+        }
+        return *cur_;
+    }
+
+    // Scratch SIMD de n_bands bandas para filas de row_bytes bytes; la banda
+    // b empieza en scratch(...) + b*scratch_stride()
+    uint16_t *scratch(unsigned n_bands, int row_bytes) {
+        stride_ = simd_scratch_len(row_bytes);
+        const size_t need = stride_ * std::max(1u, n_bands);
+        if (v_.size() < need) v_.resize(need);
+        return v_.data();
+    }
+    size_t scratch_stride() const { return stride_; }
+
+    // Veces que se armaron tablas (cambios de geometria)
+    unsigned rebuilds() const { return rebuilds_; }
+
+private:
+    bool same_key(bool hw, int W, int H, int chans, double scale, uint32_t sq) {
+        if (cur_ && key_.hw == hw && key_.W == W && key_.H == H && key_.chans == chans &&
+            key_.scale == scale && key_.sq == sq)
+            return true;
+        key_ = {hw, W, H, chans, scale, sq};
+        ++rebuilds_;
+        return false;
+    }
+
+    void finish(int chans) {
+        if (chans == 1) {
+            cur_ = &gray_;
+        } else {
+            interleave_tables_into(gray_, chans, tables_);
+            cur_ = &tables_;
+        }
+    }
+
+    struct key {
+        bool hw;
+        int W, H, chans;
+        double scale;
+        uint32_t sq;
+    };
+    key key_{};
+    coord_tables gray_, tables_;
+    const coord_tables *cur_ = nullptr;
+    std::vector<uint16_t> v_;
+    size_t stride_ = 0;
+    unsigned rebuilds_ = 0;
+};
+
+// Filas de salida [yo_begin, yo_end) de in -> out con las tablas t (armadas
+// sobre in.w x in.h y los canales de in). v: scratch de
+// simd_scratch_len(in.row_bytes()) entradas.
+static inline void downscale_u8_view_rows(const u8_view &in, const coord_tables &t,
+                                          const u8_mut_view &out, int yo_begin, int yo_end,
+                                          simd_level lvl, uint16_t *v) {
+    const int rb = (int)in.row_bytes();
+    for (int yo = yo_begin; yo < yo_end; ++yo)
+        downscale_u8_row(in.row(t.y0[yo]), in.row(t.y1[yo]), rb, t.wy0[yo], t.ty_q[yo], t,
+                         out.row(yo), lvl, v);
+}
+
+// Cuadro entero. out tiene que ser de al menos t.W2/chans x t.H2 con los
+// mismos canales que in; se escribe la esquina superior izquierda. Con pool
+// reparte bandas de filas como downscale_u8_bands (y las mide con probe).
+static inline void downscale_u8_view(const u8_view &in, const coord_tables &t,
+                                     const u8_mut_view &out, downscale_arena &arena,
+                                     thread_pool *pool = nullptr,
+                                     simd_level lvl = default_simd_level(),
+                                     perf_probe *probe = nullptr) {
+    if (out.chans != in.chans || out.row_bytes() < (size_t)t.W2 || out.h < t.H2)
+        throw std::runtime_error("la vista de salida no alcanza para " +
+                                 std::to_string(t.W2 / in.chans) + "x" + std::to_string(t.H2));
+    if (!pool || pool->size() == 1) {
+        perf_band_scope ps(probe, 0, t.H2,
+                           probe ? bilinear_band_traffic(t, (int)in.row_bytes(), 0, t.H2)
+                                 : perf_traffic());
+        downscale_u8_view_rows(in, t, out, 0, t.H2, lvl, arena.scratch(1, (int)in.row_bytes()));
+        return;
+    }
+    struct band_job {
+        const u8_view *in;
+        const coord_tables *t;
+        const u8_mut_view *out;
+        simd_level lvl;
+        uint16_t *v;
+        size_t v_stride;
+        int rows;
+        perf_probe *probe;
+    };
+    const int rows = band_rows_for(t.H2, pool->size());
+    const int n_bands = (t.H2 + rows - 1) / rows;
+    uint16_t *v = arena.scratch((unsigned)n_bands, (int)in.row_bytes());
+    band_job job{&in, &t, &out, lvl, v, arena.scratch_stride(), rows, probe};
+    // una lambda de un puntero entra en el buffer interno de std::function
+    pool->parallel_for(n_bands, [j = &job](int b) {
+        const int yo_begin = b * j->rows;
+        const int yo_end = std::min(j->t->H2, yo_begin + j->rows);
+        perf_band_scope ps(j->probe, yo_begin, yo_end,
+                           j->probe ? bilinear_band_traffic(*j->t, (int)j->in->row_bytes(),
+                                                            yo_begin, yo_end)
+                                    : perf_traffic());
+        downscale_u8_view_rows(*j->in, *j->t, *j->out, yo_begin, yo_end, j->lvl,
+                               j->v + (size_t)b * j->v_stride);
+    });
+}
+
+// Semantica del golden: out recibe round(in.w*scale) x round(in.h*scale)
+static inline void downscale_bilinear_u8_view(const u8_view &in, double scale,
+                                              const u8_mut_view &out, downscale_arena &arena,
+                                              thread_pool *pool = nullptr,
+                                              perf_probe *probe = nullptr) {
+    downscale_u8_view(in, arena.golden_tables(in.w, in.h, scale, in.chans), out, arena, pool,
+                      default_simd_level(), probe);
+}
+
+// Semantica del HW (modelo Q8.8 del driver, sin limite de tamaño)
+static inline void downscale_hw_u8_view(const u8_view &in, uint32_t scale_q8_8,
+                                        const u8_mut_view &out, downscale_arena &arena,
+                                        thread_pool *pool = nullptr,
+                                        perf_probe *probe = nullptr) {
+    downscale_u8_view(in, arena.hw_tables(in.w, in.h, scale_q8_8, in.chans), out, arena, pool,
+                      default_simd_level(), probe);
+}
+
+// Lee un cuadro RAW de fd sobre la vista. Devuelve false si fd termina
+// justo antes del cuadro y lanza si termina a mitad.
+static inline bool read_view(int fd, const u8_mut_view &dst) {
+    const size_t rb = dst.row_bytes();
+    const bool packed = dst.stride == rb;
+    const size_t total = packed ? rb * dst.h : rb;
+    for (int y = 0; y < (packed ? 1 : dst.h); ++y) {
+        uint8_t *p = dst.row(y);
+        size_t got = 0;
+        while (got < total) {
+            ssize_t r = ::read(fd, p + got, total - got);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) throw std::runtime_error("fallo al leer el cuadro");
+            if (r == 0) {
+                if (got == 0 && y == 0) return false;
+                throw std::runtime_error("cuadro incompleto en la entrada");
+            }
+            got += (size_t)r;
+        }
+    }
+    return true;
+}
+
+// Escribe la vista como RAW (filas pegadas) en fd
+static inline void write_view(int fd, const u8_view &src) {
+    const size_t rb = src.row_bytes();
+    const bool packed = src.stride == rb;
+    const size_t total = packed ? rb * src.h : rb;
+    for (int y = 0; y < (packed ? 1 : src.h); ++y) {
+        const uint8_t *p = src.row(y);
+        size_t off = 0;
+        while (off < total) {
+            ssize_t r = ::write(fd, p + off, total - off);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) throw std::runtime_error("fallo al escribir el cuadro");
+            off += (size_t)r;
+        }
+    }
+}
@@ -0,0 +1,367 @@
+// model/frame_stream.h
+// Secuencia de cuadros de un fd a otro (p.ej. stdin -> stdout), en tres
+// etapas que se solapan:
+//
+//   lector --[llenos]--> calculo --[listos]--> escritor --[libres]--> lector
+//
+// Cada etapa es un hilo y las une una spsc_queue (model/spsc_queue.h) de
+// indices de slot. Hay queue_depth slots fijos (entrada + salida de un
+// cuadro) que dan la vuelta, asi que a lo sumo queue_depth cuadros estan
+// en vuelo y en estado estable nada reserva memoria: el calculo va por la
+// API de vistas con una arena (model/downscale_view.h), con el pool si hay
+// mas de un hilo. Mientras se escala el cuadro n se esta leyendo el n+1 y
+// escribiendo el n-1.
+//
+// Entrada: cuadros RAW de tamaño fijo (W x H x chans, pegados) o Y4M. Del
+// Y4M se usa solo la luma de 8 bits: se leen W*H bytes por cuadro y se
+// descarta la croma segun el tag C (420, 422, 444, mono...). La salida es
+// RAW, o Y4M Cmono si la entrada era Y4M (mismos F/I/A), asi se puede ver
+// con ffplay.
+//
+// Latencia de un cuadro: desde que el lector lo termino de leer hasta que
+// el escritor lo termino de escribir (cola + calculo + escritura). Va a un
+// histograma de tamaño fijo, asi un video largo no crece en memoria.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "downscale_view.h"
+#include "spsc_queue.h"
+
+struct frame_format {
+    bool y4m = false;
+    int w = 0, h = 0, chans = 1;
+    size_t chroma_bytes = 0;   // Y4M: bytes de croma por cuadro que se saltean
+    std::string params;        // Y4M: tags F, I y A para repetirlos en la salida
+};
+
+// Lectura con buffer de un fd. Los pedidos grandes (un cuadro) van directo
+// al destino sin pasar por el buffer.
+class fd_reader {
+public:
+    explicit fd_reader(int fd) : fd_(fd), buf_(1 << 16) {}
+
+    // Lee n bytes en dst; devuelve menos solo si se termina la entrada
+    size_t read(uint8_t *dst, size_t n) {
+        size_t got = std::min(n, len_ - pos_);
+        std::memcpy(dst, buf_.data() + pos_, got);
+        pos_ += got;
+        while (got < n) {
+            if (n - got < buf_.size()) {
+                if (!fill()) break;
+                const size_t k = std::min(n - got, len_ - pos_);
+                std::memcpy(dst + got, buf_.data() + pos_, k);
+                pos_ += k;
+                got += k;
+                continue;
+            }
+            const ssize_t r = raw_read(dst + got, n - got);
+            if (r == 0) break;
+            got += (size_t)r;
+        }
+        return got;
+    }
+
+    // Saltea n bytes; devuelve los salteados
+    size_t skip(size_t n, std::vector<uint8_t> &scratch) {
+        if (scratch.size() < std::min(n, buf_.size())) scratch.resize(std::min(n, buf_.size()));
+        size_t done = 0;
+        while (done < n) {
+            const size_t k = read(scratch.data(), std::min(n - done, scratch.size()));
+            if (!k) break;
+            done += k;
+        }
+        return done;
+    }
+
+    // Una linea sin el '\n'. false si la entrada termina antes de leer nada.
+    bool read_line(std::string &line, size_t max_len = 4096) {
+        line.clear();
+        for (;;) {
+            if (pos_ == len_ && !fill()) {
+                if (line.empty()) return false;
+                throw std::runtime_error("linea de encabezado Y4M incompleta");
+            }
+            const uint8_t *p = buf_.data() + pos_;
+            const uint8_t *nl = (const uint8_t *)std::memchr(p, '\n', len_ - pos_);
+            const size_t k = nl ? (size_t)(nl - p) : len_ - pos_;
+            line.append((const char *)p, k);
+            pos_ += k + (nl ? 1 : 0);
+            if (nl) return true;
+            if (line.size() > max_len) throw std::runtime_error("encabezado Y4M demasiado largo");
+        }
+    }
+
+    // Los primeros n bytes sin consumirlos (menos si la entrada es mas corta)
+    size_t peek(uint8_t *dst, size_t n) {
+        while (len_ - pos_ < n) {
+            if (pos_) {
+                std::memmove(buf_.data(), buf_.data() + pos_, len_ - pos_);
+                len_ -= pos_;
+                pos_ = 0;
+            }
+            const ssize_t r = raw_read(buf_.data() + len_, buf_.size() - len_);
+            if (r == 0) break;
+            len_ += (size_t)r;
+        }
+        const size_t k = std::min(n, len_ - pos_);
+        std::memcpy(dst, buf_.data() + pos_, k);
+        return k;
+    }
+
+private:
+    ssize_t raw_read(uint8_t *dst, size_t n) {
+        for (;;) {
+            const ssize_t r = ::read(fd_, dst, n);
+            if (r >= 0) return r;
+            if (errno != EINTR) throw std::runtime_error("fallo al leer la entrada");
+        }
+    }
+
+    bool fill() {
+        pos_ = 0;
+        len_ = (size_t)raw_read(buf_.data(), buf_.size());
+        return len_ > 0;
+    }
+
+    int fd_;
+    std::vector<uint8_t> buf_;
+    size_t pos_ = 0, len_ = 0;
+};
+
+// Encabezado "YUV4MPEG2 W.. H.. F.. I.. A.. C.." (sin el '\n')
+static inline frame_format parse_y4m_header(const std::string &line) {
+    frame_format f;
+    f.y4m = true;
+    std::string cs = "420jpeg";   // el default de Y4M
+    size_t i = 0;
+    while (i < line.size()) {
+        size_t j = line.find(' ', i);
+        if (j == std::string::npos) j = line.size();
+        const std::string tok = line.substr(i, j - i);
+        i = j + 1;
+        if (tok.empty() || tok == "YUV4MPEG2") continue;
+        switch (tok[0]) {
+            case 'W': f.w = std::stoi(tok.substr(1)); break;
+            case 'H': f.h = std::stoi(tok.substr(1)); break;
+            case 'C': cs = tok.substr(1); break;
+            case 'F': case 'I': case 'A': f.params += " " + tok; break;
+            default: break;   // X (comentarios/extensiones)
+        }
+    }
+    if (f.w <= 0 || f.h <= 0) throw std::runtime_error("encabezado Y4M sin W/H");
+    const size_t cw2 = (size_t)(f.w + 1) / 2, ch2 = (size_t)(f.h + 1) / 2;
+    const size_t wh = (size_t)f.w * f.h;
+    // 420p10, monop12, ...: mas de 8 bits por muestra
+    const size_t pd = cs.find('p');
+    if (pd != std::string::npos && pd + 1 < cs.size() && std::isdigit((unsigned char)cs[pd + 1])) throw std::runtime_error("Y4M de mas de 8 bits no soportado: C" + cs);
+    if (cs.rfind("420", 0) == 0) f.chroma_bytes = 2 * cw2 * ch2;
+    else if (cs == "422") f.chroma_bytes = 2 * cw2 * f.h;
+    else if (cs == "411") f.chroma_bytes = 2 * ((size_t)(f.w + 3) / 4) * f.h;
+    else if (cs == "444") f.chroma_bytes = 2 * wh;
+    else if (cs == "444alpha") f.chroma_bytes = 3 * wh;
+    else if (cs == "mono") f.chroma_bytes = 0;
+    else throw std::runtime_error("espacio de color Y4M no soportado: C" + cs);
+    return f;
+}
+
+// Mira el comienzo de la entrada: si es Y4M consume el encabezado y
+// devuelve su formato; si no, devuelve raw (sin consumir nada)
+static inline frame_format detect_frame_format(fd_reader &in, const frame_format &raw) {
+    uint8_t magic[10];
+    if (in.peek(magic, 10) == 10 && std::memcmp(magic, "YUV4MPEG2 ", 10) == 0) {
+        std::string line;
+        in.read_line(line);
+        return parse_y4m_header(line);
+    }
+    return raw;
+}
+
+// Histograma logaritmico de latencias: 8 cubetas por octava desde 1 us
+// (error < 9%) hasta 2^32 us; lo de arriba cae en la ultima. El maximo se
+// guarda exacto. add() no reserva memoria.
+struct latency_histogram {
+    static const int PER_OCTAVE = 8;
+    static const int BUCKETS = 32 * PER_OCTAVE;
+
+    std::array<uint64_t, BUCKETS> count{};
+    uint64_t total = 0;
+    double max_ms = 0;
+
+    void add(double ms) {
+        const double us = ms * 1e3;
+        int b = us > 1.0 ? (int)(std::log2(us) * PER_OCTAVE) : 0;
+        ++count[std::min(b, BUCKETS - 1)];
+        ++total;
+        max_ms = std::max(max_ms, ms);
+    }
+
+    // Borde de arriba de la cubeta donde cae el percentil p (0..1), sin
+    // pasarse del maximo
+    double pct(double p) const {
+        if (!total) return 0.0;
+        const uint64_t k = std::max<uint64_t>(1, (uint64_t)std::ceil(p * total));
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += count[b];
+            if (seen >= k) return std::min(max_ms, std::exp2((b + 1.0) / PER_OCTAVE) / 1e3);
+        }
+        return max_ms;
+    }
+};
+
+struct frame_stream_stats {
+    long frames = 0;
+    int in_w = 0, in_h = 0, out_w = 0, out_h = 0;
+    double wall_ms = 0;
+    double read_ms = 0, compute_ms = 0, write_ms = 0;   // tiempo de cada etapa
+    latency_histogram latency;                          // por cuadro
+
+    double fps() const { return wall_ms > 0 ? frames * 1e3 / wall_ms : 0.0; }
+    double latency_pct(double p) const { return latency.pct(p); }
+};
+
+// Corre la secuencia de in_fd a out_fd a escala scale (semantica del
+// golden). raw: formato si la entrada no es Y4M (w, h y chans).
+static inline frame_stream_stats run_frame_stream(int in_fd, int out_fd, const frame_format &raw,
+                                                  double scale, int queue_depth,
+                                                  thread_pool &pool) {
+    using clk = std::chrono::steady_clock;
+    auto ms_since = [](clk::time_point t) {
+        return std::chrono::duration<double, std::milli>(clk::now() - t).count();
+    };
+
+    fd_reader in(in_fd);
+    const frame_format f = detect_frame_format(in, raw);
+    if (f.w <= 0 || f.h <= 0) throw std::runtime_error("faltan W y H para cuadros RAW");
+
+    frame_stream_stats st;
+    st.in_w = f.w;
+    st.in_h = f.h;
+    golden_out_dims(f.w, f.h, scale, st.out_w, st.out_h);
+
+    struct slot {
+        std::vector<uint8_t> in, out;
+        clk::time_point t_in;
+    };
+    const int n = std::max(2, queue_depth);
+    std::vector<slot> slots(n);
+    for (slot &s : slots) {
+        s.in.resize((size_t)f.w * f.h * f.chans);
+        s.out.resize((size_t)st.out_w * st.out_h * f.chans);
+    }
+    // cada cola tiene que poder tener todos los slots mas el fin (-1)
+    spsc_queue<int> free_q(n + 1), filled_q(n + 1), done_q(n + 1);
+    for (int i = 0; i < n; ++i) free_q.push(i);
+
+    downscale_arena arena;
+    arena.reserve(f.w, st.out_w, st.out_h, f.chans, pool.size() * 4);
+
+    std::atomic<bool> stop{false};
+    std::string read_err, write_err;
+
+    if (f.y4m) {
+        const std::string hdr = "YUV4MPEG2 W" + std::to_string(st.out_w) + " H" +
+                                std::to_string(st.out_h) + f.params + " Cmono\n";
+        write_view(out_fd, make_view((const uint8_t *)hdr.data(), (int)hdr.size(), 1));
+    }
+
+    const auto t0 = clk::now();
+
+    std::thread reader([&] {
+        std::vector<uint8_t> skip_buf;
+        std::string line;
+        long n_read = 0;
+        try {
+            for (;;) {
+                int s;
+                free_q.pop(s);
+                if (stop.load(std::memory_order_relaxed)) break;
+                const auto tr = clk::now();
+                if (f.y4m) {
+                    if (!in.read_line(line)) break;
+                    if (line.compare(0, 5, "FRAME") != 0)
+                        throw std::runtime_error("se esperaba FRAME en el cuadro " +
+                                                 std::to_string(n_read));
+                }
+                const size_t bytes = slots[s].in.size();
+                const size_t got = in.read(slots[s].in.data(), bytes);
+                if (got == 0 && !f.y4m) break;
+                if (got < bytes || in.skip(f.chroma_bytes, skip_buf) < f.chroma_bytes)
+                    throw std::runtime_error("cuadro " + std::to_string(n_read) +
+                                             " incompleto en la entrada (" +
+                                             std::to_string(got) + " de " +
+                                             std::to_string(bytes) + " bytes de luma)");
+                slots[s].t_in = clk::now();
+                st.read_ms += std::chrono::duration<double, std::milli>(slots[s].t_in - tr).count();
+                ++n_read;
+                filled_q.push(s);
+            }
+        } catch (const std::exception &e) {
+            read_err = e.what();
+        }
+        filled_q.push(-1);
+    });
+
+    std::thread writer([&] {
+        static const char frame_hdr[] = "FRAME\n";
+        for (;;) {
+            int s;
+            done_q.pop(s);
+            if (s < 0) break;
+            if (write_err.empty()) {
+                const auto tw = clk::now();
+                try {
+                    if (f.y4m)
+                        write_view(out_fd, make_view((const uint8_t *)frame_hdr, 6, 1));
+                    write_view(out_fd, make_view(slots[s].out.data(), st.out_w, st.out_h, f.chans));
+                } catch (const std::exception &e) {
+                    write_err = e.what();
+                    stop.store(true);
+                }
+                st.write_ms += ms_since(tw);
+                st.latency.add(ms_since(slots[s].t_in));
+            }
+            // el slot vuelve aunque haya fallado, para que el lector no se trabe
+            free_q.push(s);
+        }
+    });
+
+    // calculo en este hilo (y en el pool)
+    for (;;) {
+        int s;
+        filled_q.pop(s);
+        if (s < 0) {
+            done_q.push(-1);
+            break;
+        }
+        const auto tc = clk::now();
+        downscale_bilinear_u8_view(make_view(slots[s].in.data(), f.w, f.h, f.chans), scale,
+                                   make_mut_view(slots[s].out.data(), st.out_w, st.out_h, f.chans),
+                                   arena, &pool);
+        st.compute_ms += ms_since(tc);
+        ++st.frames;
+        done_q.push(s);
+    }
+
+    reader.join();
+    writer.join();
+    st.wall_ms = ms_since(t0);
+    if (!read_err.empty()) throw std::runtime_error(read_err);
+    if (!write_err.empty()) throw std::runtime_error(write_err);
+    return st;
+}
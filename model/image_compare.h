@@ -0,0 +1,254 @@
+// model/image_compare.h
+// Comparacion de imagenes de 8 bits con estadisticas de error.
+//
+//  - compare_u8: compara la ventana comun de dos imagenes (a es aw x ah, b es
+//    bw x bh) y devuelve pixeles distintos, error absoluto maximo y medio,
+//    MSE/PSNR, histograma del error, la caja que encierra todos los
+//    mismatches, una caja por tramo de filas seguidas con mismatches y los
+//    primeros mismatches en orden de barrido.
+//  - write_diff_pgm: |a - b| (por un factor, saturado) como PGM, para ver
+//    donde estan las diferencias.
+//
+// Lo usan pc/compare_raw (make compare_top) y dsa_jtag_driver. Cada fila
+// se recorre con SSE4.1/AVX2 (mismo despacho que downscale_kernels.h): |a-b|
+// con dos restas saturadas, y solo los bloques de 16/32 bytes con algun
+// byte distinto pagan las sumas, el histograma y las cajas, asi que dos
+// imagenes iguales se comparan a velocidad de memcmp. Con color se pasa
+// W*chans como ancho.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "downscale_kernels.h"
+#include "image_io.h"
+
+// Rectangulo [x0, x1] x [y0, y1] (inclusive) con los mismatches que encierra
+struct diff_box {
+    int x0 = -1, y0 = -1, x1 = -1, y1 = -1;
+    uint64_t mismatches = 0;
+};
+
+struct diff_pixel {
+    int x, y;
+    uint8_t a, b;
+};
+
+struct compare_stats {
+    int w = 0, h = 0;           // ventana comparada
+    bool same_dims = true;
+    uint64_t pixels = 0, mismatches = 0;
+    int max_err = 0;
+    uint64_t sum_abs = 0, sum_sq = 0;
+    uint64_t hist[256] = {};    // pixeles por error absoluto (hist[0] = iguales)
+    diff_box bbox;              // todos los mismatches
+    std::vector<diff_box> boxes;   // una por tramo de filas seguidas
+    bool boxes_truncated = false;
+    std::vector<diff_pixel> first; // los primeros, en orden de barrido
+
+    double mean_abs() const { return pixels ? (double)sum_abs / pixels : 0.0; }
+    double mse() const { return pixels ? (double)sum_sq / pixels : 0.0; }
+    // PSNR con pico 255; infinito si son iguales
+    double psnr() const {
+        const double m = mse();
+        return m > 0 ? 10.0 * std::log10(255.0 * 255.0 / m) : INFINITY;
+    }
+    bool equal() const { return same_dims && mismatches == 0; }
+};
+
+struct compare_options {
+    int max_list = 20;      // mismatches que se guardan en first
+    int max_boxes = 64;     // tramos de filas; despues se marca boxes_truncated
+    simd_level lvl = default_simd_level();
+};
+
+// Acumulado de una fila
+struct row_diff {
+    uint64_t mismatches = 0, sum_abs = 0, sum_sq = 0;
+    int max_err = 0;
+    int first_x = -1, last_x = -1;
+};
+
+static inline void compare_bytes_scalar(const uint8_t *a, const uint8_t *b, int x, int n,
+                                        uint64_t *hist, row_diff &r) {
+    for (; x < n; ++x) {
+        const int d = std::abs((int)a[x] - (int)b[x]);
+        if (!d) continue;
+        ++r.mismatches;
+        r.sum_abs += d;
+        r.sum_sq += (uint64_t)d * d;
+        r.max_err = std::max(r.max_err, d);
+        ++hist[d];
+        if (r.first_x < 0) r.first_x = x;
+        r.last_x = x;
+    }
+}
+
+#if DSA_HAVE_X86
+// Un bloque con mascara m de bytes distintos: histograma y extremos (las
+// sumas van en registros)
+static inline void note_block(const uint8_t *d, int base, uint32_t m, uint64_t *hist,
+                              row_diff &r) {
+    r.mismatches += __builtin_popcount(m);
+    if (r.first_x < 0) r.first_x = base + __builtin_ctz(m);
+    r.last_x = base + 31 - __builtin_clz(m);
+    for (; m; m &= m - 1) ++hist[d[__builtin_ctz(m)]];
+}
+
+// Cada lane de 32 bits de la suma de cuadrados junta a lo sumo 4*255^2 por
+// bloque; se vuelca a 64 bits cada SQ_FLUSH bloques con diferencias
+static constexpr int SQ_FLUSH = 4096;
+
+__attribute__((target("sse4.1")))
+static inline uint64_t hsum_epi32_u64(__m128i v) {
+    alignas(16) uint32_t t[4];
+    _mm_store_si128((__m128i *)t, v);
+    return (uint64_t)t[0] + t[1] + t[2] + t[3];
+}
+
+__attribute__((target("sse4.1")))
+static inline void compare_row_sse41(const uint8_t *a, const uint8_t *b, int n,
+                                     uint64_t *hist, row_diff &r) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vmax = zero, vsad = zero, vsq = zero;
+    alignas(16) uint8_t d[16];
+    int x = 0, pending = 0;
+    for (; x + 16 <= n; x += 16) {
+        const __m128i va = _mm_loadu_si128((const __m128i *)(a + x));
+        const __m128i vb = _mm_loadu_si128((const __m128i *)(b + x));
+        const __m128i vd = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        const uint32_t m = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(vd, zero)) & 0xFFFFu;
+        if (!m) continue;
+        vmax = _mm_max_epu8(vmax, vd);
+        vsad = _mm_add_epi64(vsad, _mm_sad_epu8(vd, zero));
+        const __m128i lo = _mm_unpacklo_epi8(vd, zero), hi = _mm_unpackhi_epi8(vd, zero);
+        vsq = _mm_add_epi32(vsq, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+        if (++pending == SQ_FLUSH) {
+            r.sum_sq += hsum_epi32_u64(vsq);
+            vsq = zero;
+            pending = 0;
+        }
+        _mm_store_si128((__m128i *)d, vd);
+        note_block(d, x, m, hist, r);
+    }
+    r.sum_sq += hsum_epi32_u64(vsq);
+    r.sum_abs += (uint64_t)_mm_cvtsi128_si64(vsad) + (uint64_t)_mm_extract_epi64(vsad, 1);
+    alignas(16) uint8_t mx[16];
+    _mm_store_si128((__m128i *)mx, vmax);
+    r.max_err = std::max(r.max_err, (int)*std::max_element(mx, mx + 16));
+    compare_bytes_scalar(a, b, x, n, hist, r);
+}
+
+__attribute__((target("avx2")))
+static inline void compare_row_avx2(const uint8_t *a, const uint8_t *b, int n,
+                                    uint64_t *hist, row_diff &r) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i vmax = zero, vsad = zero, vsq = zero;
+    alignas(32) uint8_t d[32];
+    int x = 0, pending = 0;
+    for (; x + 32 <= n; x += 32) {
+        const __m256i va = _mm256_loadu_si256((const __m256i *)(a + x));
+        const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + x));
+        const __m256i vd = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+        const uint32_t m = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(vd, zero));
+        if (!m) continue;
+        vmax = _mm256_max_epu8(vmax, vd);
+        vsad = _mm256_add_epi64(vsad, _mm256_sad_epu8(vd, zero));
+        const __m256i lo = _mm256_unpacklo_epi8(vd, zero), hi = _mm256_unpackhi_epi8(vd, zero);
+        vsq = _mm256_add_epi32(vsq, _mm256_add_epi32(_mm256_madd_epi16(lo, lo),
+                                                     _mm256_madd_epi16(hi, hi)));
+        if (++pending == SQ_FLUSH) {
+            r.sum_sq += hsum_epi32_u64(_mm256_castsi256_si128(vsq)) +
+                        hsum_epi32_u64(_mm256_extracti128_si256(vsq, 1));
+            vsq = zero;
+            pending = 0;
+        }
+        _mm256_store_si256((__m256i *)d, vd);
+        note_block(d, x, m, hist, r);
+    }
+    r.sum_sq += hsum_epi32_u64(_mm256_castsi256_si128(vsq)) +
+                hsum_epi32_u64(_mm256_extracti128_si256(vsq, 1));
+    alignas(32) uint64_t s[4];
+    _mm256_store_si256((__m256i *)s, vsad);
+    r.sum_abs += s[0] + s[1] + s[2] + s[3];
+    alignas(32) uint8_t mx[32];
+    _mm256_store_si256((__m256i *)mx, vmax);
+    r.max_err = std::max(r.max_err, (int)*std::max_element(mx, mx + 32));
+    compare_bytes_scalar(a, b, x, n, hist, r);
+}
+#endif
+
+static inline void compare_row(const uint8_t *a, const uint8_t *b, int n, uint64_t *hist,
+                               row_diff &r, simd_level lvl) {
+#if DSA_HAVE_X86
+    if (lvl == simd_level::avx2) return compare_row_avx2(a, b, n, hist, r);
+    if (lvl == simd_level::sse41) return compare_row_sse41(a, b, n, hist, r);
+#endif
+    (void)lvl;
+    compare_bytes_scalar(a, b, 0, n, hist, r);
+}
+
+// Compara la ventana comun de a (aw x ah) y b (bw x bh)
+static inline compare_stats compare_u8(const uint8_t *a, int aw, int ah,
+                                       const uint8_t *b, int bw, int bh,
+                                       const compare_options &opt = compare_options()) {
+    compare_stats s;
+    s.w = std::min(aw, bw);
+    s.h = std::min(ah, bh);
+    s.same_dims = aw == bw && ah == bh;
+    s.pixels = (uint64_t)std::max(0, s.w) * std::max(0, s.h);
+
+    for (int y = 0; y < s.h; ++y) {
+        const uint8_t *ra = a + (size_t)y * aw, *rb = b + (size_t)y * bw;
+        row_diff r;
+        compare_row(ra, rb, s.w, s.hist, r, opt.lvl);
+        if (!r.mismatches) continue;
+
+        s.mismatches += r.mismatches;
+        s.sum_abs += r.sum_abs;
+        s.sum_sq += r.sum_sq;
+        s.max_err = std::max(s.max_err, r.max_err);
+
+        if (s.bbox.y0 < 0) {
+            s.bbox = {r.first_x, y, r.last_x, y, 0};
+        } else {
+            s.bbox.x0 = std::min(s.bbox.x0, r.first_x);
+            s.bbox.x1 = std::max(s.bbox.x1, r.last_x);
+            s.bbox.y1 = y;
+        }
+        s.bbox.mismatches += r.mismatches;
+
+        diff_box *last = s.boxes.empty() ? nullptr : &s.boxes.back();
+        if (last && last->y1 == y - 1) {
+            last->x0 = std::min(last->x0, r.first_x);
+            last->x1 = std::max(last->x1, r.last_x);
+            last->y1 = y;
+            last->mismatches += r.mismatches;
+        } else if ((int)s.boxes.size() < opt.max_boxes) {
+            s.boxes.push_back({r.first_x, y, r.last_x, y, r.mismatches});
+        } else {
+            s.boxes_truncated = true;
+        }
+
+        for (int x = r.first_x; x <= r.last_x && (int)s.first.size() < opt.max_list; ++x)
+            if (ra[x] != rb[x]) s.first.push_back({x, y, ra[x], rb[x]});
+    }
+    s.hist[0] = s.pixels - s.mismatches;
+    return s;
+}
+
+// |a - b| * gain (saturado a 255) de la ventana comun, como PGM
+static inline void write_diff_pgm(const std::string &path, const uint8_t *a, int aw,
+                                  const uint8_t *b, int bw, int w, int h, int gain = 1) {
+    mapped_output out = map_output_u8(path, w, h, /*pgm=*/true);
+    for (int y = 0; y < h; ++y) {
+        const uint8_t *ra = a + (size_t)y * aw, *rb = b + (size_t)y * bw;
+        uint8_t *o = out.pix + (size_t)y * w;
+        for (int x = 0; x < w; ++x)
+            o[x] = (uint8_t)std::min(255, std::abs((int)ra[x] - (int)rb[x]) * gain);
+    }
+}
@@ -0,0 +1,323 @@
+// model/image_io.h
+// E/S de imagenes de 8 bits sobre mmap, sin copias intermedias.
+//
+//  - map_image_u8:  abre un RAW (W y H dados), un PGM P5 o un PPM P6 (W y H
+//                   salen del encabezado) y deja los píxeles mapeados en su
+//                   lugar.
+//  - map_output_u8: crea un RAW, PGM o PPM del tamaño exacto, mapeado para
+//                   escritura; el kernel escribe directo en el page cache.
+//
+// Las imagenes de color van intercaladas (RGBRGB... o RGBARGBA...): chans
+// bytes por píxel, W*chans por fila. Un RAW no dice cuantos canales tiene,
+// asi que los da quien llama; el PPM siempre es de 3.
+//
+// Si el archivo no se puede mapear (tuberia, /dev/stdin, ...) se cae a una
+// lectura normal a un buffer propio; la interfaz es la misma.
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Archivo mapeado (o buffer propio como respaldo), dueño del mapeo
+class mapped_file {
+public:
+    mapped_file() = default;
+    ~mapped_file() { reset(); }
+
+    mapped_file(mapped_file &&o) noexcept { *this = std::move(o); }
+    mapped_file &operator=(mapped_file &&o) noexcept {
+        if (this != &o) {
+            reset();
+            ptr_ = o.ptr_; size_ = o.size_; mapped_ = o.mapped_;
+            buf_ = std::move(o.buf_);
+            if (!mapped_ && !buf_.empty()) ptr_ = buf_.data();
+            o.ptr_ = nullptr; o.size_ = 0; o.mapped_ = false;
+        }
+        return *this;
+    }
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    // Solo lectura. seq = acceso secuencial (pide readahead al kernel).
+    static mapped_file open_read(const std::string &path, bool seq = true) {
+        mapped_file m;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("no se pudo abrir archivo de entrada " + path);
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void *p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                if (seq) ::madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+                m.ptr_ = static_cast<uint8_t *>(p);
+                m.size_ = (size_t)st.st_size;
+                m.mapped_ = true;
+                ::close(fd);
+                return m;
+            }
+        }
+        // respaldo: leer todo (tuberias, archivos especiales)
+        uint8_t chunk[1 << 16];
+        ssize_t n;
+        while ((n = ::read(fd, chunk, sizeof(chunk))) > 0)
+            m.buf_.insert(m.buf_.end(), chunk, chunk + n);
+        ::close(fd);
+        if (n < 0) throw std::runtime_error("fallo al leer " + path);
+        m.ptr_ = m.buf_.data();
+        m.size_ = m.buf_.size();
+        return m;
+    }
+
+    // Crea (o trunca) un archivo de exactamente size bytes, mapeado RW
+    static mapped_file create(const std::string &path, size_t size) {
+        mapped_file m;
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error("no se pudo abrir archivo de salida " + path);
+        if (::ftruncate(fd, (off_t)size) != 0) {
+            ::close(fd);
+            throw std::runtime_error("no se pudo dimensionar " + path);
+        }
+        void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("no se pudo mapear " + path);
+        m.ptr_ = static_cast<uint8_t *>(p);
+        m.size_ = size;
+        m.mapped_ = true;
+        return m;
+    }
+
+    const uint8_t *data() const { return ptr_; }
+    uint8_t *data() { return ptr_; }
+    size_t size() const { return size_; }
+    bool is_mapped() const { return mapped_; }
+
+    // Copia a un buffer propio de n bytes rellenando con 0 lo que falte
+    void pad_to(size_t n) {
+        if (size_ >= n) return;
+        std::vector<uint8_t> b(n, 0);
+        if (size_) std::memcpy(b.data(), ptr_, size_);
+        reset();
+        buf_ = std::move(b);
+        ptr_ = buf_.data();
+        size_ = n;
+    }
+
+private:
+    void reset() {
+        if (mapped_ && ptr_) ::munmap(ptr_, size_);
+        ptr_ = nullptr; size_ = 0; mapped_ = false;
+        buf_.clear();
+    }
+
+    uint8_t *ptr_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> buf_;
+};
+
+// Imagen de entrada: píxeles en el mapeo, despues del encabezado si es PGM/PPM
+struct mapped_image {
+    mapped_file file;
+    const uint8_t *pix = nullptr;
+    int w = 0, h = 0;
+    int chans = 1;    // bytes por píxel (1 gris, 3 RGB, 4 RGBA)
+    bool pgm = false; // traia encabezado (P5 o P6)
+    size_t got = 0;   // bytes de píxeles que traia el archivo (antes de rellenar)
+};
+
+// Parsea un encabezado P5 o P6 ("P5 W H maxval" + un blanco, con
+// comentarios #). Devuelve el offset de los píxeles o 0 si no es un PGM/PPM
+// binario; chans queda en 1 (P5) o 3 (P6).
+static inline size_t parse_pnm_header(const uint8_t *p, size_t n, int &w, int &h, int &chans) {
+    if (n < 2 || p[0] != 'P' || (p[1] != '5' && p[1] != '6')) return 0;
+    chans = p[1] == '6' ? 3 : 1;
+    size_t i = 2;
+    int vals[3] = {0, 0, 0};
+    for (int k = 0; k < 3; ++k) {
+        // saltar blancos y comentarios
+        for (;;) {
+            while (i < n && (p[i] == ' ' || p[i] == '\t' || p[i] == '\r' || p[i] == '\n')) ++i;
+            if (i < n && p[i] == '#') {
+                while (i < n && p[i] != '\n') ++i;
+                continue;
+            }
+            break;
+        }
+        if (i >= n || p[i] < '0' || p[i] > '9')
+            throw std::runtime_error("encabezado PGM invalido");
+        long v = 0;
+        while (i < n && p[i] >= '0' && p[i] <= '9') {
+            v = v * 10 + (p[i] - '0');
+            if (v > (1L << 30)) throw std::runtime_error("encabezado PGM invalido");
+            ++i;
+        }
+        vals[k] = (int)v;
+    }
+    if (i >= n) throw std::runtime_error("PGM sin datos");
+    ++i; // un solo blanco antes de los datos
+    if (vals[2] <= 0 || vals[2] > 255)
+        throw std::runtime_error("PGM con maxval distinto de 8 bits");
+    w = vals[0];
+    h = vals[1];
+    return i;
+}
+
+// Solo P5 (gris): 0 tambien si es un PPM
+static inline size_t parse_pgm_header(const uint8_t *p, size_t n, int &w, int &h) {
+    int chans = 1;
+    size_t off = parse_pnm_header(p, n, w, h, chans);
+    return chans == 1 ? off : 0;
+}
+
+static inline bool has_ext(const std::string &path, const char *ext) {
+    if (path.size() < 4) return false;
+    std::string e = path.substr(path.size() - 4);
+    for (auto &c : e) c = (char)std::tolower((unsigned char)c);
+    return e == ext;
+}
+
+static inline bool has_pgm_ext(const std::string &path) { return has_ext(path, ".pgm"); }
+static inline bool has_pnm_ext(const std::string &path) {
+    return has_ext(path, ".pgm") || has_ext(path, ".ppm");
+}
+
+// Encabezado P5/P6 para una salida; PPM no tiene alfa
+static inline std::string pnm_header(int W, int H, int chans) {
+    if (chans != 1 && chans != 3)
+        throw std::runtime_error("PGM/PPM solo con 1 o 3 canales (hay " + std::to_string(chans) + ")");
+    return std::string(chans == 1 ? "P5" : "P6") + "\n" + std::to_string(W) + " " +
+           std::to_string(H) + "\n255\n";
+}
+
+// Abre RAW, PGM o PPM. Se trata como PGM/PPM si termina en .pgm/.ppm o si no
+// se dieron W y H (un RAW puede empezar con los bytes "P5" por casualidad).
+// Con encabezado, W y H salen de ahi y, si vienen, deben coincidir.
+// chans: canales del RAW; 0 = los del encabezado (o 1 si es RAW). Si no es
+// 0 y el archivo trae otro numero de canales, falla.
+// pad_short: un RAW corto se copia y se rellena con 0 en vez de fallar
+// (lo que hacia load_raw del driver).
+static inline mapped_image map_image_u8(const std::string &path, int W, int H,
+                                        bool pad_short = false, int chans = 1) {
+    mapped_image img;
+    img.file = mapped_file::open_read(path);
+    int pw = 0, ph = 0, pc = 1;
+    size_t off = 0;
+    if (has_pnm_ext(path) || (W == 0 && H == 0))
+        off = parse_pnm_header(img.file.data(), img.file.size(), pw, ph, pc);
+    if (off) {
+        if ((W && W != pw) || (H && H != ph))
+            throw std::runtime_error("el PGM/PPM es " + std::to_string(pw) + "x" +
+                                     std::to_string(ph) + ", no coincide con --w/--h");
+        if (chans && chans != pc)
+            throw std::runtime_error(path + " tiene " + std::to_string(pc) + " canal(es), se esperaban " +
+                                     std::to_string(chans));
+        img.pgm = true;
+        W = pw;
+        H = ph;
+        chans = pc;
+    }
+    if (W <= 0 || H <= 0)
+        throw std::runtime_error("faltan W y H para el RAW " + path);
+    if (chans == 0) chans = 1;
+
+    const size_t bytes = (size_t)W * H * chans;
+    const size_t need = off + bytes;
+    img.got = std::min(img.file.size() - off, bytes);
+    if (img.file.size() < need) {
+        if (!pad_short || img.pgm)
+            throw std::runtime_error("tamano incorrecto en " + path + " (se esperaba W*H*canales)");
+        img.file.pad_to(need);
+    }
+    img.pix = img.file.data() + off;
+    img.w = W;
+    img.h = H;
+    img.chans = chans;
+    return img;
+}
+
+// true si a y b son el mismo archivo (mismo dispositivo e inodo). La salida
+// se abre con O_TRUNC y se redimensiona, asi que escribir sobre la entrada
+// mapeada la pisa mientras se lee (o da SIGBUS si se achica).
+static inline bool same_file(const std::string &a, const std::string &b) {
+    struct stat sa, sb;
+    return ::stat(a.c_str(), &sa) == 0 && ::stat(b.c_str(), &sb) == 0 &&
+           sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+// Salida mapeada: RAW (solo píxeles) o PGM/PPM (encabezado + píxeles)
+struct mapped_output {
+    mapped_file file;
+    uint8_t *pix = nullptr;
+};
+
+static inline mapped_output map_output_u8(const std::string &path, int W, int H,
+                                          bool pgm = false, int chans = 1) {
+    std::string hdr;
+    if (pgm) hdr = pnm_header(W, H, chans);
+    mapped_output o;
+    o.file = mapped_file::create(path, hdr.size() + (size_t)W * H * chans);
+    std::memcpy(o.file.data(), hdr.data(), hdr.size());
+    o.pix = o.file.data() + hdr.size();
+    return o;
+}
+
+// Para lotes de imagenes chicas (--manifest) sale mas barato un read/write
+// sobre buffers reutilizados que un mmap/munmap por archivo: cada munmap
+// con varios hilos vivos fuerza un TLB shootdown en todos los núcleos.
+
+// Lee el archivo completo en buf (reutiliza su capacidad). Devuelve los bytes.
+static inline size_t read_file_into(const std::string &path, std::vector<uint8_t> &buf) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("no se pudo abrir archivo de entrada " + path);
+    struct stat st;
+    size_t n = 0;
+    // archivo regular: se lee justo su tamaño; si no, hasta EOF creciendo
+    const bool known = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (known && buf.size() < (size_t)st.st_size) buf.resize((size_t)st.st_size);
+    for (;;) {
+        if (known && n == (size_t)st.st_size) break;
+        if (n == buf.size()) buf.resize(std::max<size_t>(4096, buf.size() * 2));
+        ssize_t r = ::read(fd, buf.data() + n, buf.size() - n);
+        if (r < 0) {
+            ::close(fd);
+            throw std::runtime_error("fallo al leer " + path);
+        }
+        if (r == 0) break;
+        n += (size_t)r;
+    }
+    ::close(fd);
+    return n;
+}
+
+// Escribe un RAW o PGM/PPM (encabezado + píxeles) con write()
+static inline void write_image_u8(const std::string &path, const uint8_t *pix,
+                                  int W, int H, bool pgm = false, int chans = 1) {
+    std::string hdr;
+    if (pgm) hdr = pnm_header(W, H, chans);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("no se pudo abrir archivo de salida " + path);
+    const uint8_t *parts[2] = {(const uint8_t *)hdr.data(), pix};
+    size_t lens[2] = {hdr.size(), (size_t)W * H * chans};
+    for (int k = 0; k < 2; ++k) {
+        size_t off = 0;
+        while (off < lens[k]) {
+            ssize_t r = ::write(fd, parts[k] + off, lens[k] - off);
+            if (r <= 0) {
+                ::close(fd);
+                throw std::runtime_error("fallo al escribir " + path);
+            }
+            off += (size_t)r;
+        }
+    }
+    ::close(fd);
+}
@@ -0,0 +1,320 @@
+// model/perf_counters.h
+// Contadores de la CPU (perf_event_open de Linux) alrededor de los kernels.
+//
+// El unico perf que teniamos era PERF_CYC/PERF_PIX de la FPGA. Esto mide lo
+// mismo del lado de la CPU: ciclos, instrucciones, fallos de L1d y de LLC y
+// saltos mal predichos (mas task-clock y page faults, que son de software
+// y andan aunque no haya PMU) por banda de filas y por corrida, para sacar
+// ciclos/pixel y bytes/pixel comparables con los pixeles/ciclo del core.
+//
+//  - perf_counters: los eventos abiertos para el hilo que llama (pid 0,
+//    cualquier CPU, solo modo usuario). Cada evento va por separado: si la
+//    maquina no tiene uno (VM sin PMU, perf_event_paranoid alto) ese queda
+//    en -1 y los demas siguen. Si el kernel multiplexa, se escala por
+//    tiempo habilitado / tiempo corriendo.
+//  - perf_probe: junta las bandas de una corrida. Los motores por bandas
+//    reciben un perf_probe * opcional y envuelven cada banda en un
+//    perf_band_scope, que lee los contadores del hilo que la corre (cada
+//    hilo del pool abre los suyos la primera vez y los guarda).
+//
+// Sin probe (nullptr, lo normal) no se abre nada y el costo es un if por
+// banda; los lazos internos no cambian.
+//
+// bytes/pixel: el trafico nominal de la banda (filas de entrada que toca mas
+// la salida) sobre los pixeles de salida; con LLC, ademas, fallos * 64.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+enum perf_event_id {
+    PEV_CYCLES,
+    PEV_INSTRUCTIONS,
+    PEV_L1D_MISSES,
+    PEV_LLC_MISSES,
+    PEV_BRANCH_MISSES,
+    PEV_TASK_CLOCK,     // ns de CPU del hilo
+    PEV_PAGE_FAULTS,
+    PEV_COUNT
+};
+
+static const char *const PEV_NAMES[PEV_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses",
+    "task_clock_ns", "page_faults"};
+
+// Un valor por evento; -1 = no disponible
+struct perf_values {
+    int64_t v[PEV_COUNT];
+
+    perf_values() { std::fill(v, v + PEV_COUNT, (int64_t)-1); }
+
+    static perf_values zero() {
+        perf_values p;
+        std::fill(p.v, p.v + PEV_COUNT, (int64_t)0);
+        return p;
+    }
+
+    bool has(int e) const { return v[e] >= 0; }
+
+    // b - a; si falta en alguno de los dos, falta
+    static perf_values delta(const perf_values &a, const perf_values &b) {
+        perf_values d;
+        for (int e = 0; e < PEV_COUNT; ++e)
+            if (a.v[e] >= 0 && b.v[e] >= 0) d.v[e] = std::max<int64_t>(0, b.v[e] - a.v[e]);
+        return d;
+    }
+
+    void add(const perf_values &o) {
+        for (int e = 0; e < PEV_COUNT; ++e)
+            v[e] = (v[e] >= 0 && o.v[e] >= 0) ? v[e] + o.v[e] : -1;
+    }
+};
+
+// Eventos abiertos para un hilo
+class perf_counters {
+public:
+    perf_counters() {
+        static const struct { uint32_t type; uint64_t config; } ev[PEV_COUNT] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+        };
+        for (int e = 0; e < PEV_COUNT; ++e) {
+            struct perf_event_attr a;
+            std::memset(&a, 0, sizeof(a));
+            a.size = sizeof(a);
+            a.type = ev[e].type;
+            a.config = ev[e].config;
+            a.exclude_kernel = 1;   // con perf_event_paranoid >= 2 es lo unico permitido
+            a.exclude_hv = 1;
+            a.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fd_[e] = (int)::syscall(SYS_perf_event_open, &a, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        }
+    }
+
+    ~perf_counters() {
+        for (int fd : fd_)
+            if (fd >= 0) ::close(fd);
+    }
+
+    perf_counters(const perf_counters &) = delete;
+    perf_counters &operator=(const perf_counters &) = delete;
+
+    bool has(int e) const { return fd_[e] >= 0; }
+
+    perf_values read() const {
+        perf_values p;
+        for (int e = 0; e < PEV_COUNT; ++e) {
+            uint64_t r[3];   // valor, tiempo habilitado, tiempo corriendo
+            if (fd_[e] < 0 || ::read(fd_[e], r, sizeof(r)) != (ssize_t)sizeof(r) || !r[2])
+                continue;
+            p.v[e] = (int64_t)(r[2] < r[1] ? (double)r[0] * r[1] / r[2] : (double)r[0]);
+        }
+        return p;
+    }
+
+private:
+    int fd_[PEV_COUNT];
+};
+
+// Los contadores del hilo actual, abiertos la primera vez que se piden
+static inline perf_counters &thread_perf_counters() {
+    thread_local perf_counters c;
+    return c;
+}
+
+// Numero chico y estable por hilo, para el detalle de las bandas
+static inline unsigned perf_thread_index() {
+    static std::atomic<unsigned> next{0};
+    thread_local unsigned id = next++;
+    return id;
+}
+
+// Pixeles de salida y bytes nominales que mueve una banda
+struct perf_traffic {
+    uint64_t pixels = 0;
+    uint64_t bytes = 0;
+};
+
+struct perf_band {
+    int y0 = 0, y1 = 0;   // filas de salida [y0, y1)
+    unsigned thread = 0;
+    perf_traffic traffic;
+    perf_values v;
+};
+
+// Bandas de una corrida (se llena desde varios hilos)
+class perf_probe {
+public:
+    void reset() {
+        std::lock_guard<std::mutex> lk(m_);
+        bands_.clear();
+    }
+
+    void add_band(const perf_band &b) {
+        std::lock_guard<std::mutex> lk(m_);
+        bands_.push_back(b);
+    }
+
+    // En orden de filas
+    std::vector<perf_band> bands() const {
+        std::lock_guard<std::mutex> lk(m_);
+        std::vector<perf_band> b = bands_;
+        std::sort(b.begin(), b.end(),
+                  [](const perf_band &x, const perf_band &y) { return x.y0 < y.y0; });
+        return b;
+    }
+
+    perf_values total() const {
+        std::lock_guard<std::mutex> lk(m_);
+        perf_values t = perf_values::zero();
+        for (const perf_band &b : bands_) t.add(b.v);
+        return t;
+    }
+
+    perf_traffic traffic() const {
+        std::lock_guard<std::mutex> lk(m_);
+        perf_traffic t;
+        for (const perf_band &b : bands_) {
+            t.pixels += b.traffic.pixels;
+            t.bytes += b.traffic.bytes;
+        }
+        return t;
+    }
+
+private:
+    mutable std::mutex m_;
+    std::vector<perf_band> bands_;
+};
+
+// Mide la banda [y0, y1) mientras vive; con probe nulo no hace nada
+class perf_band_scope {
+public:
+    perf_band_scope(perf_probe *probe, int y0, int y1, const perf_traffic &traffic)
+        : probe_(probe) {
+        if (!probe_) return;
+        b_.y0 = y0;
+        b_.y1 = y1;
+        b_.thread = perf_thread_index();
+        b_.traffic = traffic;
+        t0_ = thread_perf_counters().read();
+    }
+
+    ~perf_band_scope() {
+        if (!probe_) return;
+        b_.v = perf_values::delta(t0_, thread_perf_counters().read());
+        probe_->add_band(b_);
+    }
+
+    perf_band_scope(const perf_band_scope &) = delete;
+    perf_band_scope &operator=(const perf_band_scope &) = delete;
+
+private:
+    perf_probe *probe_;
+    perf_band b_;
+    perf_values t0_;
+};
+
+// ---------------------------------------------------------------------------
+// Salida: JSON para meta.json / bench.json y una linea para la consola
+// ---------------------------------------------------------------------------
+
+// num / den por pixel, o -1 si falta
+static inline double perf_ratio(int64_t num, double den) {
+    return num >= 0 && den > 0 ? num / den : -1.0;
+}
+
+static inline void perf_json_num(std::ostream &f, double x) {
+    if (x < 0) f << "null";
+    else f << x;
+}
+
+// Los contadores crudos y las metricas por pixel, sin las llaves
+static inline void write_perf_fields(std::ostream &f, const perf_values &v,
+                                     const perf_traffic &t) {
+    const double px = (double)t.pixels;
+    for (int e = 0; e < PEV_COUNT; ++e) {
+        f << "\"" << PEV_NAMES[e] << "\": ";
+        if (v.has(e)) f << v.v[e];
+        else f << "null";
+        f << ", ";
+    }
+    f << "\"pixels\": " << t.pixels << ", \"bytes\": " << t.bytes;
+    f << ", \"cycles_per_pixel\": ";
+    perf_json_num(f, perf_ratio(v.v[PEV_CYCLES], px));
+    f << ", \"instructions_per_pixel\": ";
+    perf_json_num(f, perf_ratio(v.v[PEV_INSTRUCTIONS], px));
+    f << ", \"ipc\": ";
+    perf_json_num(f, v.has(PEV_CYCLES) ? perf_ratio(v.v[PEV_INSTRUCTIONS], (double)v.v[PEV_CYCLES]) : -1);
+    f << ", \"l1d_misses_per_pixel\": ";
+    perf_json_num(f, perf_ratio(v.v[PEV_L1D_MISSES], px));
+    f << ", \"llc_misses_per_pixel\": ";
+    perf_json_num(f, perf_ratio(v.v[PEV_LLC_MISSES], px));
+    f << ", \"branch_misses_per_pixel\": ";
+    perf_json_num(f, perf_ratio(v.v[PEV_BRANCH_MISSES], px));
+    f << ", \"ns_per_pixel\": ";
+    perf_json_num(f, perf_ratio(v.v[PEV_TASK_CLOCK], px));
+    f << ", \"bytes_per_pixel\": ";
+    perf_json_num(f, px > 0 ? t.bytes / px : -1);
+    f << ", \"llc_bytes_per_pixel\": ";
+    perf_json_num(f, v.has(PEV_LLC_MISSES) ? perf_ratio(v.v[PEV_LLC_MISSES] * 64, px) : -1);
+}
+
+// {totales..., "bands": [{y0, y1, thread, ...}, ...]}
+static inline void write_probe_json(std::ostream &f, const perf_probe &p,
+                                    const std::string &indent) {
+    const std::vector<perf_band> bands = p.bands();
+    f << "{";
+    write_perf_fields(f, p.total(), p.traffic());
+    f << ",\n" << indent << "  \"bands\": [\n";
+    for (size_t i = 0; i < bands.size(); ++i) {
+        const perf_band &b = bands[i];
+        f << indent << "    {\"y0\": " << b.y0 << ", \"y1\": " << b.y1
+          << ", \"thread\": " << b.thread << ", ";
+        write_perf_fields(f, b.v, b.traffic);
+        f << "}" << (i + 1 < bands.size() ? ",\n" : "\n");
+    }
+    f << indent << "  ]}";
+}
+
+// "3.21 ciclos/px, 5.10 instr/px (IPC 1.59), L1d 0.120/px, LLC 0.010/px,
+//  saltos 0.001/px, 2.3 bytes/px"; lo que falta va como "-"
+static inline std::string perf_summary_line(const perf_values &v, const perf_traffic &t) {
+    const double px = (double)t.pixels;
+    auto num = [](double x, const char *fmt) {
+        if (x < 0) return std::string("-");
+        char s[32];
+        std::snprintf(s, sizeof(s), fmt, x);
+        return std::string(s);
+    };
+    std::string s = num(perf_ratio(v.v[PEV_CYCLES], px), "%.2f") + " ciclos/px, " +
+                    num(perf_ratio(v.v[PEV_INSTRUCTIONS], px), "%.2f") + " instr/px (IPC " +
+                    num(v.has(PEV_CYCLES) ? perf_ratio(v.v[PEV_INSTRUCTIONS], (double)v.v[PEV_CYCLES]) : -1,
+                        "%.2f") + "), L1d " +
+                    num(perf_ratio(v.v[PEV_L1D_MISSES], px), "%.3f") + "/px, LLC " +
+                    num(perf_ratio(v.v[PEV_LLC_MISSES], px), "%.3f") + "/px, saltos " +
+                    num(perf_ratio(v.v[PEV_BRANCH_MISSES], px), "%.3f") + "/px, " +
+                    num(px > 0 ? t.bytes / px : -1, "%.2f") + " bytes/px, " +
+                    num(perf_ratio(v.v[PEV_TASK_CLOCK], px), "%.2f") + " ns/px";
+    if (!v.has(PEV_CYCLES))
+        s += " (sin contadores de HW: VM sin PMU o perf_event_paranoid)";
+    return s;
+}
@@ -0,0 +1,351 @@
+// model/result_cache.h
+// Cache en disco de salidas de referencia, direccionada por contenido.
+//
+// La clave es un hash de 64 bits de los pixeles de entrada mas W, H, canales
+// y la semantica del modelo (golden bilineal con su escala en double, o el
+// Q8.8 del HW bilineal/box con scale_q8_8), asi que una entrada que no
+// cambio no se vuelve a calcular aunque cambie de nombre o de carpeta. Si
+// cambia el comportamiento de un kernel hay que subir RESULT_CACHE_VERSION.
+//
+// Cada resultado es un archivo <clave en hex>.bin con un encabezado corto
+// (magic, clave, W, H, canales y hash de la salida) y los pixeles de
+// salida. Se escribe a un temporal en la misma carpeta y se publica con
+// rename(), que es atomico: varios procesos (o hilos) pueden compartir la
+// carpeta sin candados y un lector nunca ve un archivo a medias. Si dos
+// escriben la misma clave gana cualquiera, son los mismos bytes.
+//
+// LRU por mtime: cada acierto toca el archivo (futimens) y, cuando el total
+// pasa de max_bytes, se borran los mas viejos hasta quedar en el 90%. El
+// total se lleva por proceso y se recalcula leyendo la carpeta al desalojar,
+// asi que con varios procesos el limite se respeta aproximado.
+//
+// Todo es de mejor esfuerzo: una entrada corrupta (encabezado, tamano o
+// hash de la salida que no cierran) cuenta como fallo y se borra, y si no
+// se puede escribir solo se cuenta el error.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t RESULT_CACHE_VERSION = 1;
+static const long RESULT_CACHE_DEFAULT_MB = 256;
+
+// ---------------------------------------------------------------------------
+// Hash: rondas del estilo de xxHash64 en 4 carriles de 64 bits (varios GB/s,
+// mucho menos que leer la entrada). No es compatible con xxHash; solo tiene
+// que ser estable entre corridas.
+// ---------------------------------------------------------------------------
+
+static const uint64_t RC_P1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t RC_P2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t RC_P3 = 0x165667B19E3779F9ULL;
+
+static inline uint64_t rc_rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline uint64_t rc_round(uint64_t acc, uint64_t w) {
+    return rc_rotl(acc + w * RC_P2, 31) * RC_P1;
+}
+
+static inline uint64_t cache_hash64(const void *data, size_t n, uint64_t seed) {
+    const uint8_t *b = static_cast<const uint8_t *>(data);
+    uint64_t v[4] = {seed + RC_P1 + RC_P2, seed + RC_P2, seed, seed - RC_P1};
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (int k = 0; k < 4; ++k) {
+            uint64_t w;
+            std::memcpy(&w, b + i + 8 * k, 8);
+            v[k] = rc_round(v[k], w);
+        }
+    }
+    uint64_t h = rc_rotl(v[0], 1) + rc_rotl(v[1], 7) + rc_rotl(v[2], 12) + rc_rotl(v[3], 18);
+    for (int k = 0; k < 4; ++k) h = (h ^ rc_round(0, v[k])) * RC_P1 + RC_P3;
+    h += n;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, b + i, 8);
+        h = rc_rotl(h ^ rc_round(0, w), 27) * RC_P1 + RC_P3;
+    }
+    for (; i < n; ++i) h = rc_rotl(h ^ (b[i] * RC_P3), 11) * RC_P1;
+    h ^= h >> 33; h *= RC_P2;
+    h ^= h >> 29; h *= RC_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Semantica del modelo, parte de la clave. El golden va con la escala exacta
+// (%a: sin perder bits); el HW con scale_q8_8, que es lo que ve el core.
+static inline std::string cache_model_golden(double scale) {
+    char s[64];
+    std::snprintf(s, sizeof(s), "golden-bilinear/%a", scale);
+    return s;
+}
+
+static inline std::string cache_model_hw(uint32_t scale_q8_8, bool box) {
+    char s[64];
+    std::snprintf(s, sizeof(s), "hw-q88-%s/0x%x", box ? "box" : "bilinear", scale_q8_8);
+    return s;
+}
+
+// Clave de una entrada de w x h x chans pixeles contiguos
+static inline uint64_t result_cache_key(const uint8_t *pix, int w, int h, int chans,
+                                        const std::string &model) {
+    const uint64_t hp = cache_hash64(pix, (size_t)w * h * chans, RESULT_CACHE_VERSION);
+    const std::string d = model + "|" + std::to_string(w) + "x" + std::to_string(h) +
+                          "x" + std::to_string(chans);
+    return cache_hash64(d.data(), d.size(), hp);
+}
+
+// ---------------------------------------------------------------------------
+// La cache
+// ---------------------------------------------------------------------------
+
+struct result_cache_stats {
+    uint64_t hits = 0, misses = 0, stores = 0, evicted = 0, errors = 0;
+    uint64_t bytes = 0;   // total estimado en la carpeta
+};
+
+class result_cache {
+public:
+    // Crea la carpeta si no existe (con padres) y suma lo que ya hay
+    result_cache(const std::string &dir, uint64_t max_bytes)
+        : dir_(dir.empty() ? std::string(".") : dir), max_(max_bytes) {
+        while (dir_.size() > 1 && dir_.back() == '/') dir_.pop_back();
+        make_dirs(dir_);
+        bytes_ = scan(nullptr);
+    }
+
+    result_cache(const result_cache &) = delete;
+    result_cache &operator=(const result_cache &) = delete;
+
+    const std::string &dir() const { return dir_; }
+
+    // Copia a dst (w*h*chans bytes) la salida guardada con esa clave
+    bool get(uint64_t key, uint8_t *dst, int w, int h, int chans) {
+        const std::string path = entry_path(key);
+        const size_t n = (size_t)w * h * chans;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            ++misses_;
+            return false;
+        }
+        entry_header eh;
+        struct stat st;
+        bool ok = ::fstat(fd, &st) == 0 && (size_t)st.st_size == sizeof(eh) + n &&
+                  read_all(fd, &eh, sizeof(eh)) &&
+                  std::memcmp(eh.magic, ENTRY_MAGIC, sizeof(eh.magic)) == 0 &&
+                  eh.key == key && eh.w == (uint32_t)w && eh.h == (uint32_t)h &&
+                  eh.chans == (uint32_t)chans && read_all(fd, dst, n) &&
+                  eh.sum == cache_hash64(dst, n, key);
+        if (ok) ::futimens(fd, nullptr);   // mtime = ahora: recien usada
+        ::close(fd);
+        if (!ok) {
+            ::unlink(path.c_str());
+            ++misses_;
+            return false;
+        }
+        ++hits_;
+        return true;
+    }
+
+    // Guarda la salida (temporal + rename) y desaloja si se paso del limite
+    void put(uint64_t key, const uint8_t *src, int w, int h, int chans) {
+        const size_t n = (size_t)w * h * chans;
+        entry_header eh;
+        std::memcpy(eh.magic, ENTRY_MAGIC, sizeof(eh.magic));
+        eh.key = key;
+        eh.w = (uint32_t)w;
+        eh.h = (uint32_t)h;
+        eh.chans = (uint32_t)chans;
+        eh.sum = cache_hash64(src, n, key);
+
+        const std::string path = entry_path(key);
+        const std::string tmp = dir_ + "/.tmp-" + std::to_string(::getpid()) + "-" +
+                                std::to_string(tmp_seq_++) + "-" + hex_key(key);
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        bool ok = fd >= 0 && write_all(fd, &eh, sizeof(eh)) && write_all(fd, src, n);
+        if (fd >= 0) ok = ::close(fd) == 0 && ok;
+        if (ok) ok = ::rename(tmp.c_str(), path.c_str()) == 0;
+        if (!ok) {
+            if (fd >= 0) ::unlink(tmp.c_str());
+            ++errors_;
+            return;
+        }
+        ++stores_;
+        if ((bytes_ += sizeof(eh) + n) > max_) evict();
+    }
+
+    result_cache_stats stats() const {
+        result_cache_stats s;
+        s.hits = hits_;
+        s.misses = misses_;
+        s.stores = stores_;
+        s.evicted = evicted_;
+        s.errors = errors_;
+        s.bytes = bytes_;
+        return s;
+    }
+
+    // "cache: 38 aciertos, 2 fallos (95.0%), 2 guardados, 0 desalojados; 1.2 MB en dir"
+    std::string summary() const {
+        const result_cache_stats s = stats();
+        const uint64_t q = s.hits + s.misses;
+        char buf[512];
+        std::snprintf(buf, sizeof(buf),
+                      "cache: %llu aciertos, %llu fallos (%.1f%%), %llu guardados,"
+                      " %llu desalojados%s; %.1f MB de %.0f MB en %s",
+                      (unsigned long long)s.hits, (unsigned long long)s.misses,
+                      q ? 100.0 * s.hits / q : 0.0, (unsigned long long)s.stores,
+                      (unsigned long long)s.evicted,
+                      s.errors ? (", " + std::to_string(s.errors) + " errores de escritura").c_str() : "",
+                      s.bytes / 1048576.0, max_ / 1048576.0, dir_.c_str());
+        return buf;
+    }
+
+private:
+    struct entry_header {
+        char magic[8];
+        uint64_t key;
+        uint32_t w, h, chans, reserved = 0;
+        uint64_t sum;   // hash de los pixeles de salida
+    };
+    static constexpr char ENTRY_MAGIC[8] = "DSARC1\n";
+    static const long STALE_TMP_S = 3600;   // temporales de procesos que murieron
+
+    struct entry {
+        struct timespec mtime;
+        uint64_t size;
+        std::string name;
+    };
+
+    static std::string hex_key(uint64_t key) {
+        char s[17];
+        std::snprintf(s, sizeof(s), "%016llx", (unsigned long long)key);
+        return s;
+    }
+
+    std::string entry_path(uint64_t key) const { return dir_ + "/" + hex_key(key) + ".bin"; }
+
+    static bool is_entry_name(const char *n) {
+        const size_t len = std::strlen(n);
+        return len == 20 && std::strcmp(n + 16, ".bin") == 0 && n[0] != '.';
+    }
+
+    static void make_dirs(const std::string &dir) {
+        for (size_t p = 1; p <= dir.size(); ++p) {
+            if (p < dir.size() && dir[p] != '/') continue;
+            const std::string d = dir.substr(0, p);
+            if (::mkdir(d.c_str(), 0755) != 0 && errno != EEXIST)
+                throw std::runtime_error("no se pudo crear la carpeta de cache " + d);
+        }
+        struct stat st;
+        if (::stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+            throw std::runtime_error("la cache " + dir + " no es una carpeta");
+    }
+
+    static bool read_all(int fd, void *p, size_t n) {
+        uint8_t *b = static_cast<uint8_t *>(p);
+        while (n) {
+            ssize_t r = ::read(fd, b, n);
+            if (r <= 0) return false;
+            b += r;
+            n -= (size_t)r;
+        }
+        return true;
+    }
+
+    static bool write_all(int fd, const void *p, size_t n) {
+        const uint8_t *b = static_cast<const uint8_t *>(p);
+        while (n) {
+            ssize_t r = ::write(fd, b, n);
+            if (r <= 0) return false;
+            b += r;
+            n -= (size_t)r;
+        }
+        return true;
+    }
+
+    // Suma las entradas de la carpeta (y las lista si out no es nulo); de
+    // paso borra temporales viejos
+    uint64_t scan(std::vector<entry> *out) const {
+        DIR *d = ::opendir(dir_.c_str());
+        if (!d) return 0;
+        const time_t now = std::time(nullptr);
+        uint64_t total = 0;
+        while (struct dirent *e = ::readdir(d)) {
+            const bool tmp = std::strncmp(e->d_name, ".tmp-", 5) == 0;
+            if (!tmp && !is_entry_name(e->d_name)) continue;
+            const std::string path = dir_ + "/" + e->d_name;
+            struct stat st;
+            if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+            if (tmp) {
+                if (now - st.st_mtime > STALE_TMP_S) ::unlink(path.c_str());
+                continue;
+            }
+            total += (uint64_t)st.st_size;
+            if (out) out->push_back({st.st_mtim, (uint64_t)st.st_size, e->d_name});
+        }
+        ::closedir(d);
+        return total;
+    }
+
+    // Borra las menos usadas hasta quedar en el 90% del limite. Otro proceso
+    // puede estar desalojando a la vez: un unlink que falla no suma.
+    void evict() {
+        std::lock_guard<std::mutex> lk(evict_mu_);
+        std::vector<entry> es;
+        uint64_t total = scan(&es);
+        const uint64_t target = max_ - max_ / 10;
+        if (total > max_) {
+            std::sort(es.begin(), es.end(), [](const entry &a, const entry &b) {
+                if (a.mtime.tv_sec != b.mtime.tv_sec) return a.mtime.tv_sec < b.mtime.tv_sec;
+                return a.mtime.tv_nsec < b.mtime.tv_nsec;
+            });
+            for (const entry &e : es) {
+                if (total <= target) break;
+                if (::unlink((dir_ + "/" + e.name).c_str()) == 0) ++evicted_;
+                total -= e.size;
+            }
+        }
+        bytes_ = total;
+    }
+
+    std::string dir_;
+    uint64_t max_;
+    std::atomic<uint64_t> hits_{0}, misses_{0}, stores_{0}, evicted_{0}, errors_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> tmp_seq_{0};
+    std::mutex evict_mu_;
+};
+
+// Cache pedida por flag o por entorno: dir vacio = DSA_CACHE_DIR (si tampoco
+// esta, sin cache); max_mb <= 0 = DSA_CACHE_MAX_MB o RESULT_CACHE_DEFAULT_MB.
+static inline std::unique_ptr<result_cache> open_result_cache(std::string dir, long max_mb) {
+    if (dir.empty()) {
+        const char *e = std::getenv("DSA_CACHE_DIR");
+        if (e) dir = e;
+    }
+    if (dir.empty()) return nullptr;
+    if (max_mb <= 0) {
+        const char *e = std::getenv("DSA_CACHE_MAX_MB");
+        max_mb = e ? std::atol(e) : 0;
+        if (max_mb <= 0) max_mb = RESULT_CACHE_DEFAULT_MB;
+    }
+    return std::unique_ptr<result_cache>(new result_cache(dir, (uint64_t)max_mb << 20));
+}
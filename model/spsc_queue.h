@@ -0,0 +1,104 @@
+// model/spsc_queue.h
+// Cola acotada sin locks de un productor y un consumidor (SPSC).
+//
+// Un anillo de capacidad potencia de 2 con dos contadores que solo crecen:
+// tail lo escribe solo el productor y head solo el consumidor, asi que
+// alcanza con acquire/release y no hay CAS. Cada lado guarda una copia del
+// contador del otro y solo la relee cuando parece lleno/vacio, para no
+// pelear la linea de cache en cada operacion. Los contadores van en lineas
+// de cache separadas.
+//
+// push/pop bloquean con espera escalonada: unas vueltas con pause, despues
+// yield y, si sigue sin haber lugar/datos, sleeps cortos (con pocos nucleos
+// girar le roba tiempo justo al hilo que se espera).
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Espera escalonada para los lazos de reintento
+class spin_backoff {
+public:
+    void wait() {
+        if (n_ < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#endif
+        } else if (n_ < 256) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        ++n_;
+    }
+
+private:
+    unsigned n_ = 0;
+};
+
+template <class T>
+class spsc_queue {
+public:
+    // capacity se redondea a la potencia de 2 siguiente
+    explicit spsc_queue(size_t capacity) {
+        size_t c = 1;
+        while (c < capacity) c <<= 1;
+        buf_.resize(c);
+        mask_ = c - 1;
+    }
+
+    spsc_queue(const spsc_queue &) = delete;
+    spsc_queue &operator=(const spsc_queue &) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Solo el productor
+    bool try_push(const T &v) {
+        const size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (t - head_cache_ > mask_) return false;
+        }
+        buf_[t & mask_] = v;
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(const T &v) {
+        spin_backoff b;
+        while (!try_push(v)) b.wait();
+    }
+
+    // Solo el consumidor
+    bool try_pop(T &v) {
+        const size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (h == tail_cache_) return false;
+        }
+        v = buf_[h & mask_];
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    void pop(T &v) {
+        spin_backoff b;
+        while (!try_pop(v)) b.wait();
+    }
+
+private:
+    std::vector<T> buf_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;            // copia del consumidor
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;            // copia del productor
+};
@@ -0,0 +1,164 @@
+// model/thread_pool.h
+// Pool de hilos persistente con robo de trabajo (work stealing).
+//
+// parallel_for(n, fn) reparte las tareas 0..n-1 en bloques contiguos, uno
+// por hilo. Cada hilo saca de su propia cola por atras y, cuando se queda
+// sin trabajo, roba por delante de las colas de los demas. El hilo que
+// llama tambien trabaja (es el hilo 0), asi que thread_pool(1) no crea hilos.
+//
+// Las tareas deben escribir en zonas disjuntas; el resultado no depende del
+// orden en que se ejecuten. parallel_for se llama desde un solo hilo a la
+// vez y no se anida (una tarea no puede llamar a parallel_for).
+//
+// Las colas reusan su capacidad entre llamadas, asi que un parallel_for
+// repetido no reserva memoria (si fn cabe en el buffer interno de
+// std::function, p.ej. una lambda que captura un solo puntero).
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class thread_pool {
+public:
+    // n_threads = 0 -> un hilo por núcleo
+    explicit thread_pool(unsigned n_threads = 0) {
+        if (n_threads == 0)
+            n_threads = std::max(1u, std::thread::hardware_concurrency());
+        n_ = n_threads;
+        queues_.reset(new work_queue[n_]);
+        for (unsigned i = 1; i < n_; ++i)
+            workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto &t : workers_) t.join();
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    unsigned size() const { return n_; }
+
+    // Ejecuta fn(i) para i en [0, n_tasks) y espera a que terminen todas
+    void parallel_for(int n_tasks, const std::function<void(int)> &fn) {
+        if (n_tasks <= 0) return;
+        if (n_ == 1 || n_tasks == 1) {
+            for (int i = 0; i < n_tasks; ++i) fn(i);
+            return;
+        }
+
+        {
+            // Todo bajo m_: un hilo que todavia no desperto del trabajo
+            // anterior no puede ver las colas nuevas con el job viejo.
+            std::lock_guard<std::mutex> lk(m_);
+            for (unsigned q = 0; q < n_; ++q) {
+                int b = (int)((int64_t)n_tasks * q / n_);
+                int e = (int)((int64_t)n_tasks * (q + 1) / n_);
+                std::lock_guard<std::mutex> lq(queues_[q].m);
+                queues_[q].q.clear();
+                queues_[q].head = 0;
+                for (int i = b; i < e; ++i) queues_[q].q.push_back(i);
+            }
+            job_ = &fn;
+            pending_.store(n_tasks);
+            finished_ = 0;
+            ++gen_;
+        }
+        cv_.notify_all();
+
+        run_tasks(0, &fn);
+
+        // Se espera tambien a que todos los hilos suelten este job, para que
+        // ninguno siga con un puntero a fn cuando empiece el siguiente.
+        std::unique_lock<std::mutex> lk(m_);
+        done_cv_.wait(lk, [&] { return pending_.load() == 0 && finished_ == n_ - 1; });
+    }
+
+private:
+    // Tareas pendientes en q[head, q.size()): se saca por atras con
+    // pop_back y se roba por delante avanzando head
+    struct work_queue {
+        std::mutex m;
+        std::vector<int> q;
+        size_t head = 0;
+    };
+
+    // Trabajo propio: se saca por atras (lo mas reciente, mejor localidad)
+    bool pop_local(unsigned self, int &task) {
+        work_queue &wq = queues_[self];
+        std::lock_guard<std::mutex> lk(wq.m);
+        if (wq.head == wq.q.size()) return false;
+        task = wq.q.back();
+        wq.q.pop_back();
+        return true;
+    }
+
+    // Robo: por delante de la cola de otro hilo
+    bool steal(unsigned self, int &task) {
+        for (unsigned k = 1; k < n_; ++k) {
+            work_queue &wq = queues_[(self + k) % n_];
+            std::lock_guard<std::mutex> lk(wq.m);
+            if (wq.head == wq.q.size()) continue;
+            task = wq.q[wq.head++];
+            return true;
+        }
+        return false;
+    }
+
+    void run_tasks(unsigned self, const std::function<void(int)> *job) {
+        int task;
+        while (pop_local(self, task) || steal(self, task)) {
+            (*job)(task);
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lk(m_);
+                done_cv_.notify_all();
+            }
+        }
+    }
+
+    void worker_loop(unsigned self) {
+        uint64_t seen = 0;
+        for (;;) {
+            const std::function<void(int)> *job;
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [&] { return stop_ || gen_ != seen; });
+                if (stop_) return;
+                seen = gen_;
+                job = job_;
+            }
+            run_tasks(self, job);
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                ++finished_;
+            }
+            done_cv_.notify_all();
+        }
+    }
+
+    unsigned n_ = 1;
+    std::unique_ptr<work_queue[]> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(int)> *job_ = nullptr;
+    std::atomic<int> pending_{0};
+    uint64_t gen_ = 0;
+    unsigned finished_ = 0;   // hilos que ya terminaron el job actual
+    bool stop_ = false;
+};
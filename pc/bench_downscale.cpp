@@ -0,0 +1,254 @@
+// pc/bench_downscale.cpp
+// Benchmark de throughput de los motores en C++.
+//
+// Mide sobre una matriz de tamaños (32x32 .. 8K) y escalas Q8.8 (0x80 .. 0x100):
+//   - golden: downscale_bilinear_u8_cpp (semantica del Python, con thread_pool)
+//   - hw:     el modelo Q8.8 del driver (tablas build_coord_tables_hw +
+//             downscale_u8, un hilo) sin el limite de 32x32 del core
+//   - rgb, rgba: el golden sobre una imagen de 3 o 4 canales intercalados
+//             (interleave_tables), con el mismo pool; no van por defecto
+//             (--engines golden,rgb,rgba para ver cuanto cuesta el color)
+//   - view:   el golden por model/downscale_view.h (vistas y arena reusada,
+//             mismo pool): sin reservas ni tablas nuevas por cuadro, lo que
+//             cuesta un cuadro en un flujo de video; tampoco va por defecto
+// Cada medicion incluye armar las tablas, igual que una llamada real por
+// cuadro. Reporta Mpix/s y ns/pixel (pixeles de SALIDA, como PERF_PIX del
+// HW) con mediana y p99 sobre las repeticiones, y escribe un JSON que lee
+// pc/summarize_perf.py --bench.
+// Con --perf, despues de medir el tiempo se corre una repeticion mas con un
+// perf_probe (model/perf_counters.h) y cada corrida lleva en "perf" los
+// contadores de la CPU: ciclos/pixel, IPC, fallos de cache por pixel y
+// bytes/pixel. Las repeticiones cronometradas van siempre sin probe.
+//
+// Compilar: make bench   (o)
+//   g++ -std=c++17 -O2 -pthread -o pc/bench_downscale pc/bench_downscale.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../model/downscale_kernels.h"
+#include "../model/downscale_parallel.h"
+#include "../model/downscale_view.h"
+#include "../model/perf_counters.h"
+
+struct bench_row {
+    std::string engine;
+    int w_in, h_in, w_out, h_out;
+    uint32_t scale_q8_8;
+    int reps;
+    double median_ns, p99_ns;
+    bool has_perf;
+    perf_values perf;
+    perf_traffic traffic;
+};
+
+static double percentile(std::vector<double> v, double p) {
+    std::sort(v.begin(), v.end());
+    size_t k = (size_t)std::ceil(p * v.size()) - 1;
+    return v[std::min(k, v.size() - 1)];
+}
+
+// Repite fn hasta juntar min_ms de tiempo (al menos min_reps, a lo sumo
+// max_reps) y devuelve los tiempos de cada repeticion en ns.
+template <class Fn>
+static std::vector<double> time_reps(Fn &&fn, double min_ms, int min_reps, int max_reps) {
+    using clk = std::chrono::steady_clock;
+    fn(); // calentar caches y paginas de salida
+    std::vector<double> ns;
+    double total_ms = 0;
+    while ((int)ns.size() < max_reps && ((int)ns.size() < min_reps || total_ms < min_ms)) {
+        auto t0 = clk::now();
+        fn();
+        double d = std::chrono::duration<double, std::nano>(clk::now() - t0).count();
+        ns.push_back(d);
+        total_ms += d / 1e6;
+    }
+    return ns;
+}
+
+static std::vector<std::string> split_list(const std::string &s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+int main(int argc, char **argv) {
+    std::string sizes = "32x32,64x64,256x256,640x480,1280x720,1920x1080,3840x2160,7680x4320";
+    std::string scales = "0x80,0xC0,0x100";
+    std::string engines = "golden,hw";
+    std::string out_path = "results/bench.json";
+    int threads = 0;
+    double min_ms = 200;
+    int min_reps = 5, max_reps = 1000;
+    bool perf = false;
+
+    bool bad_args = false;
+    for (int i = 1; i < argc && !bad_args; ++i) {
+        std::string a = argv[i];
+        if (a == "--sizes" && i+1 < argc) sizes = argv[++i];
+        else if (a == "--scales" && i+1 < argc) scales = argv[++i];
+        else if (a == "--engines" && i+1 < argc) engines = argv[++i];
+        else if (a == "--threads" && i+1 < argc) threads = std::stoi(argv[++i]);
+        else if (a == "--min-ms" && i+1 < argc) min_ms = std::stod(argv[++i]);
+        else if (a == "--max-reps" && i+1 < argc) max_reps = std::stoi(argv[++i]);
+        else if (a == "--out" && i+1 < argc) out_path = argv[++i];
+        else if (a == "--perf") perf = true;
+        else bad_args = true;
+    }
+    if (bad_args || threads < 0) {
+        std::cerr << "uso: " << argv[0]
+                  << " [--sizes 32x32,1920x1080] [--scales 0x80,0x100]"
+                  << " [--engines golden,hw,rgb,rgba,view] [--threads N] [--min-ms 200]"
+                  << " [--max-reps 1000] [--out results/bench.json] [--perf]\n";
+        return 1;
+    }
+
+    thread_pool pool(threads);
+    const simd_level lvl = default_simd_level();
+    std::vector<bench_row> rows;
+    std::mt19937 rng(1234);
+    uint32_t sink = 0;
+
+    std::printf("kernel %s, %u hilos (golden), 1 hilo (hw)\n",
+                simd_level_name(lvl), pool.size());
+    std::printf("%-7s %11s %6s %11s %5s %10s %10s %9s %8s\n",
+                "motor", "entrada", "escala", "salida", "reps",
+                "med_us", "p99_us", "Mpix/s", "ns/px");
+
+    for (const auto &sz : split_list(sizes)) {
+        int W = 0, H = 0;
+        if (std::sscanf(sz.c_str(), "%dx%d", &W, &H) != 2 || W <= 0 || H <= 0) {
+            std::cerr << "error: tamaño invalido " << sz << "\n";
+            return 1;
+        }
+        std::vector<uint8_t> img((size_t)W * H);
+        for (auto &p : img) p = (uint8_t)rng();
+        std::vector<uint8_t> color;   // RGBA intercalado, rgb usa los primeros W*H*3
+
+        for (const auto &sc : split_list(scales)) {
+            uint32_t sq = (uint32_t)std::stoul(sc, nullptr, 0);
+            if (sq == 0) {
+                std::cerr << "error: escala invalida " << sc << "\n";
+                return 1;
+            }
+            for (const auto &eng : split_list(engines)) {
+                bench_row r{eng, W, H, 0, 0, sq, 0, 0, 0, false, perf_values(), perf_traffic()};
+                // Una corrida del motor; probe != nullptr solo en la medida con --perf
+                std::function<void(perf_probe *)> run;
+                if (eng == "golden") {
+                    const double scale = sq / 256.0;
+                    run = [&, scale](perf_probe *probe) {
+                        auto out = downscale_bilinear_u8_cpp(img, W, H, scale, r.w_out, r.h_out,
+                                                             &pool, probe);
+                        sink += out[out.size() / 2];
+                    };
+                } else if (eng == "hw") {
+                    hw_out_dims(W, H, sq, 0, 0, r.w_out, r.h_out);
+                    std::vector<uint8_t> out((size_t)r.w_out * r.h_out);
+                    run = [&, out](perf_probe *probe) mutable {
+                        coord_tables t = build_coord_tables_hw(W, H, r.w_out, r.h_out, sq);
+                        perf_band_scope ps(probe, 0, t.H2,
+                                           probe ? bilinear_band_traffic(t, W, 0, t.H2) : perf_traffic());
+                        downscale_u8(img.data(), W, t, out.data(), lvl);
+                        sink += out[out.size() / 2];
+                    };
+                } else if (eng == "rgb" || eng == "rgba") {
+                    const int C = eng == "rgb" ? 3 : 4;
+                    if (color.empty()) {
+                        color.resize((size_t)W * H * 4);
+                        for (auto &p : color) p = (uint8_t)rng();
+                    }
+                    const double scale = sq / 256.0;
+                    run = [&, C, scale, out = std::vector<uint8_t>()](perf_probe *probe) mutable {
+                        coord_tables g = build_coord_tables(W, H, scale);
+                        coord_tables t = interleave_tables(g, C);
+                        r.w_out = g.W2;
+                        r.h_out = g.H2;
+                        out.resize((size_t)t.W2 * t.H2);
+                        downscale_u8_bands(color.data(), W * C, t, out.data(), pool, lvl, probe);
+                        sink += out[out.size() / 2];
+                    };
+                } else if (eng == "view") {
+                    const double scale = sq / 256.0;
+                    golden_out_dims(W, H, scale, r.w_out, r.h_out);
+                    auto out = std::make_shared<std::vector<uint8_t>>((size_t)r.w_out * r.h_out);
+                    auto arena = std::make_shared<downscale_arena>();
+                    const u8_view in = make_view(img.data(), W, H);
+                    const u8_mut_view o = make_mut_view(out->data(), r.w_out, r.h_out);
+                    run = [&, scale, out, arena, in, o](perf_probe *probe) {
+                        downscale_bilinear_u8_view(in, scale, o, *arena, &pool, probe);
+                        sink += (*out)[out->size() / 2];
+                    };
+                } else {
+                    std::cerr << "error: motor desconocido " << eng << " (golden|hw|rgb|rgba|view)\n";
+                    return 1;
+                }
+                std::vector<double> ns = time_reps([&] { run(nullptr); }, min_ms, min_reps, max_reps);
+                if (perf) {
+                    perf_probe probe;
+                    run(&probe);
+                    r.has_perf = true;
+                    r.perf = probe.total();
+                    r.traffic = probe.traffic();
+                }
+                r.reps = (int)ns.size();
+                r.median_ns = percentile(ns, 0.5);
+                r.p99_ns = percentile(ns, 0.99);
+                rows.push_back(r);
+
+                const double px = (double)r.w_out * r.h_out;
+                std::printf("%-7s %5dx%-5d  0x%03X %5dx%-5d %5d %10.1f %10.1f %9.1f %8.3f\n",
+                            eng.c_str(), W, H, sq, r.w_out, r.h_out, r.reps,
+                            r.median_ns / 1e3, r.p99_ns / 1e3,
+                            px / r.median_ns * 1e3, r.median_ns / px);
+                if (r.has_perf)
+                    std::printf("        cpu: %s\n", perf_summary_line(r.perf, r.traffic).c_str());
+            }
+        }
+    }
+
+    std::ofstream f(out_path);
+    if (!f) {
+        std::cerr << "error: no se pudo abrir " << out_path << "\n";
+        return 1;
+    }
+    f << "{\n"
+      << "  \"simd\": \"" << simd_level_name(lvl) << "\",\n"
+      << "  \"threads\": " << pool.size() << ",\n"
+      << "  \"runs\": [\n";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const bench_row &r = rows[i];
+        const double px = (double)r.w_out * r.h_out;
+        f << "    {\"engine\": \"" << r.engine << "\""
+          << ", \"w_in\": " << r.w_in << ", \"h_in\": " << r.h_in
+          << ", \"scale_q8_8\": " << r.scale_q8_8
+          << ", \"w_out\": " << r.w_out << ", \"h_out\": " << r.h_out
+          << ", \"reps\": " << r.reps
+          << ", \"median_ns\": " << r.median_ns << ", \"p99_ns\": " << r.p99_ns
+          << ", \"mpix_s\": " << px / r.median_ns * 1e3
+          << ", \"ns_px\": " << r.median_ns / px;
+        if (r.has_perf) {
+            f << ", \"perf\": {";
+            write_perf_fields(f, r.perf, r.traffic);
+            f << "}";
+        }
+        f << "}" << (i + 1 < rows.size() ? ",\n" : "\n");
+    }
+    f << "  ]\n}\n";
+    std::printf("listo %s (checksum %u)\n", out_path.c_str(), sink);
+    return 0;
+}
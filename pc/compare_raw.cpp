@@ -0,0 +1,127 @@
+// pc/compare_raw.cpp
+// Comparador de imagenes de 8 bits (RAW, PGM o PPM) con model/image_compare.h.
+//
+// Misma interfaz y mismas primeras lineas que pc/compare.py (iguales %,
+// dif_max, OK / hay diferencias) y ademas: error medio, PSNR, histograma
+// del error, caja de los mismatches y una caja por tramo de filas, los
+// primeros mismatches y, con --diff-pgm, |a - b| como imagen. Con un PGM/PPM
+// no hace falta --w/--h. Si los tamaños difieren compara la ventana comun y
+// sale con 1, como compare.py; --strict sale con 1 tambien si hay
+// diferencias. DSA_SIMD=escalar|sse4.1|avx2 limita el kernel. Con color
+// se compara byte a byte y el PGM de diferencias sale de W*canales de ancho.
+//
+// Compilar: make pc/compare_raw   (o)
+//   g++ -std=c++17 -O2 -pthread -o pc/compare_raw pc/compare_raw.cpp
+//
+// Ejemplo:
+//   ./pc/compare_raw --w 16 --h 16 --a results/out_hw.raw
+//     --b vectors/golden/grad_32_s05.raw --diff-pgm results/diff.pgm --gain 32
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "../model/image_compare.h"
+#include "../model/image_io.h"
+
+int main(int argc, char **argv) {
+    std::string path_a, path_b, diff_path;
+    int wa = 0, ha = 0, wb = 0, hb = 0, chans = 0;
+    int gain = 1, list = 10;
+    bool strict = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--a" && i+1 < argc) path_a = argv[++i];
+        else if (a == "--b" && i+1 < argc) path_b = argv[++i];
+        else if (a == "--wa" && i+1 < argc) wa = std::stoi(argv[++i]);
+        else if (a == "--ha" && i+1 < argc) ha = std::stoi(argv[++i]);
+        else if (a == "--wb" && i+1 < argc) wb = std::stoi(argv[++i]);
+        else if (a == "--hb" && i+1 < argc) hb = std::stoi(argv[++i]);
+        else if (a == "--w" && i+1 < argc) wa = wb = std::stoi(argv[++i]);
+        else if (a == "--h" && i+1 < argc) ha = hb = std::stoi(argv[++i]);
+        else if (a == "--chans" && i+1 < argc) chans = std::stoi(argv[++i]);
+        else if (a == "--diff-pgm" && i+1 < argc) diff_path = argv[++i];
+        else if (a == "--gain" && i+1 < argc) gain = std::stoi(argv[++i]);
+        else if (a == "--list" && i+1 < argc) list = std::stoi(argv[++i]);
+        else if (a == "--strict") strict = true;
+        else {
+            std::cerr << "uso: " << argv[0]
+                      << " --a A.raw --b B.raw [--w W --h H | --wa W --ha H --wb W --hb H]"
+                      << " [--chans 1|3|4] [--diff-pgm diff.pgm] [--gain 1] [--list 10]"
+                      << " [--strict]\n";
+            return 1;
+        }
+    }
+    if (path_a.empty() || path_b.empty()) {
+        std::cerr << "error: faltan --a y --b\n";
+        return 1;
+    }
+
+    mapped_image A, B;
+    try {
+        A = map_image_u8(path_a, wa, ha, false, chans);
+        B = map_image_u8(path_b, wb, hb, false, chans);
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+    if (A.chans != B.chans) {
+        std::cerr << "error: A tiene " << A.chans << " canal(es) y B " << B.chans << "\n";
+        return 1;
+    }
+    const int C = A.chans;
+
+    compare_options opt;
+    opt.max_list = list;
+    auto t0 = std::chrono::steady_clock::now();
+    compare_stats s = compare_u8(A.pix, A.w * C, A.h, B.pix, B.w * C, B.h, opt);
+    const double ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - t0).count();
+
+    if (!s.same_dims)
+        std::printf("tamaños distintos  A %dx%d  B %dx%d, se compara %dx%d\n",
+                    A.w, A.h, B.w, B.h, s.w / C, s.h);
+    const double pct = s.pixels ? 100.0 * s.hist[0] / s.pixels : 100.0;
+    std::printf("iguales %.2f%% (%llu de %llu)\n", pct,
+                (unsigned long long)s.hist[0], (unsigned long long)s.pixels);
+    std::printf("dif_max %d LSB\n", s.max_err);
+    if (s.mismatches) {
+        std::printf("error medio %.4f LSB  PSNR %.2f dB\n", s.mean_abs(), s.psnr());
+        std::printf("histograma (error:pixeles)");
+        for (int d = 1; d < 256; ++d)
+            if (s.hist[d]) std::printf(" %d:%llu", d, (unsigned long long)s.hist[d]);
+        std::printf("\n");
+        // x en pixeles (con color se divide por los canales)
+        std::printf("caja x=%d..%d y=%d..%d\n", s.bbox.x0 / C, s.bbox.x1 / C,
+                    s.bbox.y0, s.bbox.y1);
+        for (const diff_box &b : s.boxes)
+            std::printf("  filas %d..%d  x=%d..%d  %llu mismatches\n", b.y0, b.y1,
+                        b.x0 / C, b.x1 / C, (unsigned long long)b.mismatches);
+        if (s.boxes_truncated) std::printf("  (hay mas tramos)\n");
+        for (const diff_pixel &p : s.first) {
+            if (C == 1)
+                std::printf("  (x=%d,y=%d) A=0x%02X B=0x%02X\n", p.x, p.y, p.a, p.b);
+            else
+                std::printf("  (x=%d,y=%d,c=%d) A=0x%02X B=0x%02X\n", p.x / C, p.y, p.x % C,
+                            p.a, p.b);
+        }
+    }
+    std::printf("%s\n", s.mismatches ? "hay diferencias" : "OK");
+    std::fprintf(stderr, "comparado %dx%d en %.3f ms (%s)\n", s.w / C, s.h, ms,
+                 simd_level_name(opt.lvl));
+
+    if (!diff_path.empty()) {
+        try {
+            write_diff_pgm(diff_path, A.pix, A.w * C, B.pix, B.w * C, s.w, s.h, gain);
+        } catch (const std::exception &e) {
+            std::cerr << "error: " << e.what() << "\n";
+            return 1;
+        }
+        std::printf("diferencia en %s (x%d)\n", diff_path.c_str(), gain);
+    }
+
+    if (!s.same_dims) return 1;
+    return strict && s.mismatches ? 1 : 0;
+}
@@ -0,0 +1,576 @@
+// pc/conformance_sweep.cpp
+// Barrido exhaustivo de conformidad entre los motores de downscale.
+//
+// Recorre todas las escalas Q8.8 (0x01 .. 0x100) y todos los tamaños de 1x1
+// hasta el maximo del core (32x32 por defecto, --max para cambiarlo), mas
+// algunos anchos (--extra, 97x5 y 160x40 por defecto) para que los lazos SIMD
+// anchos y los de escala fija corran varias vueltas y el core parta en
+// tiles, con una entrada aleatoria fija por tamaño, y compara:
+//   - hw vs golden: el modelo Q8.8 del driver (inv_scale_q = 65536/scale,
+//     fraccion & 0xFF) contra downscale_bilinear_u8_cpp (double + round).
+//     Difieren a proposito en algunas escalas: se reportan pixeles distintos,
+//     error maximo y si cambian las dimensiones de salida, pero no fallan.
+//   - cada kernel rapido contra el escalar de su misma semantica (SSE4.1,
+//     AVX2, con y sin kernel de escala fija, el motor por flujo de filas y
+//     la piramide de varias escalas):
+//     tienen que dar los mismos bytes. RGB/RGBA intercalado se compara canal
+//     por canal contra el escalar de gris sobre cada plano.
+//   - el modelo del core (model/core_cycle_model.h) contra el modelo Q8.8, y
+//     el del core box contra downscale_box.h, los dos por tiles: tambien
+//     iguales, salvo 0x01 (inv_scale_q = 65536 no entra en 16 bits), que se
+//     cuenta aparte como divergencia conocida.
+//   - el modo box (model/downscale_box.h, RGB incluido) contra el promedio
+//     de la huella pixel por pixel, escrito aca sin tablas.
+//   - la API de vistas (model/downscale_view.h) sobre un subrectangulo con
+//     stride contra el escalar: mismos bytes, sin pisar fuera de la vista de
+//     salida y sin reservas de memoria al repetir el cuadro.
+// Sale con 1 si algun kernel rapido o el core (fuera de 0x01) difiere, asi
+// sirve de compuerta para cualquier cambio en los kernels.
+//
+// Las escalas se reparten en un thread_pool (una tarea por escala). Con
+// --csv escribe una fila por configuracion (tamaño x escala) con los
+// contadores de cada comparacion.
+//
+// Compilar: make conformance   (o)
+//   g++ -std=c++17 -O2 -pthread -o pc/conformance_sweep pc/conformance_sweep.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../model/core_cycle_model.h"
+#include "../model/downscale_box.h"
+#include "../model/downscale_kernels.h"
+#include "../model/downscale_stream.h"
+#include "../model/downscale_view.h"
+#include "../model/thread_pool.h"
+
+// Reservas del hilo actual, para ver que la API de vistas no toca el heap
+// con la arena ya armada
+static thread_local long thread_allocs = 0;
+
+void *operator new(size_t n) {
+    ++thread_allocs;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+// Pixeles distintos y error absoluto maximo
+struct diff_stats {
+    long mismatches = 0;
+    int max_err = 0;
+
+    void add(const diff_stats &o) {
+        mismatches += o.mismatches;
+        max_err = std::max(max_err, o.max_err);
+    }
+};
+
+// Compara la ventana comun de dos imagenes (a es aw x ah, b es bw x bh)
+static diff_stats diff_u8(const uint8_t *a, int aw, int ah, const uint8_t *b, int bw, int bh) {
+    diff_stats d;
+    const int w = std::min(aw, bw), h = std::min(ah, bh);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            int e = std::abs((int)a[(size_t)y * aw + x] - (int)b[(size_t)y * bw + x]);
+            if (e) {
+                ++d.mismatches;
+                d.max_err = std::max(d.max_err, e);
+            }
+        }
+    }
+    return d;
+}
+
+// Variantes rapidas que se comparan contra el escalar de su semantica
+enum variant_kind { V_SIMD, V_SIMD_GENERIC, V_STREAM, V_PYRAMID, V_VIEW, V_CORE, V_CHANNELS,
+                    V_BOX, V_CORE_BOX };
+
+struct variant {
+    std::string name;
+    bool hw;             // semantica: false = golden, true = Q8.8 del HW
+    variant_kind kind;
+    simd_level lvl;
+    int chans = 1;       // V_CHANNELS/V_BOX: 3 (RGB) o 4 (RGBA)
+};
+
+static std::vector<variant> make_variants(simd_level top) {
+    std::vector<variant> v;
+    for (int hw = 0; hw < 2; ++hw) {
+        const std::string fam = hw ? "hw" : "golden";
+        for (simd_level l : {simd_level::sse41, simd_level::avx2}) {
+            if (l > top) continue;
+            v.push_back({fam + "/" + simd_level_name(l), (bool)hw, V_SIMD, l});
+            v.push_back({fam + "/" + simd_level_name(l) + "-generico", (bool)hw, V_SIMD_GENERIC, l});
+            v.push_back({fam + "/" + simd_level_name(l) + "-rgb", (bool)hw, V_CHANNELS, l, 3});
+            v.push_back({fam + "/" + simd_level_name(l) + "-rgba", (bool)hw, V_CHANNELS, l, 4});
+        }
+        v.push_back({fam + "/stream", (bool)hw, V_STREAM, top});
+        v.push_back({fam + "/piramide", (bool)hw, V_PYRAMID, top});
+        v.push_back({fam + "/vistas", (bool)hw, V_VIEW, top});
+    }
+    v.push_back({"hw/core", true, V_CORE, simd_level::scalar});
+    v.push_back({"hw/box", true, V_BOX, simd_level::scalar});
+    v.push_back({"hw/box-rgb", true, V_BOX, simd_level::scalar, 3});
+    v.push_back({"hw/core-box", true, V_CORE_BOX, simd_level::scalar});
+    return v;
+}
+
+// Acumulado de una escala sobre todos los tamaños
+struct scale_result {
+    uint32_t sq = 0;
+    int sizes = 0;
+    int dims_differ = 0;        // tamaños con salida hw != golden
+    int pix_differ = 0;         // tamaños con algun pixel distinto en la ventana comun
+    long pixels = 0;            // pixeles comparados hw vs golden
+    diff_stats hw_golden;
+    int worst_w = 0, worst_h = 0;
+    std::vector<long> variant_bad;   // tamaños donde la variante difiere de su escalar
+    std::string csv;
+};
+
+struct sweep_scratch {
+    std::vector<uint8_t> ref, out, color, plane, plane_ref, big, big_out;
+    std::vector<uint16_t> v;
+    downscale_arena arena;   // se reusa entre tamaños (V_VIEW)
+};
+
+// Canal c del color de prueba: el plano de gris desplazado, asi los canales
+// no son iguales entre si
+static inline uint8_t test_channel(uint8_t p, int c) { return (uint8_t)(p + 67 * c); }
+
+// Imagen intercalada de vr.chans canales en una pasada con las tablas de gris
+// expandidas, contra el escalar de gris de cada plano. ref0 es el escalar
+// sobre img (el canal 0). Devuelve los bytes distintos.
+static long check_channels(const variant &vr, const uint8_t *img, int W, int H,
+                           const coord_tables &g, const std::vector<uint8_t> &ref0,
+                           sweep_scratch &s) {
+    const int C = vr.chans;
+    const size_t n_in = (size_t)W * H, n_out = (size_t)g.W2 * g.H2;
+    s.color.resize(n_in * C);
+    for (size_t i = 0; i < n_in; ++i)
+        for (int c = 0; c < C; ++c)
+            s.color[i * C + c] = test_channel(img[i], c);
+
+    coord_tables t = interleave_tables(g, C);
+    s.out.assign(n_out * C, 0);
+    s.v.resize(std::max(s.v.size(), simd_scratch_len(W * C)));
+    downscale_u8_rows(s.color.data(), W * C, t, s.out.data(), 0, t.H2, vr.lvl, s.v.data());
+
+    long bad = 0;
+    s.plane.resize(n_in);
+    s.plane_ref.resize(n_out);
+    for (int c = 0; c < C; ++c) {
+        const uint8_t *ref = ref0.data();
+        if (c) {
+            for (size_t i = 0; i < n_in; ++i) s.plane[i] = test_channel(img[i], c);
+            downscale_u8_rows(s.plane.data(), W, g, s.plane_ref.data(), 0, g.H2,
+                              simd_level::scalar, s.v.data());
+            ref = s.plane_ref.data();
+        }
+        for (size_t i = 0; i < n_out; ++i)
+            bad += s.out[i * C + c] != ref[i];
+    }
+    return bad;
+}
+
+// Modo box sobre la imagen de vr.chans canales (los de check_channels)
+// contra el promedio directo de cada huella. Devuelve los bytes distintos.
+static long check_box(const variant &vr, const uint8_t *img, int W, int H, uint32_t sq,
+                      int W2, int H2, sweep_scratch &s) {
+    const int C = vr.chans;
+    const size_t n_in = (size_t)W * H;
+    s.color.resize(n_in * C);
+    for (size_t i = 0; i < n_in; ++i)
+        for (int c = 0; c < C; ++c)
+            s.color[i * C + c] = test_channel(img[i], c);
+
+    box_tables bt = build_box_tables(W, H, W2, H2, sq, C);
+    s.out.assign((size_t)W2 * H2 * C, 0);
+    downscale_box_u8(s.color.data(), W, bt, s.out.data());
+
+    long bad = 0;
+    for (int yo = 0; yo < H2; ++yo) {
+        const axis_coord cy = hw_q88_rounding::box_span(yo, H, sq);
+        for (int xo = 0; xo < W2; ++xo) {
+            const axis_coord cx = hw_q88_rounding::box_span(xo, W, sq);
+            const uint32_t n = (uint32_t)(cx.i1 - cx.i0 + 1) * (cy.i1 - cy.i0 + 1);
+            for (int c = 0; c < C; ++c) {
+                uint32_t sum = 0;
+                for (int y = cy.i0; y <= cy.i1; ++y)
+                    for (int x = cx.i0; x <= cx.i1; ++x)
+                        sum += s.color[((size_t)y * W + x) * C + c];
+                bad += s.out[((size_t)yo * W2 + xo) * C + c] != (sum + n / 2) / n;
+            }
+        }
+    }
+    return bad;
+}
+
+// Modelo del core box por tiles contra downscale_box_u8. Devuelve los bytes
+// distintos.
+static long check_core_box(const uint8_t *img, int W, int H, uint32_t sq, int W2, int H2,
+                           int max_w, int max_h, sweep_scratch &s) {
+    box_tables bt = build_box_tables(W, H, W2, H2, sq);
+    s.plane_ref.assign((size_t)W2 * H2, 0);
+    downscale_box_u8(img, W, bt, s.plane_ref.data());
+    s.out.assign((size_t)W2 * H2, 0);
+    run_core_model_image(W, H, sq, 1, max_w, max_h, img, s.out.data(), /*box=*/true);
+    return diff_u8(s.out.data(), W2, H2, s.plane_ref.data(), W2, H2).mismatches;
+}
+
+// API de vistas sobre un subrectangulo: la entrada va en (3, 2) de un
+// buffer con 5 columnas y 3 filas de mas, la salida en (1, 1) de uno con
+// borde de 1. La arena viene del tamaño anterior, asi que tambien prueba
+// rearmar tablas sobre vectores usados. Devuelve bytes distintos a ref,
+// bytes del borde pisados y reservas al repetir el cuadro.
+static long check_view(const variant &vr, const uint8_t *img, int W, int H, uint32_t sq,
+                       const coord_tables &t, const std::vector<uint8_t> &ref,
+                       sweep_scratch &s) {
+    const int BW = W + 5, BH = H + 3;
+    s.big.assign((size_t)BW * BH, 0x5A);
+    for (int y = 0; y < H; ++y)
+        std::copy(img + (size_t)y * W, img + (size_t)(y + 1) * W,
+                  s.big.begin() + (size_t)(y + 2) * BW + 3);
+    const int OW = t.W2 + 2, OH = t.H2 + 2;
+    s.big_out.assign((size_t)OW * OH, 0xA5);
+    const u8_view in = make_view(s.big.data(), BW, BH).sub(3, 2, W, H);
+    const u8_mut_view out = make_mut_view(s.big_out.data(), OW, OH).sub(1, 1, t.W2, t.H2);
+
+    auto run = [&] {
+        const coord_tables &vt = vr.hw ? s.arena.hw_tables(W, H, sq)
+                                       : s.arena.golden_tables(W, H, sq / 256.0);
+        downscale_u8_view(in, vt, out, s.arena, nullptr, vr.lvl);
+    };
+    run();
+    const long allocs = thread_allocs;
+    run();
+    long bad = thread_allocs - allocs;
+
+    for (int y = 0; y < OH; ++y) {
+        for (int x = 0; x < OW; ++x) {
+            const uint8_t p = s.big_out[(size_t)y * OW + x];
+            if (y >= 1 && y <= t.H2 && x >= 1 && x <= t.W2)
+                bad += p != ref[(size_t)(y - 1) * t.W2 + (x - 1)];
+            else
+                bad += p != 0xA5;
+        }
+    }
+    return bad;
+}
+
+// Corre la variante sobre las tablas t (de la semantica de la variante)
+static void run_variant(const variant &vr, const uint8_t *img, int W, int H, uint32_t sq,
+                        int max_w, int max_h, coord_tables &t, sweep_scratch &s) {
+    s.out.assign((size_t)t.W2 * t.H2, 0);
+    switch (vr.kind) {
+    case V_SIMD:
+        downscale_u8_rows(img, W, t, s.out.data(), 0, t.H2, vr.lvl, s.v.data());
+        break;
+    case V_SIMD_GENERIC: {
+        // mismo nivel sin el kernel de escala fija
+        const fixed_row_kernels *fixed = t.fixed;
+        t.fixed = nullptr;
+        downscale_u8_rows(img, W, t, s.out.data(), 0, t.H2, vr.lvl, s.v.data());
+        t.fixed = fixed;
+        break;
+    }
+    case V_STREAM: {
+        row_stream_downscaler rs(W, H, t, vr.lvl);
+        for (int y = 0; y < H; ++y)
+            rs.push_row(img + (size_t)y * W, [&](int yo, const uint8_t *row) {
+                std::copy(row, row + t.W2, s.out.begin() + (size_t)yo * t.W2);
+            });
+        break;
+    }
+    case V_PYRAMID: {
+        // la escala bajo prueba en el medio de otros dos niveles; se compara
+        // solo ese nivel
+        std::vector<coord_tables> levels;
+        levels.push_back(build_coord_tables(W, H, 1.0));
+        levels.push_back(t);
+        levels.push_back(build_coord_tables(W, H, 0.5));
+        pyramid_stream_downscaler ps(W, H, levels, vr.lvl);
+        for (int y = 0; y < H; ++y)
+            ps.push_row(img + (size_t)y * W, [&](int l, int yo, const uint8_t *row) {
+                if (l == 1) std::copy(row, row + t.W2, s.out.begin() + (size_t)yo * t.W2);
+            });
+        break;
+    }
+    case V_CORE:
+        run_core_model_image(W, H, sq, 1, max_w, max_h, img, s.out.data());
+        break;
+    case V_VIEW:       // va por check_view
+    case V_CHANNELS:   // va por check_channels
+    case V_BOX:        // va por check_box
+    case V_CORE_BOX:   // va por check_core_box
+        break;
+    }
+}
+
+static bool parse_wxh(const std::string &s, int &w, int &h) {
+    return std::sscanf(s.c_str(), "%dx%d", &w, &h) == 2 && w > 0 && h > 0;
+}
+
+// "97x5,160x40"; vacio no agrega nada
+static bool parse_sizes(const std::string &s, std::vector<std::pair<int, int>> &out) {
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        int w, h;
+        if (!parse_wxh(item, w, h)) return false;
+        out.push_back({w, h});
+    }
+    return true;
+}
+
+// "0x01:0x100" (rango) o "0x80,0xC0" (lista)
+static bool parse_scales(const std::string &s, std::vector<uint32_t> &out) {
+    try {
+        size_t colon = s.find(':');
+        if (colon != std::string::npos) {
+            uint32_t lo = (uint32_t)std::stoul(s.substr(0, colon), nullptr, 0);
+            uint32_t hi = (uint32_t)std::stoul(s.substr(colon + 1), nullptr, 0);
+            for (uint32_t q = lo; q <= hi; ++q) out.push_back(q);
+        } else {
+            std::stringstream ss(s);
+            std::string item;
+            while (std::getline(ss, item, ','))
+                if (!item.empty()) out.push_back((uint32_t)std::stoul(item, nullptr, 0));
+        }
+    } catch (const std::exception &) {
+        return false;
+    }
+    for (uint32_t q : out)
+        if (q == 0 || q > 0x100) return false;
+    return !out.empty();
+}
+
+int main(int argc, char **argv) {
+    std::string max_s = "32x32", scales_s = "0x01:0x100", extra_s = "97x5,160x40", csv_path;
+    int threads = 0;
+    bool quiet = false;
+
+    bool bad_args = false;
+    for (int i = 1; i < argc && !bad_args; ++i) {
+        std::string a = argv[i];
+        if (a == "--max" && i+1 < argc) max_s = argv[++i];
+        else if (a == "--scales" && i+1 < argc) scales_s = argv[++i];
+        else if (a == "--extra" && i+1 < argc) extra_s = argv[++i];
+        else if (a == "--threads" && i+1 < argc) threads = std::stoi(argv[++i]);
+        else if (a == "--csv" && i+1 < argc) csv_path = argv[++i];
+        else if (a == "--quiet") quiet = true;
+        else bad_args = true;
+    }
+    if (bad_args || threads < 0) {
+        std::cerr << "uso: " << argv[0]
+                  << " [--max 32x32] [--scales 0x01:0x100 | 0x80,0xC0]"
+                  << " [--extra 97x5,160x40 | \"\"] [--threads N]"
+                  << " [--csv salida.csv] [--quiet]\n";
+        return 1;
+    }
+
+    int max_w = 0, max_h = 0;
+    if (!parse_wxh(max_s, max_w, max_h)) {
+        std::cerr << "error: maximo invalido " << max_s << "\n";
+        return 1;
+    }
+    std::vector<uint32_t> scales;
+    if (!parse_scales(scales_s, scales)) {
+        std::cerr << "error: escalas invalidas " << scales_s << " (0 < q <= 0x100)\n";
+        return 1;
+    }
+
+    // Tamaños: la grilla hasta max_w x max_h y despues los extra (el core
+    // sigue con BRAM de max_w x max_h, asi que esos van por varios tiles)
+    std::vector<std::pair<int, int>> sizes;
+    for (int H = 1; H <= max_h; ++H)
+        for (int W = 1; W <= max_w; ++W)
+            sizes.push_back({W, H});
+    if (!parse_sizes(extra_s, sizes)) {
+        std::cerr << "error: tamaños extra invalidos " << extra_s << "\n";
+        return 1;
+    }
+    int widest = 0;
+    for (const auto &wh : sizes) widest = std::max(widest, wh.first);
+
+    // Una entrada por tamaño, la misma para todas las escalas
+    std::vector<std::vector<uint8_t>> inputs(sizes.size());
+    for (size_t n = 0; n < sizes.size(); ++n) {
+        const int W = sizes[n].first, H = sizes[n].second;
+        std::mt19937 rng(W * 1000 + H);
+        inputs[n].resize((size_t)W * H);
+        for (auto &p : inputs[n]) p = (uint8_t)rng();
+    }
+
+    thread_pool pool(threads);
+    const simd_level top = detect_simd_level();
+    const std::vector<variant> variants = make_variants(top);
+    std::vector<scale_result> res(scales.size());
+
+    std::printf("%zu escalas x %dx%d tamaños (+%zu extra), %u hilos, kernels hasta %s\n",
+                scales.size(), max_w, max_h, sizes.size() - (size_t)max_w * max_h, pool.size(),
+                simd_level_name(top));
+
+    using clk = std::chrono::steady_clock;
+    auto t0 = clk::now();
+
+    pool.parallel_for((int)scales.size(), [&](int k) {
+        scale_result &r = res[k];
+        r.sq = scales[k];
+        r.variant_bad.assign(variants.size(), 0);
+        sweep_scratch s;
+        s.v.resize(simd_scratch_len(widest));
+        std::ostringstream csv;
+
+        for (size_t n = 0; n < sizes.size(); ++n) {
+            const int W = sizes[n].first, H = sizes[n].second;
+            const uint8_t *img = inputs[n].data();
+            int hw_w, hw_h;
+            hw_out_dims(W, H, r.sq, 0, 0, hw_w, hw_h);
+            coord_tables tabs[2] = {build_coord_tables(W, H, r.sq / 256.0),
+                                    build_coord_tables_hw(W, H, hw_w, hw_h, r.sq)};
+
+            // Referencias escalares de las dos semanticas
+            std::vector<uint8_t> ref[2];
+            for (int f = 0; f < 2; ++f) {
+                ref[f].resize((size_t)tabs[f].W2 * tabs[f].H2);
+                downscale_u8_rows(img, W, tabs[f], ref[f].data(), 0, tabs[f].H2,
+                                  simd_level::scalar, s.v.data());
+            }
+            const coord_tables &g = tabs[0];
+            diff_stats hg = diff_u8(ref[1].data(), hw_w, hw_h, ref[0].data(), g.W2, g.H2);
+            const bool dims = hw_w != g.W2 || hw_h != g.H2;
+            ++r.sizes;
+            r.dims_differ += dims;
+            r.pix_differ += hg.mismatches != 0;
+            r.pixels += (long)std::min(hw_w, g.W2) * std::min(hw_h, g.H2);
+            if (hg.max_err > r.hw_golden.max_err) {
+                r.worst_w = W;
+                r.worst_h = H;
+            }
+            r.hw_golden.add(hg);
+
+            // Sin tiles posibles (una salida lee mas que la BRAM: box con escala
+            // chica o --max de 1) el driver rechaza la corrida y no se compara
+            const bool core_fits[2] = {
+                !plan_hw_tiles(W, H, hw_w, hw_h, r.sq, max_w, max_h, false).empty(),
+                !plan_hw_tiles(W, H, hw_w, hw_h, r.sq, max_w, max_h, true).empty()};
+
+            long kernel_bad = 0, core_bad = 0;
+            for (size_t i = 0; i < variants.size(); ++i) {
+                const variant &vr = variants[i];
+                coord_tables &t = tabs[vr.hw];
+                // sin kernel fijo la variante generica es la misma que la de arriba
+                if (vr.kind == V_SIMD_GENERIC && !t.fixed) continue;
+                const std::vector<uint8_t> &rf = ref[vr.hw];
+                long bad;
+                if (vr.kind == V_CHANNELS) {
+                    bad = check_channels(vr, img, W, H, t, rf, s);
+                } else if (vr.kind == V_BOX) {
+                    bad = check_box(vr, img, W, H, r.sq, hw_w, hw_h, s);
+                } else if (vr.kind == V_CORE_BOX) {
+                    if (!core_fits[1]) continue;
+                    bad = check_core_box(img, W, H, r.sq, hw_w, hw_h, max_w, max_h, s);
+                } else if (vr.kind == V_VIEW) {
+                    bad = check_view(vr, img, W, H, r.sq, t, rf, s);
+                } else {
+                    if (vr.kind == V_CORE && !core_fits[0]) continue;
+                    run_variant(vr, img, W, H, r.sq, max_w, max_h, t, s);
+                    bad = diff_u8(s.out.data(), t.W2, t.H2, rf.data(), t.W2, t.H2).mismatches;
+                }
+                if (!bad) continue;
+                ++r.variant_bad[i];
+                (vr.kind == V_CORE || vr.kind == V_CORE_BOX ? core_bad : kernel_bad) += bad;
+            }
+
+            if (!csv_path.empty())
+                csv << W << "," << H << "," << r.sq << "," << hw_w << "," << hw_h << ","
+                    << g.W2 << "," << g.H2 << "," << hg.mismatches << "," << hg.max_err << ","
+                    << kernel_bad << "," << core_bad << "\n";
+        }
+        r.csv = csv.str();
+    });
+
+    double secs = std::chrono::duration<double>(clk::now() - t0).count();
+
+    if (!quiet)
+        std::printf("%6s %9s %9s %9s %9s %7s\n",
+                    "escala", "dims!=", "pix!=", "%px!=", "err_max", "peor");
+    long n_cfg = 0, n_dims = 0, n_pix = 0;
+    int worst_err = 0;
+    uint32_t worst_sq = 0;
+    std::vector<long> variant_bad(variants.size(), 0);
+    for (const scale_result &r : res) {
+        n_cfg += r.sizes;
+        n_dims += r.dims_differ;
+        n_pix += r.pix_differ;
+        if (r.hw_golden.max_err > worst_err) {
+            worst_err = r.hw_golden.max_err;
+            worst_sq = r.sq;
+        }
+        for (size_t i = 0; i < variants.size(); ++i)
+            variant_bad[i] += r.variant_bad[i];
+        if (quiet) continue;
+        std::printf(" 0x%03X %9d %9d %8.3f%% %9d",
+                    r.sq, r.dims_differ, r.pix_differ,
+                    r.pixels ? 100.0 * r.hw_golden.mismatches / r.pixels : 0.0, r.hw_golden.max_err);
+        if (r.hw_golden.max_err)
+            std::printf(" %3dx%-3d", r.worst_w, r.worst_h);
+        std::printf("\n");
+    }
+
+    std::printf("hw vs golden: %ld de %ld configuraciones con otras dimensiones, %ld con pixeles distintos,"
+                " error maximo %d", n_dims, n_cfg, n_pix, worst_err);
+    if (worst_err)
+        std::printf(" (escala 0x%03X)", worst_sq);
+    std::printf("\n");
+
+    int n_fail = 0;
+    for (size_t i = 0; i < variants.size(); ++i) {
+        const variant &vr = variants[i];
+        if (!variant_bad[i]) {
+            std::printf("%-22s ok\n", vr.name.c_str());
+            continue;
+        }
+        // el core con 0x01 diverge siempre (inv_scale_q de 16 bits): no cuenta
+        long expected = 0;
+        if (vr.kind == V_CORE || vr.kind == V_CORE_BOX)
+            for (const scale_result &r : res)
+                if (r.sq == 0x01) expected = r.variant_bad[i];
+        long bad = variant_bad[i] - expected;
+        if (bad) ++n_fail;
+        std::printf("%-22s %ld configuraciones distintas al escalar", vr.name.c_str(), bad);
+        if (expected)
+            std::printf(" (+%ld con 0x01, esperado)", expected);
+        std::printf("\n");
+    }
+
+    if (!csv_path.empty()) {
+        std::ofstream f(csv_path);
+        if (!f) {
+            std::cerr << "error: no se pudo abrir " << csv_path << "\n";
+            return 1;
+        }
+        f << "w_in,h_in,scale_q8_8,hw_w_out,hw_h_out,golden_w_out,golden_h_out,"
+             "hw_golden_mismatches,hw_golden_max_err,kernel_mismatches,core_mismatches\n";
+        for (const scale_result &r : res) f << r.csv;
+        std::printf("listo %s\n", csv_path.c_str());
+    }
+
+    std::printf("%ld configuraciones en %.2f s: %s\n", n_cfg, secs,
+                n_fail ? "HAY KERNELS DISTINTOS A SU REFERENCIA" : "kernels ok");
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+// pc/core_model.cpp
+// Barrido de configuraciones del core con el modelo de ciclos
+// (model/core_cycle_model.h), sin simular el RTL.
+//
+// Para cada tamaño de imagen, escala Q8.8, cantidad de lanes N y BRAM
+// (max_w x max_h = W_MAX x H_MAX del core) parte la imagen en tiles como el
+// driver JTAG y suma PERF_CYC / PERF_PIX de todos los tiles. Con --mhz pasa
+// los ciclos a cuadros por segundo (solo el core, sin JTAG).
+//
+// Con --in (un solo tamaño) el modelo produce tambien los pixeles, los
+// compara contra el modelo Q8.8 del driver (build_coord_tables_hw) y --out
+// guarda la salida del ultimo caso.
+//
+// Compilar: make core_model   (o)
+//   g++ -std=c++17 -O2 -o pc/core_model pc/core_model.cpp
+//
+// Ej.: elegir N y BRAM para 640x480 a 0.5
+//   ./pc/core_model --sizes 640x480 --scales 0x80 --lanes 1,2,4,8,16
+//                   --max 32x32,64x64,128x128 --csv results/core_model.csv
+// Con 0x01 los pixeles no coinciden con el driver: inv_scale_q = 65536 no
+// entra en los 16 bits del registro y el core (y este modelo) usa 0.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../model/core_cycle_model.h"
+#include "../model/image_io.h"
+
+static std::vector<std::string> split_list(const std::string &s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+static bool parse_wxh(const std::string &s, int &w, int &h) {
+    return std::sscanf(s.c_str(), "%dx%d", &w, &h) == 2 && w > 0 && h > 0;
+}
+
+int main(int argc, char **argv) {
+    std::string sizes = "32x32,640x480,1920x1080";
+    std::string scales = "0x40,0x80,0xC0,0x100";
+    std::string lanes_s = "1,2,4,8";
+    std::string maxes = "32x32,64x64";
+    std::string in_path, out_path, csv_path;
+    double mhz = 50.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--sizes" && i+1 < argc) sizes = argv[++i];
+        else if (a == "--scales" && i+1 < argc) scales = argv[++i];
+        else if (a == "--lanes" && i+1 < argc) lanes_s = argv[++i];
+        else if (a == "--max" && i+1 < argc) maxes = argv[++i];
+        else if (a == "--in" && i+1 < argc) in_path = argv[++i];
+        else if (a == "--out" && i+1 < argc) out_path = argv[++i];
+        else if (a == "--csv" && i+1 < argc) csv_path = argv[++i];
+        else if (a == "--mhz" && i+1 < argc) mhz = std::stod(argv[++i]);
+        else {
+            std::cerr << "uso: " << argv[0]
+                      << " [--sizes 32x32,640x480] [--scales 0x80,0x100] [--lanes 1,4]"
+                      << " [--max 32x32,64x64] [--mhz 50] [--csv salida.csv]"
+                      << " [--in entrada.raw [--out salida.raw]]\n";
+            return 1;
+        }
+    }
+
+    std::vector<std::string> size_list = split_list(sizes);
+    if (!in_path.empty() && size_list.size() != 1) {
+        std::cerr << "error: --in necesita un solo tamaño en --sizes\n";
+        return 1;
+    }
+    if (!out_path.empty() && in_path.empty()) {
+        std::cerr << "error: --out necesita --in\n";
+        return 1;
+    }
+
+    std::ofstream csv;
+    if (!csv_path.empty()) {
+        csv.open(csv_path);
+        if (!csv) {
+            std::cerr << "error: no se pudo abrir " << csv_path << "\n";
+            return 1;
+        }
+        csv << "w_in,h_in,scale_q8_8,lanes,max_w,max_h,w_out,h_out,tiles,"
+               "perf_cyc,perf_pix,pix_per_cyc,lane_util,bram_bytes,fps"
+            << (in_path.empty() ? "" : ",mismatches") << "\n";
+    }
+
+    std::printf("%11s %6s %5s %9s %11s %6s %11s %11s %7s %6s %10s%s\n",
+                "entrada", "escala", "lanes", "bram", "salida", "tiles",
+                "perf_cyc", "perf_pix", "pix/cyc", "lanes%", "fps", in_path.empty() ? "" : "  pixeles");
+
+    using clk = std::chrono::steady_clock;
+    auto t0 = clk::now();
+    int n_cfg = 0, n_bad = 0;
+
+    for (const auto &sz : size_list) {
+        int W = 0, H = 0;
+        if (!parse_wxh(sz, W, H)) {
+            std::cerr << "error: tamaño invalido " << sz << "\n";
+            return 1;
+        }
+        mapped_image src;
+        if (!in_path.empty()) {
+            try {
+                src = map_image_u8(in_path, W, H, /*pad_short=*/true);
+            } catch (const std::exception &e) {
+                std::cerr << "error: " << e.what() << "\n";
+                return 1;
+            }
+        }
+
+        for (const auto &sc : split_list(scales)) {
+            uint32_t sq = (uint32_t)std::stoul(sc, nullptr, 0);
+            if (sq == 0 || sq > 0x100) {
+                std::cerr << "error: escala invalida " << sc << " (0 < q <= 0x100)\n";
+                return 1;
+            }
+
+            // Referencia del driver para comparar pixeles (no depende de N ni de la BRAM)
+            std::vector<uint8_t> ref;
+            if (src.pix) {
+                int ow, oh;
+                hw_out_dims(W, H, sq, 0, 0, ow, oh);
+                ref.resize((size_t)ow * oh);
+                coord_tables tab = build_coord_tables_hw(W, H, ow, oh, sq);
+                downscale_u8(src.pix, W, tab, ref.data());
+            }
+
+            for (const auto &ls : split_list(lanes_s)) {
+                int lanes = std::stoi(ls);
+                if (lanes < 1) {
+                    std::cerr << "error: lanes invalido " << ls << "\n";
+                    return 1;
+                }
+                for (const auto &mx : split_list(maxes)) {
+                    int max_w = 0, max_h = 0;
+                    if (!parse_wxh(mx, max_w, max_h)) {
+                        std::cerr << "error: BRAM invalida " << mx << "\n";
+                        return 1;
+                    }
+
+                    std::vector<uint8_t> out(ref.size());
+                    core_image_stats r = run_core_model_image(W, H, sq, lanes, max_w, max_h,
+                                                              src.pix, src.pix ? out.data() : nullptr);
+                    const core_stats &c = r.core;
+                    const double ppc = c.perf_cyc ? (double)c.perf_pix / c.perf_cyc : 0.0;
+                    const double util = c.lane_slots ? 100.0 * c.perf_pix / c.lane_slots : 0.0;
+                    const double fps = c.perf_cyc ? mhz * 1e6 / c.perf_cyc : 0.0;
+                    // entrada + salida, un banco
+                    const long bram_bytes = 2L * max_w * max_h;
+
+                    long bad = -1;
+                    if (src.pix) {
+                        bad = 0;
+                        for (size_t i = 0; i < out.size(); ++i)
+                            bad += out[i] != ref[i];
+                        if (bad) ++n_bad;
+                        if (!out_path.empty()) {
+                            try {
+                                write_image_u8(out_path, out.data(), r.out_w, r.out_h);
+                            } catch (const std::exception &e) {
+                                std::cerr << "error: " << e.what() << "\n";
+                                return 1;
+                            }
+                        }
+                    }
+
+                    std::printf("%5dx%-5d  0x%03X %5d %4dx%-4d %5dx%-5d %6d %11llu %11llu %7.3f %6.1f %10.1f",
+                                W, H, sq, lanes, max_w, max_h, r.out_w, r.out_h, r.tiles,
+                                (unsigned long long)c.perf_cyc, (unsigned long long)c.perf_pix,
+                                ppc, util, fps);
+                    if (bad >= 0)
+                        std::printf(bad ? "  %ld mismatches" : "  ok", bad);
+                    std::printf("\n");
+
+                    if (csv.is_open()) {
+                        csv << W << "," << H << "," << sq << "," << lanes << ","
+                            << max_w << "," << max_h << "," << r.out_w << "," << r.out_h << ","
+                            << r.tiles << "," << c.perf_cyc << "," << c.perf_pix << ","
+                            << ppc << "," << util / 100.0 << "," << bram_bytes << "," << fps;
+                        if (bad >= 0) csv << "," << bad;
+                        csv << "\n";
+                    }
+                    ++n_cfg;
+                }
+            }
+        }
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+    std::printf("%d configuraciones en %.1f ms", n_cfg, ms);
+    if (!in_path.empty())
+        std::printf(", %d con pixeles distintos al modelo del driver", n_bad);
+    std::printf("\n");
+    if (!csv_path.empty())
+        std::printf("listo %s\n", csv_path.c_str());
+    return n_bad ? 1 : 0;
+}
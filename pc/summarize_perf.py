@@ -2,29 +2,122 @@
 """
 Muestra un resumen simple a partir de meta.json
 Si hay perf_cyc y perf_pix calcula pixeles por ciclo
+Si viene del driver JTAG (stages_ms) muestra en que etapa se va el tiempo
+Con --bench lee el JSON de pc/bench_downscale y pone los Mpix/s de la CPU
+al lado de los de la FPGA (pixeles por ciclo * reloj)
+Si el meta trae cpu_perf (downscale_ref_cpp --perf-meta) muestra los
+contadores de la CPU; con --cpu meta_cpu.json los pone al lado del meta de
+la FPGA (ciclos/pixel de cada lado)
 """
-import argparse, json
-
-def main():
-    ap = argparse.ArgumentParser()
-    ap.add_argument("--meta", default="results/meta.json")
-    args = ap.parse_args()
-
-    with open(args.meta) as f:
-        m = json.load(f)
+import argparse, json, os
 
+def resumen_meta(m):
     print("=== Resumen ===")
-    print(f"entrada {m['w_in']}x{m['h_in']}")
-    print(f"scale {m['scale']}")
-    print(f"salida {m['w_out']}x{m['h_out']}")
+    if m.get("w_in") is None:
+        # lote del driver con imagenes distintas: el detalle esta en images
+        print(f"{len(m.get('images', []))} imagenes de distinto tamaño/escala (ver images)")
+    else:
+        print(f"entrada {m['w_in']}x{m['h_in']}")
+        print(f"scale {m['scale']}")
+        print(f"salida {m['w_out']}x{m['h_out']}")
     print(f"modo {m.get('mode','-')}  unidades {m.get('units','-')}")
     pc = m.get("perf_cyc"); pp = m.get("perf_pix")
+    lote = " (total del lote)" if m.get("frames", 1) > 1 else ""
+    tpp = None
     if pc is not None and pp is not None and pc > 0:
         tpp = pp/pc
-        print(f"pixeles por ciclo {tpp:.3f}")
+        print(f"pixeles por ciclo {tpp:.3f}{lote}")
     else:
         print("pixeles por ciclo sin datos aun")
+    st = m.get("stages_ms")
+    if st:
+        total = sum(st.values())
+        print(f"cuadros {m.get('frames', 1)} ({m.get('frames_ok', '-')} OK)  "
+              f"pared {m.get('wall_ms', 0):.1f} ms  arranque system-console {m.get('sc_start_ms', 0):.1f} ms")
+        for k, v in st.items():
+            pct = 100*v/total if total > 0 else 0
+            print(f"  {k:9s} {v:10.2f} ms {pct:5.1f}%")
+    if m.get("cpu_perf"):
+        resumen_cpu(m["cpu_perf"])
+    print("===============")
+    return tpp
+
+def fmt(x, f="{:.2f}"):
+    return "-" if x is None else f.format(x)
+
+def resumen_cpu(c):
+    print(f"CPU (perf_event): {fmt(c.get('cycles_per_pixel'))} ciclos/px, "
+          f"{fmt(c.get('instructions_per_pixel'))} instr/px, IPC {fmt(c.get('ipc'))}")
+    print(f"  fallos por px: L1d {fmt(c.get('l1d_misses_per_pixel'), '{:.3f}')}, "
+          f"LLC {fmt(c.get('llc_misses_per_pixel'), '{:.3f}')}, "
+          f"saltos {fmt(c.get('branch_misses_per_pixel'), '{:.4f}')}")
+    print(f"  bytes/px {fmt(c.get('bytes_per_pixel'))} (LLC {fmt(c.get('llc_bytes_per_pixel'))}), "
+          f"{fmt(c.get('ns_per_pixel'))} ns/px de CPU")
+    if c.get("cycles") is None:
+        print("  sin contadores de HW (VM sin PMU o perf_event_paranoid)")
+    bandas = c.get("bands", [])
+    key = "cycles_per_pixel" if c.get("cycles") is not None else "ns_per_pixel"
+    vals = [b[key] for b in bandas if b.get(key) is not None]
+    if vals:
+        print(f"  {len(bandas)} bandas, {key} min {min(vals):.2f} max {max(vals):.2f}")
+
+def compara_cpu_fpga(fpga, cpu):
+    """ciclos/px de la CPU contra los de la FPGA (y pixeles por ciclo)"""
+    c = cpu.get("cpu_perf", {})
+    print("=== CPU vs FPGA ===")
+    cpp = c.get("cycles_per_pixel")
+    pc = fpga.get("perf_cyc"); pp = fpga.get("perf_pix")
+    fpp = pc/pp if pc and pp else None
+    print(f"CPU  {fmt(cpp)} ciclos/px ({fmt(1/cpp if cpp else None, '{:.3f}')} px/ciclo, "
+          f"{cpu.get('units', 1)} hilos)")
+    print(f"FPGA {fmt(fpp)} ciclos/px ({fmt(1/fpp if fpp else None, '{:.3f}')} px/ciclo)")
+    if cpp and fpp:
+        print(f"la CPU usa {cpp/fpp:.2f}x los ciclos por pixel de la FPGA")
+    print("===============")
+
+def resumen_bench(b, tpp, mhz):
+    print(f"=== Benchmark CPU ({b.get('simd','-')}, {b.get('threads','-')} hilos) ===")
+    fpga = tpp * mhz if tpp is not None else None
+    if fpga is not None:
+        print(f"FPGA: {tpp:.3f} px/ciclo a {mhz:g} MHz = {fpga:.1f} Mpix/s (sin contar JTAG)")
+    con_perf = any("perf" in r for r in b["runs"])
+    extra = f" {'cic/px':>7s} {'IPC':>5s} {'B/px':>6s}" if con_perf else ""
+    print(f"{'motor':7s} {'entrada':>11s} {'escala':>6s} {'Mpix/s':>9s} {'ns/px':>8s} {'p99_us':>10s}{extra}  gana")
+    for r in b["runs"]:
+        gana = "-"
+        if fpga is not None:
+            gana = "CPU" if r["mpix_s"] > fpga else "FPGA"
+        entrada = f"{r['w_in']}x{r['h_in']}"
+        extra = ""
+        if con_perf:
+            p = r.get("perf", {})
+            extra = (f" {fmt(p.get('cycles_per_pixel')):>7s} {fmt(p.get('ipc')):>5s}"
+                     f" {fmt(p.get('bytes_per_pixel'), '{:.1f}'):>6s}")
+        print(f"{r['engine']:7s} {entrada:>11s} 0x{r['scale_q8_8']:03X} "
+              f"{r['mpix_s']:9.1f} {r['ns_px']:8.3f} {r['p99_ns']/1e3:10.1f}{extra}  {gana}")
     print("===============")
 
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--meta", default="results/meta.json")
+    ap.add_argument("--bench", default=None, help="JSON de pc/bench_downscale")
+    ap.add_argument("--fpga-mhz", type=float, default=50.0, help="reloj del core en la FPGA")
+    ap.add_argument("--cpu", default=None, help="meta.json de downscale_ref_cpp --perf-meta")
+    args = ap.parse_args()
+
+    tpp = None
+    if args.bench is None or os.path.exists(args.meta):
+        with open(args.meta) as f:
+            m = json.load(f)
+        tpp = resumen_meta(m)
+        if args.cpu is not None:
+            with open(args.cpu) as f:
+                compara_cpu_fpga(m, json.load(f))
+
+    if args.bench is not None:
+        with open(args.bench) as f:
+            b = json.load(f)
+        resumen_bench(b, tpp, args.fpga_mhz)
+
 if __name__ == "__main__":
     main()
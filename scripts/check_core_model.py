@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""
+Valida el modelo de ciclos (pc/core_model) contra el RTL.
+
+Para cada caso corre tb/top/tb_core_cycles.sv con iverilog (bilinear_top,
+escalar o SIMD) y el modelo con los mismos tamaños y escala, y compara
+PERF_CYC, PERF_PIX y los bytes de salida. Sin iverilog avisa y sale con 0,
+igual que los targets de simulacion del Makefile.
+
+Uso:
+  make core_model_check     (o)
+  python3 scripts/check_core_model.py
+"""
+import csv, os, random, re, shutil, subprocess, sys
+
+# (w, h, scale_q8_8, lanes); lanes = 1 es el core escalar
+CASES = [
+    (32, 32, 0x80, 1),
+    (32, 32, 0x80, 4),
+    (17, 23, 0xB3, 1),
+    (17, 23, 0xB3, 3),
+    (17, 23, 0xB3, 4),
+    (31, 17, 0xC0, 2),
+    (20, 9, 0x55, 8),
+    (32, 32, 0x100, 4),
+]
+
+# N del bilinear_top cuando se prueba el escalar (solo usa el lane 0)
+SCALAR_TOP_N = 4
+
+def hw_dims(w, h, sq):
+    w2 = min(max(1, (w * sq) >> 8), w)
+    h2 = min(max(1, (h * sq) >> 8), h)
+    return w2, h2
+
+def inv_scale_q(sq):
+    return 0x100 if sq == 0 else (65536 // sq) & 0xFFFF
+
+def make_input(w, h):
+    path = f"results/core_cycles_in_{w}x{h}.raw"
+    rnd = random.Random(w * 1000 + h)
+    with open(path, "wb") as f:
+        f.write(bytes(rnd.randrange(256) for _ in range(w * h)))
+    return path
+
+def run_rtl(w, h, sq, lanes, in_path, out_path):
+    w2, h2 = hw_dims(w, h, sq)
+    n = SCALAR_TOP_N if lanes == 1 else lanes
+    params = {
+        "N": n, "MODE": 0 if lanes == 1 else 1,
+        "IN_W": w, "IN_H": h, "OUT_W": w2, "OUT_H": h2, "INV": inv_scale_q(sq),
+    }
+    cmd = ["iverilog", "-g2012", "-o", "results/tb_core_cycles"]
+    cmd += [f"-Ptb_core_cycles.{k}={v}" for k, v in params.items()]
+    cmd += [f'-Ptb_core_cycles.IN_FILE="{in_path}"', f'-Ptb_core_cycles.OUT_FILE="{out_path}"']
+    cmd += ["tb/top/tb_core_cycles.sv", "tb/rtl/bilinear_top.sv",
+            "tb/rtl/bilinear_core_scalar.sv", "tb/rtl/bilinear_core_simd.sv"]
+    subprocess.check_call(cmd)
+    log = subprocess.run(["vvp", "results/tb_core_cycles"], capture_output=True, text=True).stdout
+    m = re.search(r"PERF_CYC=(\d+) PERF_PIX=(\d+)", log)
+    if not m:
+        raise RuntimeError("el tb no imprimio PERF_CYC/PERF_PIX:\n" + log)
+    return int(m.group(1)), int(m.group(2))
+
+def run_model(w, h, sq, lanes, in_path, out_path):
+    csv_path = "results/core_model_check.csv"
+    subprocess.run(["./pc/core_model", "--sizes", f"{w}x{h}", "--scales", hex(sq),
+                    "--lanes", str(lanes), "--max", f"{w}x{h}",
+                    "--in", in_path, "--out", out_path, "--csv", csv_path],
+                   stdout=subprocess.DEVNULL)
+    with open(csv_path, newline="") as f:
+        row = next(csv.DictReader(f))
+    return int(row["perf_cyc"]), int(row["perf_pix"])
+
+def main():
+    if shutil.which("iverilog") is None or shutil.which("vvp") is None:
+        print("no hay iverilog instalado, se omite core_model_check")
+        return 0
+    os.makedirs("results", exist_ok=True)
+
+    bad = 0
+    for w, h, sq, lanes in CASES:
+        in_path = make_input(w, h)
+        rtl_out, mdl_out = "results/core_cycles_rtl.raw", "results/core_cycles_model.raw"
+        rtl = run_rtl(w, h, sq, lanes, in_path, rtl_out)
+        mdl = run_model(w, h, sq, lanes, in_path, mdl_out)
+        with open(rtl_out, "rb") as a, open(mdl_out, "rb") as b:
+            same = a.read() == b.read()
+        ok = rtl == mdl and same
+        bad += not ok
+        print(f"{w}x{h} s=0x{sq:03X} lanes={lanes}: RTL cyc={rtl[0]} pix={rtl[1]}"
+              f"  modelo cyc={mdl[0]} pix={mdl[1]}  pixeles {'iguales' if same else 'DISTINTOS'}"
+              f"  {'ok' if ok else 'FAIL'}")
+
+    print(f"core_model_check: {len(CASES) - bad} de {len(CASES)} casos ok")
+    return 1 if bad else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -82,6 +82,10 @@ set REG_IN_DATA   0x0021
 set REG_OUT_ADDR  0x0030
 set REG_OUT_DATA  0x0031
 
+# Ventanas de ráfaga (auto-incremento sobre in_ptr/out_ptr)
+set REG_IN_WIN    0x1000
+set REG_OUT_WIN   0x1400
+
 proc reg_write {mp base_idx reg_idx value} {
     set addr [expr {$base_idx + 4 * $reg_idx}]
     master_write_32 $mp $addr [list $value]
@@ -140,40 +144,14 @@ if {$num_bytes < $expected_b} {
 set total_words [expr {($expected_b + 3) / 4}]
 puts "Total píxeles: $total_pix, total palabras: $total_words"
 
-# Poner puntero de entrada a 0
-reg_write $mp $BASE_ADDR $REG_IN_ADDR 0
-
-set idx 0
-for {set w 0} {$w < $total_words} {incr w} {
-    set b0 0
-    set b1 0
-    set b2 0
-    set b3 0
-
-    if {$idx < $num_bytes} {
-        scan [string index $raw_data $idx] %c b0
-    }
-    incr idx
-
-    if {$idx < $num_bytes} {
-        scan [string index $raw_data $idx] %c b1
-    }
-    incr idx
-
-    if {$idx < $num_bytes} {
-        scan [string index $raw_data $idx] %c b2
-    }
-    incr idx
-
-    if {$idx < $num_bytes} {
-        scan [string index $raw_data $idx] %c b3
-    }
-    incr idx
+# Relleno con 0 hasta total_words*4 bytes y palabras little-endian
+# (píxel 0 en el LSB)
+set pad [expr {$total_words * 4 - $num_bytes}]
+binary scan "$raw_data[string repeat "\x00" $pad]" iu* in_words
 
-    # Píxel 0 en byte menos significativo (LSB)
-    set word [expr {($b3 << 24) | ($b2 << 16) | ($b1 << 8) | $b0}]
-    reg_write $mp $BASE_ADDR $REG_IN_DATA $word
-}
+# Puntero de entrada a 0 y toda la imagen en una ráfaga por IN_WIN
+reg_write $mp $BASE_ADDR $REG_IN_ADDR 0
+master_write_32 $mp [expr {$BASE_ADDR + 4 * $REG_IN_WIN}] $in_words
 
 puts "Escritura de BRAM de entrada completa."
 
@@ -223,29 +201,16 @@ set out_words  [expr {($out_bytes + 3) / 4}]
 
 puts "Lectura de salida: $out_pix píxeles, $out_words palabras."
 
-# Poner OUT_ADDR en 0
+# OUT_ADDR en 0 y toda la salida en una ráfaga por OUT_WIN
 reg_write $mp $BASE_ADDR $REG_OUT_ADDR 0
 
-set out_bytes_list {}
-
-for {set w 0} {$w < $out_words} {incr w} {
-    set word [reg_read $mp $BASE_ADDR $REG_OUT_DATA]
-    # Extraer bytes en el mismo orden: LSB = primer píxel
-    set b0 [expr {$word        & 0xFF}]
-    set b1 [expr {($word >> 8) & 0xFF}]
-    set b2 [expr {($word >>16) & 0xFF}]
-    set b3 [expr {($word >>24) & 0xFF}]
-    lappend out_bytes_list $b0 $b1 $b2 $b3
+set out_words_list {}
+if {$out_words > 0} {
+    set out_words_list [master_read_32 $mp [expr {$BASE_ADDR + 4 * $REG_OUT_WIN}] $out_words]
 }
 
-# Recorta exactamente out_bytes
-set out_bytes_list [lrange $out_bytes_list 0 [expr {$out_bytes - 1}]]
-
-# Construir string binario
-set out_str ""
-foreach b $out_bytes_list {
-    append out_str [format %c $b]
-}
+# Mismo orden: LSB = primer píxel; recorta exactamente out_bytes
+set out_str [string range [binary format i* $out_words_list] 0 [expr {$out_bytes - 1}]]
 
 set fh_out [open $out_raw "wb"]
 fconfigure $fh_out -translation binary -encoding binary
@@ -0,0 +1,229 @@
+# Servidor de comandos para dsa_top_seq (una sola sesión de system-console).
+# - El driver lo lanza una vez y le manda comandos por stdin, una línea cada
+#   uno; así el arranque de system-console y el claim del master JTAG se
+#   pagan una sola vez para muchas imágenes/tiles.
+# - Cada comando contesta UNA línea que empieza con @@ (lo demás que imprima
+#   system-console el driver lo ignora):
+#     @@ok [valores]     o     @@err <mensaje>
+# - Al arrancar imprime "@@ready" cuando ya tiene el master.
+#
+# Comandos:
+#   ping                                  -> @@ok pong
+#   wr <reg> <valor>                      -> @@ok
+#   rd <reg>                              -> @@ok <valor>
+#   cfg <img_w> <img_h> <scale_q8_8> <src_w> <src_h> <org_x> <org_y>
+#       <off_x> <off_y> <tile_ow> <tile_oh> [<mode>]
+#                                         -> @@ok    (src_w = 0: sin tiling;
+#                                                     mode 2 = box, por defecto 0)
+#   load <entrada.raw>                    -> @@ok <palabras>   (ráfaga IN_WIN)
+#   run                                   -> @@ok <perf_cyc> <perf_pix>
+#   bank <core> <host>                    -> @@ok    (bancos ping-pong)
+#   start                                 -> @@ok    (START sin esperar)
+#   wait                                  -> @@ok <perf_cyc> <perf_pix>
+#   dump <salida.raw> <pixeles>           -> @@ok <pixeles>    (ráfaga OUT_WIN)
+#   quit                                  -> @@ok bye
+#
+# Uso (lo hace dsa_jtag_driver):
+#   system-console -cli --script=dsa_jtag_server.tcl <ruta_qpf>
+
+# 1) Master JTAG
+set masters [get_service_paths master]
+if {[llength $masters] == 0} {
+    puts "@@err no se encontró servicio master"
+    flush stdout
+    exit 1
+}
+set mp [claim_service master [lindex $masters 0] "dsa_jtag_master"]
+set BASE_ADDR 0x00000000
+
+# 2) Mapa de registros (igual que dsa_jtag_test_16x16_raw.tcl)
+set REG_CTRL      0x0000
+set REG_STATUS    0x0001
+set REG_IMG_W     0x0002
+set REG_IMG_H     0x0003
+set REG_SCALE     0x0004
+set REG_MODE      0x0005
+set REG_PERF_CYC  0x0006
+set REG_PERF_PIX  0x0007
+
+set REG_SRC_W     0x0008
+set REG_SRC_H     0x0009
+set REG_ORG_X     0x000A
+set REG_ORG_Y     0x000B
+set REG_OFF_X     0x000C
+set REG_OFF_Y     0x000D
+set REG_TILE_OW   0x000E
+set REG_TILE_OH   0x000F
+
+set REG_BANK      0x0010
+
+set REG_IN_ADDR   0x0020
+set REG_IN_DATA   0x0021
+set REG_OUT_ADDR  0x0030
+set REG_OUT_DATA  0x0031
+
+# Ventanas de ráfaga (auto-incremento sobre in_ptr/out_ptr)
+set REG_IN_WIN    0x1000
+set REG_OUT_WIN   0x1400
+set WIN_WORDS     0x0400
+
+# Polls de STATUS antes de rendirse en "run"
+set RUN_MAX_POLLS 100000
+
+proc reg_write {reg_idx value} {
+    global mp BASE_ADDR
+    master_write_32 $mp [expr {$BASE_ADDR + 4 * $reg_idx}] [list $value]
+}
+
+proc reg_read {reg_idx} {
+    global mp BASE_ADDR
+    return [lindex [master_read_32 $mp [expr {$BASE_ADDR + 4 * $reg_idx}] 1] 0]
+}
+
+# Ráfagas: una lista de palabras por master_write_32/master_read_32, en
+# trozos del tamaño de la ventana
+proc burst_write {reg_idx words} {
+    global mp BASE_ADDR WIN_WORDS
+    set addr [expr {$BASE_ADDR + 4 * $reg_idx}]
+    for {set i 0} {$i < [llength $words]} {incr i $WIN_WORDS} {
+        master_write_32 $mp $addr [lrange $words $i [expr {$i + $WIN_WORDS - 1}]]
+    }
+}
+
+proc burst_read {reg_idx nwords} {
+    global mp BASE_ADDR WIN_WORDS
+    set addr [expr {$BASE_ADDR + 4 * $reg_idx}]
+    set words {}
+    for {set i 0} {$i < $nwords} {incr i $WIN_WORDS} {
+        set n [expr {min($WIN_WORDS, $nwords - $i)}]
+        lappend words {*}[master_read_32 $mp $addr $n]
+    }
+    return $words
+}
+
+proc reply {msg} {
+    puts "@@$msg"
+    flush stdout
+}
+
+# 3) Comandos
+proc cmd_cfg {args} {
+    global REG_IMG_W REG_IMG_H REG_SCALE REG_MODE REG_SRC_W REG_SRC_H \
+           REG_ORG_X REG_ORG_Y REG_OFF_X REG_OFF_Y REG_TILE_OW REG_TILE_OH
+    if {[llength $args] != 11 && [llength $args] != 12} {
+        error "cfg espera 11 o 12 valores"
+    }
+    set regs [list $REG_IMG_W $REG_IMG_H $REG_SCALE $REG_SRC_W $REG_SRC_H \
+                   $REG_ORG_X $REG_ORG_Y $REG_OFF_X $REG_OFF_Y $REG_TILE_OW $REG_TILE_OH]
+    foreach r $regs v [lrange $args 0 10] {
+        reg_write $r $v
+    }
+    set mode 0
+    if {[llength $args] == 12} {
+        set mode [lindex $args 11]
+    }
+    reg_write $REG_MODE $mode
+    return ""
+}
+
+proc cmd_load {path} {
+    global REG_IN_ADDR REG_IN_WIN
+    set fd [open $path "rb"]
+    fconfigure $fd -translation binary -encoding binary
+    set data [read $fd]
+    close $fd
+
+    # Relleno a múltiplo de 4 y palabras little-endian (b3 b2 b1 b0)
+    set pad [expr {(4 - [string length $data] % 4) % 4}]
+    append data [string repeat "\x00" $pad]
+    binary scan $data iu* words
+
+    reg_write $REG_IN_ADDR 0
+    burst_write $REG_IN_WIN $words
+    return [llength $words]
+}
+
+proc cmd_bank {core host} {
+    global REG_BANK
+    reg_write $REG_BANK [expr {(($core & 1) << 1) | ($host & 1)}]
+    return ""
+}
+
+proc cmd_start {} {
+    global REG_CTRL
+    reg_write $REG_CTRL 0x00000001   ;# bit0 = START
+    return ""
+}
+
+proc cmd_wait {} {
+    global REG_STATUS REG_PERF_CYC REG_PERF_PIX RUN_MAX_POLLS
+    for {set n 0} {$n < $RUN_MAX_POLLS} {incr n} {
+        set status [reg_read $REG_STATUS]
+        if {($status & 0x3) == 0x2} {
+            return "[expr {[reg_read $REG_PERF_CYC]}] [expr {[reg_read $REG_PERF_PIX]}]"
+        }
+    }
+    error "timeout esperando DONE"
+}
+
+proc cmd_run {} {
+    cmd_start
+    return [cmd_wait]
+}
+
+proc cmd_dump {path npix} {
+    global REG_OUT_ADDR REG_OUT_WIN
+    set nwords [expr {($npix + 3) / 4}]
+    reg_write $REG_OUT_ADDR 0
+
+    set words [burst_read $REG_OUT_WIN $nwords]
+    set blob [string range [binary format i* $words] 0 [expr {$npix - 1}]]
+
+    set fd [open $path "wb"]
+    fconfigure $fd -translation binary -encoding binary
+    puts -nonewline $fd $blob
+    close $fd
+    return $npix
+}
+
+# 4) Bucle de comandos
+fconfigure stdin -buffering line
+reply "ready"
+
+while {[gets stdin line] >= 0} {
+    set line [string trim $line]
+    if {$line eq ""} {
+        continue
+    }
+    set cmd  [lindex $line 0]
+    set argl [lrange $line 1 end]
+
+    if {$cmd eq "quit"} {
+        reply "ok bye"
+        break
+    }
+
+    if {[catch {
+        switch -- $cmd {
+            ping    { set r "pong" }
+            wr      { reg_write [lindex $argl 0] [lindex $argl 1]; set r "" }
+            rd      { set r [expr {[reg_read [lindex $argl 0]]}] }
+            cfg     { set r [cmd_cfg {*}$argl] }
+            load    { set r [cmd_load [lindex $argl 0]] }
+            run     { set r [cmd_run] }
+            bank    { set r [cmd_bank [lindex $argl 0] [lindex $argl 1]] }
+            start   { set r [cmd_start] }
+            wait    { set r [cmd_wait] }
+            dump    { set r [cmd_dump [lindex $argl 0] [lindex $argl 1]] }
+            default { error "comando desconocido: $cmd" }
+        }
+    } err]} {
+        reply "err [string map {"\n" " "} $err]"
+    } elseif {$r eq ""} {
+        reply "ok"
+    } else {
+        reply "ok $r"
+    }
+}
+
+close_service master $mp
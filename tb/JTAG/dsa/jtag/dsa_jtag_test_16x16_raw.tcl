@@ -1,15 +1,19 @@
 # Test sencillo para dsa_top_seq con bilinear_core_scalar.
 # - Usa el bus Avalon expuesto por JTAG master.
+# - Con los 8 argumentos extra corre un tile de una imagen más grande
+#   (registros SRC_W..TILE_OH de dsa_top_seq); sin ellos, imagen completa.
+# - Deja PERF_CYC y PERF_PIX en <salida.raw>.perf para que el driver los sume.
 
 # 1) Parseo de argumentos
 set raw_args $argv
 puts "Args recibidos: $raw_args"
 
-if {[llength $raw_args] != 6} {
+if {[llength $raw_args] != 6 && [llength $raw_args] != 14} {
     puts "Uso:"
     puts "  system-console --project-dir <ruta_qpf> \\"
     puts "    --script=dsa_jtag_test_16x16_raw.tcl -- \\"
-    puts "    <img_w> <img_h> <scale_q8_8> <entrada.raw> <salida.raw>"
+    puts "    <img_w> <img_h> <scale_q8_8> <entrada.raw> <salida.raw> \\"
+    puts "    \[<src_w> <src_h> <org_x> <org_y> <off_x> <off_y> <tile_ow> <tile_oh>\]"
     return
 }
 
@@ -20,12 +24,28 @@ set img_w       [lindex $raw_args 1]
 set img_h       [lindex $raw_args 2]
 set scale_q8_8  [lindex $raw_args 3]
 
+# Tiling: src_w = 0 deja el core en modo imagen completa
+set src_w   0
+set src_h   0
+set org_x   0
+set org_y   0
+set off_x   0
+set off_y   0
+set tile_ow 0
+set tile_oh 0
+if {[llength $raw_args] == 14} {
+    lassign [lrange $raw_args 6 13] src_w src_h org_x org_y off_x off_y tile_ow tile_oh
+}
+
 puts "Parametros:"
 puts "  img_w      = $img_w"
 puts "  img_h      = $img_h"
 puts "  scale_q8_8 = [format {0x%08X} $scale_q8_8]"
 puts "  input RAW  = $in_raw"
 puts "  output RAW = $out_raw"
+if {$src_w != 0} {
+    puts "  tile       = salida ($org_x,$org_y) ${tile_ow}x${tile_oh} de imagen ${src_w}x${src_h}, entrada desde ($off_x,$off_y)"
+}
 puts "------------------------------------------------"
 
 # 2) Cargar paquete master y obtener master JTAG
@@ -65,11 +85,24 @@ set REG_MODE      0x0005
 set REG_PERF_CYC  0x0006
 set REG_PERF_PIX  0x0007
 
+set REG_SRC_W     0x0008
+set REG_SRC_H     0x0009
+set REG_ORG_X     0x000A
+set REG_ORG_Y     0x000B
+set REG_OFF_X     0x000C
+set REG_OFF_Y     0x000D
+set REG_TILE_OW   0x000E
+set REG_TILE_OH   0x000F
+
 set REG_IN_ADDR   0x0020
 set REG_IN_DATA   0x0021
 set REG_OUT_ADDR  0x0030
 set REG_OUT_DATA  0x0031
 
+# Ventanas de ráfaga (auto-incremento sobre in_ptr/out_ptr)
+set REG_IN_WIN    0x1000
+set REG_OUT_WIN   0x1400
+
 # 5) Leer archivo RAW de entrada
 if {![file exists $in_raw]} {
     puts "ERROR: archivo de entrada '$in_raw' no existe."
@@ -91,12 +124,13 @@ if {$in_size != $expected_size} {
     puts "ADVERTENCIA: el tamaño del RAW no coincide con img_w*img_h."
 }
 
-# Convertir a lista de bytes (0..255)
-binary scan $raw_data cu* in_bytes
-set num_pixels [llength $in_bytes]
+# Palabras de 32 bits little-endian (píxel 0 en el LSB), rellenando a 4
+set num_pixels [string length $raw_data]
 puts "Total píxeles: $num_pixels"
 
-set total_words [expr {($num_pixels + 3) / 4}]
+set pad [expr {(4 - $num_pixels % 4) % 4}]
+binary scan "$raw_data[string repeat "\x00" $pad]" iu* in_words
+set total_words [llength $in_words]
 puts "Total palabras (32 bits): $total_words"
 
 # 6) Configurar registros de imagen y escala
@@ -105,38 +139,19 @@ reg_write $mp $BASE_ADDR $REG_IMG_H   $img_h
 reg_write $mp $BASE_ADDR $REG_SCALE   $scale_q8_8
 reg_write $mp $BASE_ADDR $REG_MODE    0x00000000  
 
-# 7) Escribir BRAM de entrada (in_mem) vía IN_ADDR / IN_DATA
+reg_write $mp $BASE_ADDR $REG_SRC_W   $src_w
+reg_write $mp $BASE_ADDR $REG_SRC_H   $src_h
+reg_write $mp $BASE_ADDR $REG_ORG_X   $org_x
+reg_write $mp $BASE_ADDR $REG_ORG_Y   $org_y
+reg_write $mp $BASE_ADDR $REG_OFF_X   $off_x
+reg_write $mp $BASE_ADDR $REG_OFF_Y   $off_y
+reg_write $mp $BASE_ADDR $REG_TILE_OW $tile_ow
+reg_write $mp $BASE_ADDR $REG_TILE_OH $tile_oh
+
+# 7) Escribir BRAM de entrada (in_mem) en una ráfaga por IN_WIN
 puts "Escribiendo BRAM de entrada con $total_words palabras..."
 reg_write $mp $BASE_ADDR $REG_IN_ADDR 0
-
-set idx 0
-for {set w 0} {$w < $total_words} {incr w} {
-    set b0 0
-    set b1 0
-    set b2 0
-    set b3 0
-
-    if {$idx < $num_pixels} {
-        set b0 [lindex $in_bytes $idx]
-        incr idx
-    }
-    if {$idx < $num_pixels} {
-        set b1 [lindex $in_bytes $idx]
-        incr idx
-    }
-    if {$idx < $num_pixels} {
-        set b2 [lindex $in_bytes $idx]
-        incr idx
-    }
-    if {$idx < $num_pixels} {
-        set b3 [lindex $in_bytes $idx]
-        incr idx
-    }
-
-    # Construimos palabra 0xAABBCCDD como: b3 b2 b1 b0
-    set word [expr {($b3 << 24) | ($b2 << 16) | ($b1 << 8) | $b0}]
-    reg_write $mp $BASE_ADDR $REG_IN_DATA $word
-}
+master_write_32 $mp [expr {$BASE_ADDR + 4 * $REG_IN_WIN}] $in_words
 
 puts "Escritura de BRAM de entrada completa."
 
@@ -175,37 +190,28 @@ if {$out_pixels == 0} {
 }
 puts "Lectura de salida: $out_pixels píxeles, $out_words palabras."
 
-# 9) Leer BRAM de salida (out_mem) y escribir RAW de salida
+# 9) Leer BRAM de salida (out_mem) en una ráfaga por OUT_WIN y escribir RAW
 reg_write $mp $BASE_ADDR $REG_OUT_ADDR 0
 
-set out_bytes {}
-for {set w 0} {$w < $out_words} {incr w} {
-    set word [reg_read $mp $BASE_ADDR $REG_OUT_DATA]
-
-    # Extraer 4 bytes little-endian
-    set b0 [expr {$word        & 0xFF}]
-    set b1 [expr {($word >> 8) & 0xFF}]
-    set b2 [expr {($word >>16) & 0xFF}]
-    set b3 [expr {($word >>24) & 0xFF}]
-
-    lappend out_bytes $b0 $b1 $b2 $b3
+set out_words_list {}
+if {$out_words > 0} {
+    set out_words_list [master_read_32 $mp [expr {$BASE_ADDR + 4 * $REG_OUT_WIN}] $out_words]
 }
 
-# Recortar a EXACTAMENTE out_pixels
-set out_bytes [lrange $out_bytes 0 [expr {$out_pixels - 1}]]
+# Palabras little-endian a bytes, recortado a EXACTAMENTE out_pixels
+set out_blob [string range [binary format i* $out_words_list] 0 [expr {$out_pixels - 1}]]
 
-# Volcar a archivo binario
 set out_fd [open $out_raw "wb"]
 fconfigure $out_fd -translation binary -encoding binary
-
-set out_blob ""
-foreach b $out_bytes {
-    append out_blob [binary format c [expr {$b & 0xFF}]]
-}
 puts -nonewline $out_fd $out_blob
 close $out_fd
 
 puts "Archivo de salida escrito: $out_raw"
+
+# Contadores para el driver (decimal: "perf_cyc perf_pix")
+set perf_fd [open "$out_raw.perf" "w"]
+puts $perf_fd "[expr {$perf_cyc}] [expr {$perf_pix}]"
+close $perf_fd
 puts "Hecho."
 
 # 10) Liberar master
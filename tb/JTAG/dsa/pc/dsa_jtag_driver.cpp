@@ -1,15 +1,39 @@
 // Wrapper en C++ para:
 //  - ejecutar el downscale de referencia en CPU (modelo bilineal igual al core),
 //  - llamar a system-console + Tcl para ejecutar el core en FPGA,
-//  - comparar la salida HW vs referencia (píxel a píxel).
+//  - comparar la salida HW vs referencia (model/image_compare.h: mismatches,
+//    error máximo y medio, PSNR y la caja de las diferencias).
+//
+// El core tiene BRAM de 32x32: las imágenes más grandes se parten en tiles
+// (model/downscale_tiles.h), cada uno con su ventana de entrada + halo y el
+// origen de coordenadas en los registros de tiling de dsa_top_seq. Las
+// salidas se cosen en out_hw_raw y se comparan contra la referencia de la
+// imagen entera. PERF_CYC/PERF_PIX se suman sobre todos los tiles.
+//
+// system-console se abre UNA vez (sc_session.h + dsa_jtag_server.tcl) y
+// todos los tiles de todas las imágenes pasan por esa sesión.
+//
+// Cada etapa (carga del RAW, referencia, subida, corrida en HW, lectura y
+// comparación) se mide con steady_clock y al final se escribe meta.json con
+// el esquema de pc/summarize_perf.py más los tiempos por etapa.
+//
+// Con --box todas las imágenes corren en modo box (REG_MODE[1],
+// box_core_scalar) y la referencia es model/downscale_box.h.
+//
+// Con --cache dir (o DSA_CACHE_DIR) la referencia se busca primero en la
+// cache por contenido de model/result_cache.h (hash de la entrada, W, H,
+// scale_q8_8 y bilineal/box) y solo se calcula si no está.
 //
 // Uso:
-//   ./dsa_jtag_driver <img_w> <img_h> <scale_hex> <in_raw> <out_hw_raw>
+//   ./dsa_jtag_driver [--pipeline] [--box] [--meta meta.json] [--cache dir]
+//                     <img_w> <img_h> <scale_hex> <in_raw> <out_hw_raw> [...]
+// (se pueden encadenar varias imágenes de 5 argumentos cada una)
 //
 // Ejemplo:
 //   ./dsa_jtag_driver 32 32 0x00000080 ../pc/entrada_32x32.raw ../pc/salida_32x32_05.raw
 //
-// NOTA: ajustar SC_BIN, PROJ_DIR y TCL_SCRIPT a tu entorno real.
+// NOTA: ajustar SC_BIN, PROJ_DIR y TCL_SERVER a tu entorno real (o
+// DSA_SC_BIN en el entorno).
 
 #include <iostream>
 #include <fstream>
@@ -21,13 +45,22 @@
 #include <cstdlib>
 #include <stdexcept>
 #include <cmath>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+
+#include "../../../../model/downscale_kernels.h"
+#include "../../../../model/downscale_box.h"
+#include "../../../../model/downscale_tiles.h"
+#include "../../../../model/image_compare.h"
+#include "../../../../model/image_io.h"
+#include "../../../../model/result_cache.h"
+#include "sc_session.h"
 
 // -----------------------------------------------------------------------------
 // CONFIGURACIÓN: ajusta estas rutas a tu entorno
 // -----------------------------------------------------------------------------
-// helpers por si el compilador no trae std::round en el namespace
-static inline double my_floor(double x) { return std::floor(x); }
-static inline double my_round(double x) { return std::floor(x + 0.5); }
 // Ruta al system-console (ya probada por Randall en su máquina)
 static const std::string SC_BIN =
     "/home/hack/intelFPGA_lite/20.1/quartus/sopc_builder/bin/system-console";
@@ -36,68 +69,62 @@ static const std::string SC_BIN =
 static const std::string PROJ_DIR =
     "../dsa/quartus";
 
-// Ruta al script Tcl (desde donde se ejecuta este binario)
-static const std::string TCL_SCRIPT =
-    "../jtag/dsa_jtag_test_16x16_raw.tcl";
+// Ruta al script Tcl servidor (desde donde se ejecuta este binario)
+static const std::string TCL_SERVER =
+    "../jtag/dsa_jtag_server.tcl";
+
+// Tiempos máximos: arranque de system-console (claim del master incluido) y
+// cada comando del protocolo
+static const int SC_START_TIMEOUT_MS = 120000;
+static const int SC_CMD_TIMEOUT_MS   = 30000;
 
-// Límite actual del core en HW
+// Límite actual del core en HW (tamaño máximo de cada tile)
 static const int HW_IMG_MAX_W = 32;
 static const int HW_IMG_MAX_H = 32;
 
+// Escala mínima con --box: la huella de una salida mide 65536/scale >> 8
+// entradas por eje y tiene que entrar entera en un tile (0x08 -> 32).
+static const uint32_t HW_BOX_MIN_SCALE = 256 / HW_IMG_MAX_W;
+
 // -----------------------------------------------------------------------------
 // Utilidades simples
 // -----------------------------------------------------------------------------
 
-static uint8_t clamp_u8(int x)
+// Lee un .raw de w*h bytes (8 bits por píxel, gris). Queda mapeado en
+// memoria; si falta algo se copia a un buffer y se rellena con 0.
+mapped_image load_raw(const std::string &path, int w, int h)
 {
-    if (x < 0)
-        return 0;
-    if (x > 255)
-        return 255;
-    return static_cast<uint8_t>(x);
-}
-
-// Lee un .raw de w*h bytes (8 bits por píxel, gris)
-std::vector<uint8_t> load_raw(const std::string &path, int w, int h)
-{
-    int total = w * h;
-    std::vector<uint8_t> img(total, 0);
-
-    std::ifstream f(path, std::ios::binary);
-    if (!f)
+    mapped_image img;
+    try
+    {
+        img = map_image_u8(path, w, h, /*pad_short=*/true);
+    }
+    catch (const std::exception &e)
     {
         std::cerr << "ERROR: no se pudo abrir " << path << " para lectura.\n";
+        img.file.pad_to((size_t)w * h);
+        img.pix = img.file.data();
+        img.w = w;
+        img.h = h;
         return img;
     }
 
-    f.read(reinterpret_cast<char *>(img.data()), total);
-    std::streamsize got = f.gcount();
-    if (got < total)
+    if (img.got < (size_t)w * h)
     {
         std::cerr << "WARNING: RAW " << path
-                  << " tiene solo " << got << " bytes, se rellenan con 0.\n";
+                  << " tiene solo " << img.got << " bytes, se rellenan con 0.\n";
     }
     return img;
 }
 
-// Escribe un .raw de w*h bytes
-bool save_raw(const std::string &path, const std::vector<uint8_t> &img)
-{
-    std::ofstream f(path, std::ios::binary);
-    if (!f)
-    {
-        std::cerr << "ERROR: no se pudo abrir " << path << " para escritura.\n";
-        return false;
-    }
-    f.write(reinterpret_cast<const char *>(img.data()), img.size());
-    return true;
-}
-
 // -----------------------------------------------------------------------------
 // Dimensiones de salida iguales al HW (modo 1)
 // -----------------------------------------------------------------------------
 
-// Calcula out_w y out_h igual que en dsa_top_seq (modo 1)
+// Calcula out_w y out_h igual que en dsa_top_seq (modo 1):
+//   max(1, (img * scale_q8_8) >> 8), sin pasar de img.
+// Ya no se recorta a HW_IMG_MAX_W/H: si la salida no entra en el core se
+// corre por tiles y estas son las dimensiones de la imagen cosida.
 static void compute_out_dims_hw_like(
     int img_w, int img_h, uint32_t scale_q8_8,
     int &out_w, int &out_h)
@@ -105,34 +132,7 @@ static void compute_out_dims_hw_like(
     if (img_w <= 0 || img_h <= 0)
         throw std::runtime_error("Dimensiones de imagen inválidas");
 
-    // ow_full = img_w * scale_q8_8;  oh_full = img_h * scale_q8_8;
-    uint32_t ow_full = static_cast<uint32_t>(img_w) * scale_q8_8;
-    uint32_t oh_full = static_cast<uint32_t>(img_h) * scale_q8_8;
-
-    // >> 8 (equivalente a tomar bits [23:8] en el HDL)
-    int ow = static_cast<int>(ow_full >> 8);
-    int oh = static_cast<int>(oh_full >> 8);
-
-    // Evitar cero
-    if (ow <= 0)
-        ow = 1;
-    if (oh <= 0)
-        oh = 1;
-
-    // Clamp contra límites del core
-    if (ow > HW_IMG_MAX_W)
-        ow = HW_IMG_MAX_W;
-    if (oh > HW_IMG_MAX_H)
-        oh = HW_IMG_MAX_H;
-
-    // Clamp contra dimensiones reales de la imagen
-    if (ow > img_w)
-        ow = img_w;
-    if (oh > img_h)
-        oh = img_h;
-
-    out_w = ow;
-    out_h = oh;
+    hw_out_dims(img_w, img_h, scale_q8_8, 0, 0, out_w, out_h);
 }
 
 // -----------------------------------------------------------------------------
@@ -150,357 +150,832 @@ std::vector<uint8_t> downscale_ref_bilinear(
         throw std::runtime_error("Dimensiones inválidas");
 
     const int total_pix = img_w * img_h;
+    const uint8_t *pix = src.data();
+    std::vector<uint8_t> padded;
     if (static_cast<int>(src.size()) < total_pix)
     {
         std::cerr << "WARNING: src.size() < img_w*img_h, se asumirá 0 para faltantes.\n";
+        padded = src;
+        padded.resize(total_pix, 0);
+        pix = padded.data();
     }
 
     // Dimensiones de salida iguales que en HW
     compute_out_dims_hw_like(img_w, img_h, scale_q8_8, out_w, out_h);
 
-    // escala en double (por ejemplo 0.5 si scale_q8_8 = 0x80)
+    // Coordenadas con la semantica del golden (escala en double, por ejemplo
+    // 0.5 si scale_q8_8 = 0x80) sobre las dimensiones del HW
     double scale = static_cast<double>(scale_q8_8) / 256.0;
+    coord_tables tab = make_coord_tables<golden_rounding>(img_w, img_h, out_w, out_h, scale);
 
     std::vector<uint8_t> dst(out_w * out_h, 0);
-
-    auto at = [&](int x, int y) -> uint8_t
-    {
-        if (x < 0)
-            x = 0;
-        if (x >= img_w)
-            x = img_w - 1;
-        if (y < 0)
-            y = 0;
-        if (y >= img_h)
-            y = img_h - 1;
-        int idx = y * img_w + x;
-        if (idx < 0 || idx >= total_pix)
-            return 0;
-        return src[idx];
-    };
-
-    for (int yo = 0; yo < out_h; ++yo)
-    {
-        double ys = (static_cast<double>(yo) + 0.5) / scale - 0.5;
-        int y0 = static_cast<int>(my_floor(ys));
-        if (y0 < 0)
-            y0 = 0;
-        if (y0 > img_h - 1)
-            y0 = img_h - 1;
-        int y1 = (y0 + 1 < img_h) ? y0 + 1 : y0;
-        double ty = ys - y0;
-        int ty_q = std::min(255, static_cast<int>(my_round(ty * 256.0))); // Q8.8
-
-        for (int xo = 0; xo < out_w; ++xo)
-        {
-            double xs = (static_cast<double>(xo) + 0.5) / scale - 0.5;
-            int x0 = static_cast<int>(my_floor(xs));
-            if (x0 < 0)
-                x0 = 0;
-            if (x0 > img_w - 1)
-                x0 = img_w - 1;
-            int x1 = (x0 + 1 < img_w) ? x0 + 1 : x0;
-            double tx = xs - x0;
-            int tx_q = std::min(255, static_cast<int>(my_round(tx * 256.0))); // Q8.8
-
-            int I00 = at(x0, y0);
-            int I10 = at(x1, y0);
-            int I01 = at(x0, y1);
-            int I11 = at(x1, y1);
-
-            int wx0 = 256 - tx_q;
-            int wy0 = 256 - ty_q;
-
-            long long acc = 0;
-            acc += 1LL * I00 * wx0 * wy0;
-            acc += 1LL * I10 * tx_q * wy0;
-            acc += 1LL * I01 * wx0 * ty_q;
-            acc += 1LL * I11 * tx_q * ty_q;
-
-            acc = (acc + (1LL << 15)) >> 16; // redondeo Q16.16 -> Q8.8
-            dst[yo * out_w + xo] = clamp_u8(static_cast<int>(acc));
-        }
-    }
-
+    downscale_u8(pix, img_w, tab, dst.data());
     return dst;
 }
 
 // -----------------------------------------------------------------------------
-// Llamada a system-console + Tcl
+// Sesión con system-console (dsa_jtag_server.tcl)
 // -----------------------------------------------------------------------------
 
-// Ejecuta el Tcl para correr el DSA en HW.
-// La idea es que el script Tcl reciba:
-//   PROJ_DIR img_w img_h scale_hex in_raw out_raw
-static bool run_system_console(
-    int img_w, int img_h,
-    const std::string &scale_hex,
-    const std::string &in_raw,
-    const std::string &out_raw)
+// Comando para lanzar el servidor; DSA_SC_BIN reemplaza a SC_BIN (p.ej. otra
+// instalación de Quartus o un proceso que hable el mismo protocolo).
+static std::vector<std::string> system_console_argv()
 {
+    const char *env_bin = std::getenv("DSA_SC_BIN");
+    std::string bin = (env_bin && *env_bin) ? env_bin : SC_BIN;
+    return {bin, "-cli", "--script=" + TCL_SERVER, PROJ_DIR};
+}
+
+static bool start_system_console(sc_session &sc)
+{
+    std::vector<std::string> argv = system_console_argv();
     std::ostringstream cmd;
-    cmd << SC_BIN
-        << " -cli --script=" << TCL_SCRIPT
-        << " " << PROJ_DIR
-        << " " << img_w
-        << " " << img_h
-        << " " << scale_hex
-        << " " << in_raw
-        << " " << out_raw;
+    for (size_t i = 0; i < argv.size(); ++i)
+        cmd << (i ? " " : "") << argv[i];
 
     std::cout << "------------------------------------------------\n";
-    std::cout << "Ejecutando system-console con:\n  " << cmd.str() << "\n";
+    std::cout << "Abriendo sesión de system-console:\n  " << cmd.str() << "\n";
     std::cout << "------------------------------------------------\n";
 
-    int ret = std::system(cmd.str().c_str());
-    if (ret != 0)
+    if (!sc.start(argv, SC_START_TIMEOUT_MS))
     {
-        std::cerr << "ERROR: system-console devolvió código " << ret << "\n";
+        std::cerr << "ERROR: no se pudo abrir system-console ("
+                  << sc.last_error() << ")\n";
         return false;
     }
     return true;
 }
 
+// Manda un comando y, si falla, muestra en qué paso.
+static bool sc_step(sc_session &sc, const std::string &line, std::string &reply)
+{
+    if (sc.cmd(line, reply, SC_CMD_TIMEOUT_MS))
+        return true;
+    std::cerr << "ERROR: '" << line.substr(0, line.find(' '))
+              << "' en system-console: " << reply << "\n";
+    return false;
+}
+
+// REG_MODE con el core box
+static const int HW_MODE_BOX = 0x2;
+
+// cfg de un tile: dimensiones de la ventana, escala, registros de tiling y
+// modo
+static std::string tile_cfg_line(const hw_tile &t, int src_w, int src_h, uint32_t scale_q8_8,
+                                 bool box)
+{
+    std::ostringstream cfg;
+    cfg << "cfg " << t.iw << " " << t.ih << " " << scale_q8_8
+        << " " << src_w << " " << src_h
+        << " " << t.ox << " " << t.oy
+        << " " << t.ix << " " << t.iy
+        << " " << t.ow << " " << t.oh
+        << " " << (box ? HW_MODE_BOX : 0);
+    return cfg.str();
+}
+
+// Nombres de los RAW temporales de cada banco ping-pong
+static std::string tile_in_path(int bank) { return "tile_in_" + std::to_string(bank) + ".raw"; }
+static std::string tile_out_path(int bank) { return "tile_out_" + std::to_string(bank) + ".raw"; }
+
 // -----------------------------------------------------------------------------
-// Comparación y main()
+// Tiempos por etapa
 // -----------------------------------------------------------------------------
 
-int main(int argc, char **argv)
+// ms acumulados por etapa de una imagen (sumados sobre sus tiles)
+struct stage_times
 {
-    if (argc != 6)
+    double load_raw = 0;   // leer/mapear el RAW de entrada
+    double ref = 0;        // referencia de la imagen entera + plan de tiles
+    double upload = 0;     // RAW del tile + cfg/bank + load
+    double hw_run = 0;     // run (o start + wait en pipeline)
+    double readback = 0;   // dump + cosido + escritura de out_hw
+    double compare = 0;    // comparación contra la referencia
+
+    double sum() const { return load_raw + ref + upload + hw_run + readback + compare; }
+
+    void add(const stage_times &o)
     {
-        std::cerr << "Uso:\n  " << argv[0]
-                  << " <img_w> <img_h> <scale_hex> <in_raw> <out_hw_raw>\n\n";
-        return 1;
+        load_raw += o.load_raw;
+        ref += o.ref;
+        upload += o.upload;
+        hw_run += o.hw_run;
+        readback += o.readback;
+        compare += o.compare;
     }
+};
 
-    int img_w = std::stoi(argv[1]);
-    int img_h = std::stoi(argv[2]);
-    std::string scale_hex = argv[3];
-    std::string in_raw = argv[4];
-    std::string out_hw = argv[5];
+// Suma a acc los ms que pasan entre la construcción y la destrucción
+class stage_clock
+{
+public:
+    explicit stage_clock(double &acc_ms) : acc_(acc_ms), t0_(clk::now()) {}
+    ~stage_clock() { acc_ += std::chrono::duration<double, std::milli>(clk::now() - t0_).count(); }
+
+    stage_clock(const stage_clock &) = delete;
+    stage_clock &operator=(const stage_clock &) = delete;
 
+private:
+    using clk = std::chrono::steady_clock;
+    double &acc_;
+    clk::time_point t0_;
+};
+
+// -----------------------------------------------------------------------------
+// Una imagen del lote: referencia, tiles y comparación
+// -----------------------------------------------------------------------------
+
+struct image_job
+{
+    // Argumentos
+    int img_w = 0, img_h = 0;
+    std::string scale_hex, in_raw, out_hw;
+    uint32_t scale_q8_8 = 0;
+    bool box = false;
+    result_cache *cache = nullptr;   // compartida por todas las imágenes
+
+    // Lo arma prepare_image: entrada, referencia de la imagen entera y tiles
+    mapped_image src;
+    int out_w = 0, out_h = 0;
+    std::vector<hw_tile> tiles;
+    mapped_output ref_file;
+    std::vector<uint8_t> ref_buf;
+    const uint8_t *ref = nullptr;
+    bool fixed = false;
+    bool ref_cached = false;   // la referencia salió de la cache
+    std::string error;   // no vacío si no se pudo preparar
+
+    // Salida de HW cosida y perf sumado sobre los tiles
+    std::vector<uint8_t> hw;
+    uint64_t perf_cyc = 0, perf_pix = 0;
+    size_t tiles_done = 0;
+    bool hw_ok = true;
+
+    // Lo que va a meta.json
+    stage_times times;
+    int mismatches = -1;   // -1 = no se llegó a comparar
+    int max_err = 0;
+    double mean_err = 0, psnr = INFINITY;
+    bool ok = false;
+};
+
+static void print_image_args(const image_job &j)
+{
     std::cout << "Args brutos recibidos: "
-              << img_w << " " << img_h << " " << scale_hex
-              << " " << in_raw << " " << out_hw << "\n";
+              << j.img_w << " " << j.img_h << " " << j.scale_hex
+              << " " << j.in_raw << " " << j.out_hw << "\n";
 
     std::cout << "Parametros:\n";
-    std::cout << "  img_w      = " << img_w << "\n";
-    std::cout << "  img_h      = " << img_h << "\n";
+    std::cout << "  img_w      = " << j.img_w << "\n";
+    std::cout << "  img_h      = " << j.img_h << "\n";
+    std::cout << "  scale_q8_8 = 0x"
+              << std::hex << std::setw(8) << std::setfill('0')
+              << j.scale_q8_8 << std::dec << std::setfill(' ') << "\n";
+    std::cout << "  input RAW  = " << j.in_raw << "\n";
+    std::cout << "  output RAW = " << j.out_hw << "\n";
+}
 
-    uint32_t scale_q8_8 = 0;
+// Carga la entrada, calcula la referencia de la imagen entera y parte en
+// tiles. No usa la sesión JTAG, así que en modo pipeline corre en otro hilo.
+// ref_path: la referencia se escribe directo sobre ese RAW mapeado; vacío =
+// en memoria (en pipeline varias imágenes se preparan a la vez).
+static void prepare_image(image_job &j, const std::string &ref_path)
+{
     try
     {
-        scale_q8_8 = static_cast<uint32_t>(
-            std::stoul(scale_hex, nullptr, 16));
+        try
+        {
+            j.scale_q8_8 = static_cast<uint32_t>(std::stoul(j.scale_hex, nullptr, 16));
+        }
+        catch (const std::exception &e)
+        {
+            throw std::runtime_error("no se pudo parsear scale_hex=" + j.scale_hex +
+                                     " (" + e.what() + ")");
+        }
+        if (j.box && j.scale_q8_8 < HW_BOX_MIN_SCALE)
+        {
+            std::ostringstream m;
+            m << "--box necesita scale_q8_8 >= 0x" << std::hex << std::setfill('0')
+              << std::setw(2) << HW_BOX_MIN_SCALE << " (0x" << std::setw(2) << j.scale_q8_8
+              << ": la huella de una salida no entra en la BRAM de "
+              << std::dec << HW_IMG_MAX_W << "x" << HW_IMG_MAX_H << ")";
+            throw std::runtime_error(m.str());
+        }
+
+        // 1) Cargar imagen de entrada
+        {
+            stage_clock sc(j.times.load_raw);
+            j.src = load_raw(j.in_raw, j.img_w, j.img_h);
+        }
+        stage_clock sc_ref(j.times.ref);
+
+        // 2) Calcular out_w, out_h como en dsa_top_seq.sv, para la imagen entera
+        compute_out_dims_hw_like(j.img_w, j.img_h, j.scale_q8_8, j.out_w, j.out_h);
+
+        // 3) Modelo de referencia: réplica del pipeline Q8.8 del core_scalar.
+        //    Las coordenadas y pesos salen de tablas por columna/fila con la
+        //    politica hw_q88_rounding (inv_scale_q = 65536/scale, igual que el
+        //    core) y el kernel usa SSE4.1/AVX2 si la CPU lo soporta.
+        //    En modo box, el promedio de la huella de downscale_box.h.
+        coord_tables tab;
+        box_tables btab;
+        if (j.box)
+            btab = build_box_tables(j.img_w, j.img_h, j.out_w, j.out_h, j.scale_q8_8);
+        else
+            tab = build_coord_tables_hw(j.img_w, j.img_h, j.out_w, j.out_h, j.scale_q8_8);
+        j.fixed = tab.fixed != nullptr;
+        const int total = j.out_w * j.out_h;
+        uint8_t *ref_out = nullptr;
+        if (!ref_path.empty())
+        {
+            try
+            {
+                j.ref_file = map_output_u8(ref_path, j.out_w, j.out_h);
+                ref_out = j.ref_file.pix;
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "ERROR: no se pudo abrir " << ref_path << " para escritura.\n";
+            }
+        }
+        if (!ref_out)
+        {
+            j.ref_buf.assign(total, 0);
+            ref_out = j.ref_buf.data();
+        }
+        uint64_t key = 0;
+        if (j.cache)
+        {
+            key = result_cache_key(j.src.pix, j.img_w, j.img_h, 1,
+                                   cache_model_hw(j.scale_q8_8, j.box));
+            j.ref_cached = j.cache->get(key, ref_out, j.out_w, j.out_h, 1);
+        }
+        if (!j.ref_cached)
+        {
+            if (j.box)
+                downscale_box_u8(j.src.pix, j.img_w, btab, ref_out);
+            else
+                downscale_u8(j.src.pix, j.img_w, tab, ref_out);
+            if (j.cache)
+                j.cache->put(key, ref_out, j.out_w, j.out_h, 1);
+        }
+        j.ref = ref_out;
+
+        // 4) Tiles que entran en la BRAM del core (en box la ventana cubre
+        //    las huellas enteras)
+        j.tiles = plan_hw_tiles(j.img_w, j.img_h, j.out_w, j.out_h, j.scale_q8_8,
+                                HW_IMG_MAX_W, HW_IMG_MAX_H, j.box);
+        if (j.tiles.empty())
+            throw std::runtime_error("no se pudo partir la imagen en tiles de " +
+                                     std::to_string(HW_IMG_MAX_W) + "x" +
+                                     std::to_string(HW_IMG_MAX_H));
+        j.hw.assign(total, 0);
     }
     catch (const std::exception &e)
     {
-        std::cerr << "ERROR: no se pudo parsear scale_hex=" << scale_hex
-                  << " (" << e.what() << ")\n";
-        return 1;
+        j.error = e.what();
     }
+}
 
-    std::cout << "  scale_q8_8 = 0x"
-              << std::hex << std::setw(8) << std::setfill('0')
-              << scale_q8_8 << std::dec << "\n";
-    std::cout << "  input RAW  = " << in_raw << "\n";
-    std::cout << "  output RAW = " << out_hw << "\n";
+// Escribe la ventana de entrada del tile k en path.
+static bool write_tile_input(const image_job &j, size_t k, const std::string &path)
+{
+    const hw_tile &t = j.tiles[k];
+    std::vector<uint8_t> buf((size_t)t.iw * t.ih);
+    crop_tile_input(j.src.pix, j.img_w, t, buf.data());
+    try
+    {
+        write_image_u8(path, buf.data(), t.iw, t.ih);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
 
-    // 1) Cargar imagen de entrada
-    auto src = load_raw(in_raw, img_w, img_h);
-    const int total_pix = img_w * img_h;
-    if ((int)src.size() < total_pix)
+// Lee la salida del tile k desde path y la cose en j.hw.
+static void stitch_tile(image_job &j, size_t k, const std::string &path)
+{
+    const hw_tile &t = j.tiles[k];
+    auto tile_hw = load_raw(path, t.ow, t.oh);
+    stitch_tile_output(tile_hw.pix, t, j.hw.data(), j.out_w);
+    ++j.tiles_done;
+}
+
+static void add_tile_perf(image_job &j, const std::string &reply)
+{
+    uint64_t cyc = 0, pix = 0;
+    std::istringstream(reply) >> cyc >> pix;
+    j.perf_cyc += cyc;
+    j.perf_pix += pix;
+}
+
+// Escribe la salida cosida, muestra el perf sumado y compara contra la
+// referencia. 0 = OK.
+static int report_image(image_job &j)
+{
+    if (!j.error.empty())
     {
-        std::cerr << "WARNING: src.size() < img_w*img_h, se asumirá 0 para faltantes.\n";
+        std::cerr << "ERROR: " << j.error << "\n";
+        return 1;
+    }
+    if (j.box)
+        std::cout << "Ref: modo box\n";
+    else
+        std::cout << "Ref: kernel " << simd_level_name(default_simd_level())
+                  << (j.fixed ? " (escala fija)" : "") << "\n";
+    std::cout << "Ref: salida " << j.out_w << "x" << j.out_h
+              << (j.ref_file.pix ? " escrita en ref_out.raw" : " (en memoria)")
+              << (j.ref_cached ? " desde la cache" : "") << "\n";
+    std::cout << "HW: " << j.tiles.size() << " tile(s) de hasta "
+              << HW_IMG_MAX_W << "x" << HW_IMG_MAX_H << " con halo\n";
+    if (!j.hw_ok || j.tiles_done != j.tiles.size())
+    {
+        std::cerr << "ERROR: la corrida en HW no terminó (" << j.tiles_done
+                  << " de " << j.tiles.size() << " tiles).\n";
+        return 1;
+    }
+
+    // Salida cosida de HW, mismas dimensiones que la ref
+    try
+    {
+        stage_clock sc(j.times.readback);
+        write_image_u8(j.out_hw, j.hw.data(), j.out_w, j.out_h);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+    std::cout << "HW: salida " << j.out_w << "x" << j.out_h
+              << " cosida en " << j.out_hw << "\n";
+    std::cout << "HW: PERF_CYC total = " << j.perf_cyc
+              << ", PERF_PIX total = " << j.perf_pix;
+    if (j.perf_pix > 0)
+        std::cout << " (" << std::fixed << std::setprecision(2)
+                  << (double)j.perf_cyc / j.perf_pix << " ciclos/píxel)" << std::defaultfloat;
+    std::cout << "\n";
+
+    compare_stats st;
+    {
+        stage_clock sc_cmp(j.times.compare);
+        st = compare_u8(j.ref, j.out_w, j.out_h, j.hw.data(), j.out_w, j.out_h);
     }
 
-    // 2) Calcular out_w, out_h e inv_scale_q EXACTAMENTE como en dsa_top_seq.sv
-    int out_w = 0;
-    int out_h = 0;
+    for (const diff_pixel &p : st.first)
+    {
+        std::cout << "Mismatch en pixel " << (p.y * j.out_w + p.x)
+                  << " (x=" << p.x << ", y=" << p.y << "): "
+                  << "REF=0x" << std::hex << std::setw(2) << std::setfill('0') << (int)p.a
+                  << " HW=0x" << std::setw(2) << (int)p.b
+                  << std::dec << std::setfill(' ') << "\n";
+    }
 
+    j.mismatches = (int)st.mismatches;
+    j.max_err = st.max_err;
+    j.mean_err = st.mean_abs();
+    j.psnr = st.psnr();
+    j.ok = st.mismatches == 0;
+    if (j.ok)
     {
-        // ow_full = img_w * scale_q8_8;  oh_full = img_h * scale_q8_8;
-        uint32_t ow_full = static_cast<uint32_t>(img_w) * scale_q8_8;
-        uint32_t oh_full = static_cast<uint32_t>(img_h) * scale_q8_8;
+        std::cout << (j.box ? "[OK] HW coincide con referencia box (modelo Q8.8 del core).\n"
+                            : "[OK] HW coincide con referencia bilineal (modelo Q8.8 del core).\n");
+        return 0;
+    }
+    else
+    {
+        std::cout << "[FAIL] Se encontraron " << st.mismatches
+                  << " mismatches (se muestran hasta 20).\n";
+        std::cout << "  dif_max " << st.max_err << " LSB, error medio "
+                  << std::fixed << std::setprecision(4) << st.mean_abs() << " LSB, PSNR "
+                  << std::setprecision(2) << st.psnr() << " dB" << std::defaultfloat << "\n";
+        std::cout << "  caja x=" << st.bbox.x0 << ".." << st.bbox.x1
+                  << " y=" << st.bbox.y0 << ".." << st.bbox.y1
+                  << " (" << st.boxes.size() << (st.boxes_truncated ? "+" : "")
+                  << " tramo(s) de filas)\n";
+        return 1;
+    }
+}
 
-        // >> 8 (bits [23:8] en el HDL)
-        int ow = static_cast<int>(ow_full >> 8);
-        int oh = static_cast<int>(oh_full >> 8);
+static void print_stage_times(const image_job &j)
+{
+    const stage_times &t = j.times;
+    std::cout << std::fixed << std::setprecision(2)
+              << "Tiempos (ms): carga " << t.load_raw << ", ref " << t.ref
+              << ", subida " << t.upload << ", HW " << t.hw_run
+              << ", lectura " << t.readback << ", comparación " << t.compare
+              << std::defaultfloat << "\n";
+}
 
-        if (ow <= 0)
-            ow = 1;
-        if (oh <= 0)
-            oh = 1;
+// -----------------------------------------------------------------------------
+// meta.json
+// -----------------------------------------------------------------------------
 
-        if (ow > HW_IMG_MAX_W)
-            ow = HW_IMG_MAX_W;
-        if (oh > HW_IMG_MAX_H)
-            oh = HW_IMG_MAX_H;
+static std::string json_str(const std::string &s)
+{
+    std::string out = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
 
-        if (ow > img_w)
-            ow = img_w;
-        if (oh > img_h)
-            oh = img_h;
+static void write_stage_times(std::ostream &f, const stage_times &t)
+{
+    f << "{\"load_raw\": " << t.load_raw << ", \"ref\": " << t.ref
+      << ", \"upload\": " << t.upload << ", \"hw_run\": " << t.hw_run
+      << ", \"readback\": " << t.readback << ", \"compare\": " << t.compare << "}";
+}
 
-        out_w = ow;
-        out_h = oh;
+// Campos de scripts/make_meta.py (los que lee pc/summarize_perf.py) para la
+// primera imagen, con perf_cyc/perf_pix y los tiempos sumados sobre el lote,
+// y el detalle de cada imagen en "images". wall_ms no incluye el arranque de
+// system-console (sc_start_ms). En pipeline las etapas se solapan,
+// así que wall_ms queda por debajo de la suma de stages_ms.
+static bool write_meta(const std::string &path, const std::vector<image_job> &jobs,
+                       bool pipeline, double sc_start_ms, double wall_ms,
+                       const result_cache *cache)
+{
+    std::ofstream f(path);
+    if (!f)
+    {
+        std::cerr << "ERROR: no se pudo abrir " << path << " para escritura.\n";
+        return false;
+    }
+
+    // perf_cyc/perf_pix y stages_ms son del lote entero; las dimensiones y la
+    // escala de arriba solo si todas las imágenes las comparten (si no, null
+    // y cada una está en images)
+    const image_job &j0 = jobs.front();
+    uint64_t cyc = 0, pix = 0;
+    stage_times all;
+    int n_ok = 0;
+    bool same_geom = true;
+    for (const auto &j : jobs)
+    {
+        cyc += j.perf_cyc;
+        pix += j.perf_pix;
+        all.add(j.times);
+        n_ok += j.ok;
+        same_geom = same_geom && j.img_w == j0.img_w && j.img_h == j0.img_h &&
+                    j.scale_q8_8 == j0.scale_q8_8 && j.out_w == j0.out_w && j.out_h == j0.out_h;
     }
 
-    // inv_scale_q ≈ (1/scale) en Q8.8 => 65536 / scale_q8_8 (con división entera)
-    uint32_t inv_scale_q;
-    if (scale_q8_8 == 0)
-        inv_scale_q = 0x0100; // por defecto 1.0 si scale=0 (igual que HDL)
+    f << std::setprecision(6);
+    f << "{\n";
+    if (same_geom)
+        f << "  \"w_in\": " << j0.img_w << ", \"h_in\": " << j0.img_h << ",\n"
+          << "  \"scale\": " << j0.scale_q8_8 / 256.0 << ", \"scale_q8_8\": " << j0.scale_q8_8 << ",\n"
+          << "  \"w_out\": " << j0.out_w << ", \"h_out\": " << j0.out_h << ",\n";
     else
-        inv_scale_q = 65536u / scale_q8_8;
-
-    // 3) Modelo de referencia: réplica del pipeline Q8.8 del core_scalar
-    std::vector<uint8_t> ref_out(out_w * out_h, 0);
-    const int ONE_Q = 256;
-
-    auto at = [&](int x, int y) -> int
-    {
-        if (x < 0)
-            x = 0;
-        else if (x >= img_w)
-            x = img_w - 1;
-        if (y < 0)
-            y = 0;
-        else if (y >= img_h)
-            y = img_h - 1;
-        int idx = y * img_w + x;
-        if (idx < 0 || idx >= total_pix)
-            return 0;
-        return src[idx];
-    };
+        f << "  \"w_in\": null, \"h_in\": null,\n"
+          << "  \"scale\": null, \"scale_q8_8\": null,\n"
+          << "  \"w_out\": null, \"h_out\": null,\n";
+    f << "  \"mode\": \"" << (pipeline ? "pipeline" : "secuencial") << "\", \"units\": 1,\n"
+      << "  \"perf_cyc\": " << cyc << ", \"perf_pix\": " << pix << ",\n"
+      << "  \"frames\": " << jobs.size() << ", \"frames_ok\": " << n_ok << ",\n"
+      << "  \"sc_start_ms\": " << sc_start_ms << ", \"wall_ms\": " << wall_ms << ",\n";
+    if (cache)
+    {
+        const result_cache_stats cs = cache->stats();
+        f << "  \"ref_cache\": {\"hits\": " << cs.hits << ", \"misses\": " << cs.misses
+          << ", \"stores\": " << cs.stores << ", \"evicted\": " << cs.evicted << "},\n";
+    }
+    f << "  \"stages_ms\": ";
+    write_stage_times(f, all);
+    f << ",\n  \"images\": [\n";
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const image_job &j = jobs[i];
+        f << "    {\"in_raw\": " << json_str(j.in_raw) << ", \"out_hw\": " << json_str(j.out_hw)
+          << ", \"w_in\": " << j.img_w << ", \"h_in\": " << j.img_h
+          << ", \"scale_q8_8\": " << j.scale_q8_8
+          << ", \"filter\": \"" << (j.box ? "box" : "bilinear") << "\""
+          << ", \"w_out\": " << j.out_w << ", \"h_out\": " << j.out_h
+          << ", \"ref_cached\": " << (j.ref_cached ? "true" : "false")
+          << ", \"tiles\": " << j.tiles.size()
+          << ", \"perf_cyc\": " << j.perf_cyc << ", \"perf_pix\": " << j.perf_pix
+          << ", \"mismatches\": " << j.mismatches << ", \"max_err\": " << j.max_err
+          << ", \"mean_err\": " << j.mean_err << ", \"psnr_db\": ";
+        if (std::isfinite(j.psnr)) f << j.psnr;
+        else f << "null";   // iguales
+        f << ", \"ok\": " << (j.ok ? "true" : "false")
+          << ", \"stages_ms\": ";
+        write_stage_times(f, j.times);
+        f << "}" << (i + 1 < jobs.size() ? ",\n" : "\n");
+    }
+    f << "  ]\n}\n";
+    return (bool)f;
+}
 
-    for (int yo = 0; yo < out_h; ++yo)
+// -----------------------------------------------------------------------------
+// Modo secuencial: una imagen a la vez, cada tile cfg/load/run/dump
+// -----------------------------------------------------------------------------
+
+static int run_image(sc_session &sc, image_job &j)
+{
+    // scale_q8_8 se parsea en prepare_image: los args van después, como en
+    // el pipeline
+    prepare_image(j, "ref_out.raw");
+    print_image_args(j);
+    if (!j.error.empty())
+        return report_image(j);
+
+    std::string r;
+    j.hw_ok = sc_step(sc, "bank 0 0", r);
+    for (size_t k = 0; k < j.tiles.size() && j.hw_ok; ++k)
     {
-        for (int xo = 0; xo < out_w; ++xo)
+        const hw_tile &t = j.tiles[k];
+        std::cout << "Tile " << k + 1 << "/" << j.tiles.size()
+                  << ": salida (" << t.ox << "," << t.oy << ") " << t.ow << "x" << t.oh
+                  << ", entrada (" << t.ix << "," << t.iy << ") " << t.iw << "x" << t.ih << "\n";
+
+        {
+            stage_clock c(j.times.upload);
+            j.hw_ok = write_tile_input(j, k, tile_in_path(0)) &&
+                      sc_step(sc, tile_cfg_line(t, j.img_w, j.img_h, j.scale_q8_8, j.box), r) &&
+                      sc_step(sc, "load " + tile_in_path(0), r);
+        }
+        if (j.hw_ok)
         {
-            int yo_int = yo;
-            int xo_int = xo;
-
-            // (yo + 0.5) en Q8.8
-            int yo_q = (yo_int << 8) + (ONE_Q / 2);
-            // (yo+0.5)/scale ≈ (yo_q * inv_scale_q) >> 8
-            int temp_q_y = (int)(((int64_t)yo_q * (int64_t)inv_scale_q) >> 8);
-            int ys_q = temp_q_y - (ONE_Q / 2); // (yo+0.5)/scale - 0.5 en Q8.8
-
-            // (xo + 0.5) en Q8.8
-            int xo_q = (xo_int << 8) + (ONE_Q / 2);
-            int temp_q_x = (int)(((int64_t)xo_q * (int64_t)inv_scale_q) >> 8);
-            int xs_q = temp_q_x - (ONE_Q / 2);
-
-            // Parte entera (clamp a [0, in_h-1] / [0, in_w-1])
-            int y_int = ys_q >> 8; // shift aritmético, como >>> en SV (two's complement)
-            if (y_int < 0)
-                y_int = 0;
-            else if (y_int > img_h - 1)
-                y_int = img_h - 1;
-
-            int x_int = xs_q >> 8;
-            if (x_int < 0)
-                x_int = 0;
-            else if (x_int > img_w - 1)
-                x_int = img_w - 1;
-
-            int y0_i = y_int;
-            int y1_i = (y_int + 1 <= img_h - 1) ? (y_int + 1) : y_int;
-            int x0_i = x_int;
-            int x1_i = (x_int + 1 <= img_w - 1) ? (x_int + 1) : x_int;
-
-            // Parte fraccional (0..255) usando & 0xFF tal como en el core
-            int ty_q_i = ys_q & (ONE_Q - 1);
-            int tx_q_i = xs_q & (ONE_Q - 1);
-
-            // pesos
-            int wx0 = ONE_Q - tx_q_i;
-            int wy0 = ONE_Q - ty_q_i;
-
-            int I00 = at(x0_i, y0_i);
-            int I10 = at(x1_i, y0_i);
-            int I01 = at(x0_i, y1_i);
-            int I11 = at(x1_i, y1_i);
-
-            int w00 = wx0 * wy0;
-            int w10 = tx_q_i * wy0;
-            int w01 = wx0 * ty_q_i;
-            int w11 = tx_q_i * ty_q_i;
-
-            long long acc = 0;
-            acc += 1LL * I00 * w00;
-            acc += 1LL * I10 * w10;
-            acc += 1LL * I01 * w01;
-            acc += 1LL * I11 * w11;
-
-            // (acc + 2^15) >> 16, igual que en el core
-            acc = (acc + (1LL << 15)) >> 16;
-
-            int pix = static_cast<int>(acc);
-            if (pix < 0)
-                pix = 0;
-            else if (pix > 255)
-                pix = 255;
-
-            ref_out[yo * out_w + xo] = static_cast<uint8_t>(pix);
+            stage_clock c(j.times.hw_run);
+            j.hw_ok = sc_step(sc, "run", r);
         }
+        if (!j.hw_ok)
+            break;
+        add_tile_perf(j, r);
+
+        stage_clock c(j.times.readback);
+        j.hw_ok = sc_step(sc, "dump " + tile_out_path(0) + " " + std::to_string(t.ow * t.oh), r);
+        if (j.hw_ok)
+            stitch_tile(j, k, tile_out_path(0));
     }
+    int rc = report_image(j);
+    print_stage_times(j);
+    return rc;
+}
+
+// -----------------------------------------------------------------------------
+// Modo pipeline: tiles de todas las imágenes en cadena sobre los 2 bancos
+// -----------------------------------------------------------------------------
+//
+// El trabajo k (un tile de alguna imagen) corre en el banco k & 1. Mientras
+// el core procesa k, por el banco opuesto se lee y cose la salida de k-1 (y
+// se verifica su imagen si era el último tile) y se sube la entrada de k+1.
+// La referencia de las imágenes siguientes (hasta PREP_AHEAD) se calcula en
+// otros hilos. Con esto el tiempo por cuadro tiende a max(transferencia,
+// cómputo) en vez de la suma.
+// Los tiempos por etapa se miden comando a comando, así que hw_run es solo
+// lo que start + wait no alcanzaron a esconder detrás de las transferencias.
+
+static const size_t PREP_AHEAD = 2;
+
+static int run_pipeline(sc_session &sc, std::vector<image_job> &jobs)
+{
+    struct work { size_t img, tile; };
+    std::vector<std::future<void>> prep(jobs.size());
+    size_t prep_next = 0;
+    auto prep_upto = [&](size_t last) {
+        for (; prep_next < jobs.size() && prep_next <= last; ++prep_next)
+            prep[prep_next] = std::async(std::launch::async, prepare_image,
+                                         std::ref(jobs[prep_next]), std::string());
+    };
+    auto ready = [&](size_t i) {
+        prep_upto(i + PREP_AHEAD);
+        if (prep[i].valid())
+            prep[i].get();
+        return jobs[i].error.empty();
+    };
+
+    int n_ok = 0;
+    size_t reported = 0;
+    auto report_upto = [&](size_t last) {   // imágenes [reported, last] ya completas
+        for (; reported <= last && reported < jobs.size(); ++reported)
+        {
+            std::cout << "================ Imagen " << reported + 1 << "/" << jobs.size()
+                      << " ================\n";
+            print_image_args(jobs[reported]);
+            if (report_image(jobs[reported]) == 0)
+                ++n_ok;
+            print_stage_times(jobs[reported]);
+        }
+    };
 
-    // Guardar referencia para inspección
-    save_raw("ref_out.raw", ref_out);
-    std::cout << "Ref: salida " << out_w << "x" << out_h
-              << " escrita en ref_out.raw\n";
+    // Trabajos en orden, generados a medida que se necesitan: así solo se
+    // espera la referencia de la imagen que entra al pipeline (las siguientes
+    // ya se están preparando). Las que fallaron al prepararse no tienen tiles.
+    std::vector<work> w;
+    size_t next_img = 0;
+    auto have = [&](size_t k) {
+        while (w.size() <= k && next_img < jobs.size())
+        {
+            size_t i = next_img++;
+            if (!ready(i))
+                continue;
+            for (size_t t = 0; t < jobs[i].tiles.size(); ++t)
+                w.push_back({i, t});
+        }
+        return k < w.size();
+    };
 
-    // 4) Ejecutar el HW via system-console + Tcl (igual que antes)
-    if (!run_system_console(img_w, img_h, scale_hex, in_raw, out_hw))
+    std::string r;
+    bool ok = true;
+    auto upload = [&](size_t k, int bank) {
+        stage_clock c(jobs[w[k].img].times.upload);
+        return write_tile_input(jobs[w[k].img], w[k].tile, tile_in_path(bank)) &&
+               sc_step(sc, "load " + tile_in_path(bank), r);
+    };
+    auto readback = [&](size_t k, int bank) {
+        image_job &j = jobs[w[k].img];
+        const hw_tile &t = j.tiles[w[k].tile];
+        {
+            stage_clock c(j.times.readback);
+            if (!sc_step(sc, "dump " + tile_out_path(bank) + " " + std::to_string(t.ow * t.oh), r))
+                return false;
+            stitch_tile(j, w[k].tile, tile_out_path(bank));
+        }
+        if (j.tiles_done == j.tiles.size())
+            report_upto(w[k].img);
+        return true;
+    };
+
+    if (have(0))
+        ok = sc_step(sc, "bank 0 0", r) && upload(0, 0);
+
+    for (size_t k = 0; have(k) && ok; ++k)
     {
-        std::cerr << "ERROR: fallo al invocar system-console.\n";
-        return 1;
+        const int b = (int)(k & 1);
+        image_job &j = jobs[w[k].img];
+
+        // Arranca k en el banco b; el host queda apuntando al otro
+        {
+            stage_clock c(j.times.upload);
+            ok = sc_step(sc, tile_cfg_line(j.tiles[w[k].tile], j.img_w, j.img_h, j.scale_q8_8,
+                                       j.box), r) &&
+                 sc_step(sc, "bank " + std::to_string(b) + " " + std::to_string(b ^ 1), r);
+        }
+        if (ok)
+        {
+            stage_clock c(j.times.hw_run);
+            ok = sc_step(sc, "start", r);
+        }
+
+        // Mientras corre: salida de k-1 y entrada de k+1 por el banco 1-b
+        if (ok && k > 0)
+            ok = readback(k - 1, b ^ 1);
+        if (ok && have(k + 1))
+            ok = upload(k + 1, b ^ 1);
+
+        if (ok)
+        {
+            stage_clock c(j.times.hw_run);
+            ok = sc_step(sc, "wait", r);
+        }
+        if (ok)
+            add_tile_perf(j, r);
     }
 
-    // 5) Cargar salida de HW con las mismas dimensiones que la ref
-    auto hw_out = load_raw(out_hw, out_w, out_h);
-    std::cout << "HW: leídos " << hw_out.size()
-              << " bytes desde " << out_hw << "\n";
+    // Último trabajo: su salida quedó en su propio banco
+    if (ok && !w.empty())
+    {
+        const int b = (int)((w.size() - 1) & 1);
+        ok = sc_step(sc, "bank " + std::to_string(b) + " " + std::to_string(b), r) &&
+             readback(w.size() - 1, b);
+    }
 
-    if (hw_out.size() != ref_out.size())
+    for (auto &f : prep)   // si se cortó antes, que no quede nadie escribiendo
+        if (f.valid())
+            f.get();
+    if (!ok)
+        for (auto &j : jobs)
+            j.hw_ok = false;
+    report_upto(jobs.size() - 1);
+    return n_ok;
+}
+
+// -----------------------------------------------------------------------------
+// main(): una o varias imágenes por la misma sesión
+// -----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    bool pipeline = false;
+    bool box = false;
+    std::string meta_path = "meta.json";
+    std::string cache_dir;
+    long cache_mb = 0;
+    int first = 1;
+    for (; first < argc; ++first)
     {
-        std::cerr << "WARNING: hw_out.size() != ref_out.size()\n";
+        std::string a = argv[first];
+        if (a == "--pipeline")
+            pipeline = true;
+        else if (a == "--box")
+            box = true;
+        else if (a == "--meta" && first + 1 < argc)
+            meta_path = argv[++first];
+        else if (a == "--cache" && first + 1 < argc)
+            cache_dir = argv[++first];
+        else if (a == "--cache-max-mb" && first + 1 < argc)
+            cache_mb = std::atol(argv[++first]);
+        else
+            break;
     }
 
-    int total = std::min<int>(hw_out.size(), ref_out.size());
-    int mismatches = 0;
+    const int n_args = argc - first;
+    if (n_args < 5 || n_args % 5 != 0)
+    {
+        std::cerr << "Uso:\n  " << argv[0]
+                  << " [--pipeline] [--box] [--meta meta.json] [--cache dir [--cache-max-mb N]] <img_w> <img_h> <scale_hex> <in_raw> <out_hw_raw>"
+                  << " [<img_w> <img_h> <scale_hex> <in_raw> <out_hw_raw> ...]\n\n";
+        return 1;
+    }
 
-    for (int i = 0; i < total; ++i)
+    const int n_img = n_args / 5;
+    std::vector<image_job> jobs(n_img);
+    std::unique_ptr<result_cache> cache;
+    try
     {
-        uint8_t ref = ref_out[i];
-        uint8_t hw = hw_out[i];
-        if (ref != hw)
+        cache = open_result_cache(cache_dir, cache_mb);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+    try
+    {
+        for (int k = 0; k < n_img; ++k)
         {
-            if (mismatches < 20)
-            {
-                int x = i % out_w;
-                int y = i / out_w;
-                std::cout << "Mismatch en pixel " << i
-                          << " (x=" << x << ", y=" << y << "): "
-                          << "REF=0x" << std::hex << std::setw(2) << std::setfill('0') << (int)ref
-                          << " HW=0x" << std::setw(2) << (int)hw
-                          << std::dec << "\n";
-            }
-            mismatches++;
+            char **a = argv + first + 5 * k;
+            jobs[k].img_w = std::stoi(a[0]);
+            jobs[k].img_h = std::stoi(a[1]);
+            jobs[k].scale_hex = a[2];
+            jobs[k].in_raw = a[3];
+            jobs[k].out_hw = a[4];
+            jobs[k].box = box;
+            jobs[k].cache = cache.get();
         }
     }
+    catch (const std::exception &e)
+    {
+        std::cerr << "ERROR: img_w/img_h inválidos (" << e.what() << ")\n";
+        return 1;
+    }
 
-    if (mismatches == 0)
+    using clk = std::chrono::steady_clock;
+    double sc_start_ms = 0;
+    sc_session sc;
     {
-        std::cout << "[OK] HW coincide con referencia bilineal (modelo Q8.8 del core).\n";
-        return 0;
+        stage_clock c(sc_start_ms);
+        if (!start_system_console(sc))
+            return 1;
+    }
+
+    auto t_all = clk::now();
+    int n_ok = 0;
+
+    if (pipeline)
+    {
+        n_ok = run_pipeline(sc, jobs);
     }
     else
     {
-        std::cout << "[FAIL] Se encontraron " << mismatches
-                  << " mismatches (se muestran hasta 20).\n";
-        return 1;
+        for (int k = 0; k < n_img; ++k)
+        {
+            if (n_img > 1)
+                std::cout << "================ Imagen " << k + 1 << "/" << n_img
+                          << " ================\n";
+
+            auto t0 = clk::now();
+            if (run_image(sc, jobs[k]) == 0)
+                ++n_ok;
+            double ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+            std::cout << "Tiempo de la imagen: " << std::fixed << std::setprecision(1)
+                      << ms << " ms" << std::defaultfloat << "\n";
+
+            if (!sc.running())
+            {
+                std::cerr << "ERROR: se cerró la sesión de system-console.\n";
+                break;
+            }
+        }
     }
+
+    double s_all = std::chrono::duration<double>(clk::now() - t_all).count();
+    if (n_img > 1 || pipeline)
+        std::cout << "Resumen: " << n_ok << " de " << n_img << " imágenes OK en "
+                  << std::fixed << std::setprecision(3) << s_all << " s ("
+                  << std::setprecision(2) << n_img / s_all << " cuadros/s"
+                  << (pipeline ? ", pipeline" : "") << ")" << std::defaultfloat << "\n";
+    if (cache)
+        std::cout << "Ref: " << cache->summary() << "\n";
+    if (write_meta(meta_path, jobs, pipeline, sc_start_ms, s_all * 1e3, cache.get()))
+        std::cout << "Tiempos y perf en " << meta_path << "\n";
+    return n_ok == n_img ? 0 : 1;
 }
@@ -0,0 +1,493 @@
+// Reemplazo local de system-console + dsa_jtag_server.tcl para probar el
+// lado host sin placa.
+//
+// Habla el mismo protocolo de una línea por comando que dsa_jtag_server.tcl
+// (ping, wr, rd, cfg, load, run, bank, start, wait, dump, quit; respuestas
+// @@ok / @@err y @@ready al arrancar) y cada comando hace las mismas
+// transacciones que el Tcl sobre dsa_top_emu.h: el emulador del mapa de
+// registros de dsa_top_seq, con el core de model/core_cycle_model.h. Así el
+// driver corre igual que contra la FPGA (tiles, bancos ping-pong, modo box)
+// y se pueden medir y ajustar la subida, el pipeline y el batching en
+// cualquier Linux.
+//
+// Por pipe (stdin/stdout, como lo lanza dsa_jtag_driver):
+//   DSA_SC_BIN=$PWD/dsa_top_emu ./dsa_jtag_driver 64 64 0x80 entrada.raw salida.raw
+// Los argumentos de system-console (-cli, --script=..., la ruta del
+// proyecto) se ignoran, y como DSA_SC_BIN no lleva opciones, también se
+// leen de DSA_EMU_OPTS:
+//   DSA_EMU_OPTS="--txn-us 800 --word-us 1" DSA_SC_BIN=... ./dsa_jtag_driver ...
+//
+// Por socket Unix: --socket ruta atiende conexiones de a una (los registros
+// y la BRAM siguen entre conexiones, como la placa) y --connect ruta hace de
+// puente entre stdin/stdout y ese socket, para usarlo desde el driver con
+// DSA_EMU_OPTS="--connect ruta".
+//
+// Opciones:
+//   --max WxH       tamaño de la BRAM (IMG_MAX_W x IMG_MAX_H), 32x32
+//   --clk-mhz F     reloj del core; 0 = la corrida termina al instante (50)
+//   --txn-us U      latencia fija por transacción JTAG (0)
+//   --word-us U     latencia por palabra de 32 bits (0)
+//   --quiet         sin el resumen final en stderr
+//
+// Compilar: make tb/JTAG/dsa/pc/dsa_top_emu   (o)
+//   g++ -std=c++17 -O2 -pthread -o dsa_top_emu dsa_top_emu.cpp
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "dsa_top_emu.h"
+
+// Polls de STATUS antes de rendirse en "wait" (RUN_MAX_POLLS del Tcl)
+static const int RUN_MAX_POLLS = 100000;
+
+// -----------------------------------------------------------------------------
+// Comandos: mismas transacciones que los procs de dsa_jtag_server.tcl
+// -----------------------------------------------------------------------------
+
+class emu_server
+{
+public:
+    explicit emu_server(dsa_top_emu &emu) : emu_(emu) {}
+
+    // Una línea de comando; devuelve la respuesta sin "@@" y pone quit en
+    // true con "quit"
+    std::string handle(const std::string &line, bool &quit)
+    {
+        std::istringstream ss(line);
+        std::string cmd;
+        std::vector<std::string> args;
+        ss >> cmd;
+        for (std::string a; ss >> a;)
+            args.push_back(a);
+
+        quit = false;
+        if (cmd == "quit")
+        {
+            quit = true;
+            return "ok bye";
+        }
+        try
+        {
+            std::string r;
+            if (cmd == "ping")
+                r = "pong";
+            else if (cmd == "wr")
+                emu_.write1(reg_arg(args, 0), num_arg(args, 1));
+            else if (cmd == "rd")
+                r = std::to_string(emu_.read1(reg_arg(args, 0)));
+            else if (cmd == "cfg")
+                cmd_cfg(args);
+            else if (cmd == "load")
+                r = std::to_string(cmd_load(str_arg(args, 0)));
+            else if (cmd == "run")
+            {
+                cmd_start();
+                r = cmd_wait();
+            }
+            else if (cmd == "bank")
+                emu_.write1(dsa_top_emu::REG_BANK,
+                            ((num_arg(args, 0) & 1) << 1) | (num_arg(args, 1) & 1));
+            else if (cmd == "start")
+                cmd_start();
+            else if (cmd == "wait")
+                r = cmd_wait();
+            else if (cmd == "dump")
+                r = std::to_string(cmd_dump(str_arg(args, 0), num_arg(args, 1)));
+            else
+                throw std::runtime_error("comando desconocido: " + cmd);
+            return r.empty() ? "ok" : "ok " + r;
+        }
+        catch (const std::exception &e)
+        {
+            return std::string("err ") + e.what();
+        }
+    }
+
+private:
+    dsa_top_emu &emu_;
+
+    static const std::string &str_arg(const std::vector<std::string> &a, size_t i)
+    {
+        if (i >= a.size())
+            throw std::runtime_error("faltan argumentos");
+        return a[i];
+    }
+
+    // Entero como lo acepta Tcl (decimal o 0x...)
+    static uint32_t num_arg(const std::vector<std::string> &a, size_t i)
+    {
+        const std::string &s = str_arg(a, i);
+        try
+        {
+            size_t end = 0;
+            long long v = std::stoll(s, &end, 0);
+            if (end != s.size())
+                throw std::invalid_argument(s);
+            return (uint32_t)v;
+        }
+        catch (const std::exception &)
+        {
+            throw std::runtime_error("se esperaba un entero y llegó \"" + s + "\"");
+        }
+    }
+
+    static uint32_t reg_arg(const std::vector<std::string> &a, size_t i)
+    {
+        return num_arg(a, i) & 0xFFFF;
+    }
+
+    // Ráfagas en trozos del tamaño de la ventana, una transacción por trozo
+    void burst_write(uint32_t reg, const std::vector<uint32_t> &words)
+    {
+        for (size_t i = 0; i < words.size(); i += dsa_top_emu::WIN_WORDS)
+            emu_.write(reg, words.data() + i,
+                       std::min<size_t>(dsa_top_emu::WIN_WORDS, words.size() - i));
+    }
+
+    void burst_read(uint32_t reg, std::vector<uint32_t> &words)
+    {
+        for (size_t i = 0; i < words.size(); i += dsa_top_emu::WIN_WORDS)
+            emu_.read(reg, words.data() + i,
+                      std::min<size_t>(dsa_top_emu::WIN_WORDS, words.size() - i));
+    }
+
+    void cmd_cfg(const std::vector<std::string> &args)
+    {
+        if (args.size() != 11 && args.size() != 12)
+            throw std::runtime_error("cfg espera 11 o 12 valores");
+        static const uint32_t regs[11] = {
+            dsa_top_emu::REG_IMG_W, dsa_top_emu::REG_IMG_H, dsa_top_emu::REG_SCALE,
+            dsa_top_emu::REG_SRC_W, dsa_top_emu::REG_SRC_H,
+            dsa_top_emu::REG_ORG_X, dsa_top_emu::REG_ORG_Y,
+            dsa_top_emu::REG_OFF_X, dsa_top_emu::REG_OFF_Y,
+            dsa_top_emu::REG_TILE_OW, dsa_top_emu::REG_TILE_OH};
+        for (size_t i = 0; i < 11; ++i)
+            emu_.write1(regs[i], num_arg(args, i));
+        emu_.write1(dsa_top_emu::REG_MODE, args.size() == 12 ? num_arg(args, 11) : 0);
+    }
+
+    // RAW rellenado a múltiplo de 4, palabras little-endian (b0 = píxel 0)
+    size_t cmd_load(const std::string &path)
+    {
+        std::ifstream f(path, std::ios::binary);
+        if (!f)
+            throw std::runtime_error("no se pudo abrir " + path);
+        std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        std::vector<uint32_t> words((data.size() + 3) / 4, 0);
+        if (!data.empty())
+            std::memcpy(words.data(), data.data(), data.size());
+
+        emu_.write1(dsa_top_emu::REG_IN_ADDR, 0);
+        burst_write(dsa_top_emu::REG_IN_WIN, words);
+        return words.size();
+    }
+
+    void cmd_start() { emu_.write1(dsa_top_emu::REG_CTRL, 1); }
+
+    std::string cmd_wait()
+    {
+        for (int n = 0; n < RUN_MAX_POLLS; ++n)
+        {
+            if ((emu_.read1(dsa_top_emu::REG_STATUS) & 0x3) == 0x2)
+            {
+                const uint32_t cyc = emu_.read1(dsa_top_emu::REG_PERF_CYC);
+                const uint32_t pix = emu_.read1(dsa_top_emu::REG_PERF_PIX);
+                return std::to_string(cyc) + " " + std::to_string(pix);
+            }
+            emu_.idle_until_done();
+        }
+        throw std::runtime_error("timeout esperando DONE");
+    }
+
+    size_t cmd_dump(const std::string &path, size_t npix)
+    {
+        std::vector<uint32_t> words((npix + 3) / 4);
+        emu_.write1(dsa_top_emu::REG_OUT_ADDR, 0);
+        burst_read(dsa_top_emu::REG_OUT_WIN, words);
+
+        std::ofstream f(path, std::ios::binary);
+        if (!f)
+            throw std::runtime_error("no se pudo abrir " + path + " para escritura");
+        f.write(reinterpret_cast<const char *>(words.data()), (std::streamsize)npix);
+        if (!f)
+            throw std::runtime_error("fallo al escribir " + path);
+        return npix;
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Transporte: pipe (stdin/stdout) o socket Unix
+// -----------------------------------------------------------------------------
+
+static bool write_all(int fd, const std::string &s)
+{
+    size_t off = 0;
+    while (off < s.size())
+    {
+        ssize_t r = ::write(fd, s.data() + off, s.size() - off);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        off += (size_t)r;
+    }
+    return true;
+}
+
+// Atiende una sesión: @@ready y después un comando por línea hasta quit o
+// EOF. false si el otro lado se cerró sin quit.
+static bool serve(emu_server &srv, int in_fd, int out_fd)
+{
+    if (!write_all(out_fd, "@@ready\n"))
+        return false;
+    std::string buf;
+    char tmp[4096];
+    for (;;)
+    {
+        size_t nl;
+        while ((nl = buf.find('\n')) != std::string::npos)
+        {
+            std::string line = buf.substr(0, nl);
+            buf.erase(0, nl + 1);
+            const size_t b = line.find_first_not_of(" \t\r");
+            if (b == std::string::npos)
+                continue;
+            line = line.substr(b, line.find_last_not_of(" \t\r") - b + 1);
+
+            bool quit = false;
+            std::string reply = srv.handle(line, quit);
+            for (char &c : reply)
+                if (c == '\n')
+                    c = ' ';
+            if (!write_all(out_fd, "@@" + reply + "\n"))
+                return false;
+            if (quit)
+                return true;
+        }
+        ssize_t n = ::read(in_fd, tmp, sizeof tmp);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        buf.append(tmp, (size_t)n);
+    }
+}
+
+static int listen_unix(const std::string &path)
+{
+    sockaddr_un addr{};
+    if (path.size() >= sizeof addr.sun_path)
+        throw std::runtime_error("ruta de socket demasiado larga: " + path);
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        throw std::runtime_error("no se pudo crear el socket");
+    ::unlink(path.c_str());
+    if (::bind(fd, (sockaddr *)&addr, sizeof addr) != 0 || ::listen(fd, 4) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("no se pudo escuchar en " + path + ": " + std::strerror(errno));
+    }
+    return fd;
+}
+
+static int connect_unix(const std::string &path)
+{
+    sockaddr_un addr{};
+    if (path.size() >= sizeof addr.sun_path)
+        throw std::runtime_error("ruta de socket demasiado larga: " + path);
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        throw std::runtime_error("no se pudo crear el socket");
+    if (::connect(fd, (sockaddr *)&addr, sizeof addr) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("no se pudo conectar a " + path + ": " + std::strerror(errno));
+    }
+    return fd;
+}
+
+// Copia stdin -> socket y socket -> stdout hasta que el socket se cierra
+static int bridge(int sock)
+{
+    pollfd p[2] = {{STDIN_FILENO, POLLIN, 0}, {sock, POLLIN, 0}};
+    char tmp[4096];
+    bool in_open = true;
+    for (;;)
+    {
+        p[0].fd = in_open ? STDIN_FILENO : -1;
+        if (::poll(p, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return 1;
+        }
+        if (p[1].revents)
+        {
+            ssize_t n = ::read(sock, tmp, sizeof tmp);
+            if (n <= 0)
+                return 0;
+            if (!write_all(STDOUT_FILENO, std::string(tmp, (size_t)n)))
+                return 1;
+        }
+        if (in_open && p[0].revents)
+        {
+            ssize_t n = ::read(STDIN_FILENO, tmp, sizeof tmp);
+            if (n <= 0)
+            {
+                // EOF del driver: se avisa al servidor y se espera lo que falte
+                ::shutdown(sock, SHUT_WR);
+                in_open = false;
+            }
+            else if (!write_all(sock, std::string(tmp, (size_t)n)))
+            {
+                return 1;
+            }
+        }
+    }
+}
+
+static void print_summary(const dsa_top_emu &emu)
+{
+    const dsa_emu_counters &c = emu.counters();
+    std::fprintf(stderr,
+                 "dsa_top_emu: %llu transacciones (%llu palabras escritas, %llu leídas),"
+                 " %llu corridas, %llu ciclos de core\n",
+                 (unsigned long long)c.transactions, (unsigned long long)c.words_wr,
+                 (unsigned long long)c.words_rd, (unsigned long long)c.starts,
+                 (unsigned long long)c.core_cycles);
+}
+
+static void usage(const char *argv0)
+{
+    std::cerr << "uso: " << argv0
+              << " [--max 32x32] [--clk-mhz 50] [--txn-us 0] [--word-us 0]"
+              << " [--socket ruta | --connect ruta] [--quiet]\n"
+              << "  (también lee opciones de DSA_EMU_OPTS; -cli, --script=... y la ruta"
+              << " del proyecto se ignoran)\n";
+}
+
+int main(int argc, char **argv)
+{
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Opciones de DSA_EMU_OPTS primero, después las de la línea de comando
+    std::vector<std::string> args;
+    if (const char *env = std::getenv("DSA_EMU_OPTS"))
+    {
+        std::istringstream ss(env);
+        for (std::string a; ss >> a;)
+            args.push_back(a);
+    }
+    for (int i = 1; i < argc; ++i)
+        args.push_back(argv[i]);
+
+    dsa_emu_timing timing;
+    int max_w = 32, max_h = 32;
+    std::string sock_path, connect_path;
+    bool quiet = false;
+    try
+    {
+        for (size_t i = 0; i < args.size(); ++i)
+        {
+            const std::string &a = args[i];
+            const bool has_val = i + 1 < args.size();
+            if (a == "--max" && has_val)
+            {
+                if (std::sscanf(args[++i].c_str(), "%dx%d", &max_w, &max_h) != 2 ||
+                    max_w <= 0 || max_h <= 0)
+                    throw std::runtime_error("--max espera WxH");
+            }
+            else if (a == "--clk-mhz" && has_val)
+                timing.clk_mhz = std::stod(args[++i]);
+            else if (a == "--txn-us" && has_val)
+                timing.txn_us = std::stod(args[++i]);
+            else if (a == "--word-us" && has_val)
+                timing.word_us = std::stod(args[++i]);
+            else if (a == "--socket" && has_val)
+                sock_path = args[++i];
+            else if (a == "--connect" && has_val)
+                connect_path = args[++i];
+            else if (a == "--quiet")
+                quiet = true;
+            else if (a.empty() || a == "-cli" || a.compare(0, 9, "--script=") == 0 || a[0] != '-')
+                continue;   // argumentos de system-console
+            else
+                throw std::runtime_error("opción desconocida: " + a);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        // el driver solo ve stdout: que el error le llegue como @@err
+        std::printf("@@err %s\n", e.what());
+        std::fflush(stdout);
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        if (!connect_path.empty())
+            return bridge(connect_unix(connect_path));
+
+        dsa_top_emu emu(max_w, max_h, timing);
+        emu_server srv(emu);
+
+        if (sock_path.empty())
+        {
+            serve(srv, STDIN_FILENO, STDOUT_FILENO);
+        }
+        else
+        {
+            int lfd = listen_unix(sock_path);
+            std::cerr << "dsa_top_emu: escuchando en " << sock_path << "\n";
+            for (;;)
+            {
+                int c = ::accept(lfd, nullptr, nullptr);
+                if (c < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    break;
+                }
+                serve(srv, c, c);
+                ::close(c);
+                if (!quiet)
+                    print_summary(emu);
+            }
+            ::close(lfd);
+        }
+        if (!quiet)
+            print_summary(emu);
+    }
+    catch (const std::exception &e)
+    {
+        std::printf("@@err %s\n", e.what());
+        std::fflush(stdout);
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,320 @@
+// Emulador en software del mapa de registros de dsa_top_seq.
+//
+// Ve el mismo bus que el JTAG-to-Avalon Master: escrituras y lecturas de 32
+// bits por índice de registro, donde una transacción de N palabras recorre
+// N direcciones seguidas (así las ráfagas por IN_WIN/OUT_WIN caen todas en
+// la ventana). Tiene los dos bancos ping-pong de BRAM, los registros de
+// tiling y REG_MODE[1] (box). Al START calcula out_w/out_h e inv_scale_q
+// igual que el RTL y corre el core con model/core_cycle_model.h (bilineal o
+// box), que da los mismos píxeles y PERF_CYC/PERF_PIX que el core.
+//
+// Tiempos (dsa_emu_timing):
+//  - clk_mhz > 0: STATUS se queda en busy los ciclos que tardaría el core
+//    (start_to_done) desde el START, y PERF_* cuentan mientras tanto.
+//  - txn_us + word_us por palabra: lo que cuesta cada transacción JTAG; se
+//    duerme ese tiempo para que el host vea la latencia del cable.
+// Con txn_us = word_us = 0 responde en cuanto puede.
+//
+// Diferencia con la placa: la salida se escribe entera en la BRAM al START,
+// así que un host que lea el banco del core antes de DONE ya ve el
+// resultado (en el HW vería la corrida a medias).
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "../../../../model/core_cycle_model.h"
+
+struct dsa_emu_timing
+{
+    double clk_mhz = 50.0;   // reloj del core (el de la DE1-SoC); 0 = instantáneo
+    double txn_us = 0.0;     // costo fijo de cada transacción JTAG
+    double word_us = 0.0;    // costo de cada palabra de 32 bits de la transacción
+};
+
+// Lo que pasó por el bus desde que arrancó el emulador
+struct dsa_emu_counters
+{
+    uint64_t transactions = 0;
+    uint64_t words_wr = 0, words_rd = 0;
+    uint64_t starts = 0;
+    uint64_t core_cycles = 0;   // suma de PERF_CYC de todas las corridas
+};
+
+class dsa_top_emu
+{
+public:
+    // Índices de registro (dsa_top_seq.sv, dsa_jtag_server.tcl)
+    static const uint32_t REG_CTRL     = 0x0000;
+    static const uint32_t REG_STATUS   = 0x0001;
+    static const uint32_t REG_IMG_W    = 0x0002;
+    static const uint32_t REG_IMG_H    = 0x0003;
+    static const uint32_t REG_SCALE    = 0x0004;
+    static const uint32_t REG_MODE     = 0x0005;
+    static const uint32_t REG_PERF_CYC = 0x0006;
+    static const uint32_t REG_PERF_PIX = 0x0007;
+    static const uint32_t REG_SRC_W    = 0x0008;
+    static const uint32_t REG_SRC_H    = 0x0009;
+    static const uint32_t REG_ORG_X    = 0x000A;
+    static const uint32_t REG_ORG_Y    = 0x000B;
+    static const uint32_t REG_OFF_X    = 0x000C;
+    static const uint32_t REG_OFF_Y    = 0x000D;
+    static const uint32_t REG_TILE_OW  = 0x000E;
+    static const uint32_t REG_TILE_OH  = 0x000F;
+    static const uint32_t REG_BANK     = 0x0010;
+    static const uint32_t REG_IN_ADDR  = 0x0020;
+    static const uint32_t REG_IN_DATA  = 0x0021;
+    static const uint32_t REG_OUT_ADDR = 0x0030;
+    static const uint32_t REG_OUT_DATA = 0x0031;
+    static const uint32_t REG_IN_WIN   = 0x1000;
+    static const uint32_t REG_OUT_WIN  = 0x1400;
+    static const uint32_t WIN_WORDS    = 0x0400;
+
+    // max_w x max_h = IMG_MAX_W x IMG_MAX_H del bitstream (32x32)
+    explicit dsa_top_emu(int max_w = 32, int max_h = 32, const dsa_emu_timing &timing = {})
+        : max_w_(max_w), max_h_(max_h),
+          max_pixels_(max_w * max_h), max_words_((max_w * max_h + 3) / 4),
+          timing_(timing),
+          in_mem_(2 * (size_t)max_pixels_, 0), out_mem_(2 * (size_t)max_pixels_, 0)
+    {
+    }
+
+    // Una transacción de n palabras desde el registro reg (master_write_32 /
+    // master_read_32 con una lista)
+    void write(uint32_t reg, const uint32_t *v, size_t n)
+    {
+        pace(n);
+        counters_.words_wr += n;
+        for (size_t k = 0; k < n; ++k)
+            write_reg((reg + (uint32_t)k) & 0xFFFF, v[k]);
+    }
+
+    void read(uint32_t reg, uint32_t *v, size_t n)
+    {
+        pace(n);
+        counters_.words_rd += n;
+        for (size_t k = 0; k < n; ++k)
+            v[k] = read_reg((reg + (uint32_t)k) & 0xFFFF);
+    }
+
+    void write1(uint32_t reg, uint32_t v) { write(reg, &v, 1); }
+
+    uint32_t read1(uint32_t reg)
+    {
+        uint32_t v = 0;
+        read(reg, &v, 1);
+        return v;
+    }
+
+    // Sin costo de JTAG un poll de STATUS no cuesta nada: en vez de girar,
+    // el que espera DONE duerme hasta que termina la corrida
+    void idle_until_done() const
+    {
+        if (timing_.txn_us <= 0 && timing_.word_us <= 0 && clk::now() < done_at_)
+            std::this_thread::sleep_until(done_at_);
+    }
+
+    const dsa_emu_counters &counters() const { return counters_; }
+    const dsa_emu_timing &timing() const { return timing_; }
+    int max_w() const { return max_w_; }
+    int max_h() const { return max_h_; }
+
+private:
+    using clk = std::chrono::steady_clock;
+
+    int max_w_, max_h_, max_pixels_, max_words_;
+    dsa_emu_timing timing_;
+    dsa_emu_counters counters_;
+
+    // BRAM de 8 bits; el banco b ocupa [b*max_pixels, (b+1)*max_pixels)
+    std::vector<uint8_t> in_mem_, out_mem_;
+
+    // Registros
+    uint32_t img_w_ = 0, img_h_ = 0, scale_ = 0, mode_ = 0;
+    uint32_t src_w_ = 0, src_h_ = 0, org_x_ = 0, org_y_ = 0;
+    uint32_t off_x_ = 0, off_y_ = 0, tile_ow_ = 0, tile_oh_ = 0;
+    uint32_t host_bank_ = 0, core_bank_ = 0;
+    uint32_t in_ptr_ = 0, out_ptr_ = 0;
+
+    // Última corrida: contadores finales y cuándo termina
+    bool ran_ = false;
+    core_stats run_;
+    uint64_t run_cycles_ = 0;    // START -> DONE
+    clk::time_point start_at_{}, done_at_{};
+
+    // Latencia de una transacción de n palabras. Se lleva un reloj virtual
+    // para que los costos chicos se acumulen en vez de perderse en el
+    // redondeo del sleep.
+    clk::time_point paced_{};
+
+    void pace(size_t n)
+    {
+        ++counters_.transactions;
+        const double us = timing_.txn_us + timing_.word_us * (double)n;
+        if (us <= 0)
+            return;
+        const clk::time_point now = clk::now();
+        paced_ = std::max(paced_, now) +
+                 std::chrono::duration_cast<clk::duration>(std::chrono::duration<double, std::micro>(us));
+        if (paced_ > now)
+            std::this_thread::sleep_until(paced_);
+    }
+
+    bool busy() const { return ran_ && clk::now() < done_at_; }
+
+    // Ciclos desde el START, saturado en los de la corrida
+    uint64_t elapsed_cycles() const
+    {
+        if (!busy())
+            return run_cycles_;
+        const double us = std::chrono::duration<double, std::micro>(clk::now() - start_at_).count();
+        return std::min(run_cycles_, (uint64_t)(us * timing_.clk_mhz));
+    }
+
+    // PERF_CYC no cuenta el ciclo de start_pulse
+    uint64_t perf_cyc_now() const { return std::min<uint64_t>(run_.perf_cyc, elapsed_cycles()); }
+
+    void write_reg(uint32_t reg, uint32_t v)
+    {
+        switch (reg)
+        {
+        case REG_CTRL:     if (v & 1) start(); break;
+        case REG_IMG_W:    img_w_ = v & 0xFFFF; break;
+        case REG_IMG_H:    img_h_ = v & 0xFFFF; break;
+        case REG_SCALE:    scale_ = v & 0xFFFF; break;
+        case REG_MODE:     mode_ = v & 0xFF; break;
+        case REG_SRC_W:    src_w_ = v & 0xFFFF; break;
+        case REG_SRC_H:    src_h_ = v & 0xFFFF; break;
+        case REG_ORG_X:    org_x_ = v & 0xFFFF; break;
+        case REG_ORG_Y:    org_y_ = v & 0xFFFF; break;
+        case REG_OFF_X:    off_x_ = v & 0xFFFF; break;
+        case REG_OFF_Y:    off_y_ = v & 0xFFFF; break;
+        case REG_TILE_OW:  tile_ow_ = v & 0xFFFF; break;
+        case REG_TILE_OH:  tile_oh_ = v & 0xFFFF; break;
+        case REG_BANK:
+            host_bank_ = v & 1;
+            core_bank_ = (v >> 1) & 1;
+            break;
+        case REG_IN_ADDR:  in_ptr_ = v & 0xFFFF; break;
+        case REG_OUT_ADDR: out_ptr_ = v & 0xFFFF; break;
+        default: break;
+        }
+
+        // IN_DATA o la ventana IN_WIN: 4 píxeles en in_ptr (b0 = píxel 0)
+        const bool in_win = reg >= REG_IN_WIN && reg < REG_IN_WIN + WIN_WORDS;
+        if ((reg == REG_IN_DATA || in_win) && in_ptr_ < (uint32_t)max_words_)
+        {
+            uint8_t *bank = in_mem_.data() + (size_t)host_bank_ * max_pixels_;
+            for (int b = 0; b < 4; ++b)
+            {
+                const uint32_t i = in_ptr_ * 4 + b;
+                if (i < (uint32_t)max_pixels_)
+                    bank[i] = (uint8_t)(v >> (8 * b));
+            }
+            ++in_ptr_;
+        }
+    }
+
+    uint32_t read_reg(uint32_t reg)
+    {
+        const bool out_win = reg >= REG_OUT_WIN && reg < REG_OUT_WIN + WIN_WORDS;
+        if (reg == REG_OUT_DATA || out_win)
+        {
+            const uint8_t *bank = out_mem_.data() + (size_t)host_bank_ * max_pixels_;
+            uint32_t w = 0;
+            for (int b = 0; b < 4; ++b)
+            {
+                const uint32_t i = out_ptr_ * 4 + b;
+                if (i < (uint32_t)max_pixels_)
+                    w |= (uint32_t)bank[i] << (8 * b);
+            }
+            if (out_ptr_ < (uint32_t)max_words_)
+                ++out_ptr_;
+            return w;
+        }
+
+        switch (reg)
+        {
+        case REG_STATUS:
+        {
+            const bool b = busy();
+            return ((ran_ && !b) ? 2u : 0u) | (b ? 1u : 0u);   // {done, busy}
+        }
+        case REG_IMG_W:    return img_w_;
+        case REG_IMG_H:    return img_h_;
+        case REG_SCALE:    return scale_;
+        case REG_MODE:     return mode_;
+        case REG_SRC_W:    return src_w_;
+        case REG_SRC_H:    return src_h_;
+        case REG_ORG_X:    return org_x_;
+        case REG_ORG_Y:    return org_y_;
+        case REG_OFF_X:    return off_x_;
+        case REG_OFF_Y:    return off_y_;
+        case REG_TILE_OW:  return tile_ow_;
+        case REG_TILE_OH:  return tile_oh_;
+        case REG_BANK:     return (core_bank_ << 1) | host_bank_;
+        case REG_IN_ADDR:  return in_ptr_;
+        case REG_OUT_ADDR: return out_ptr_;
+        case REG_PERF_CYC: return (uint32_t)perf_cyc_now();
+        case REG_PERF_PIX:
+            // durante la corrida, proporcional a los ciclos que pasaron
+            return (uint32_t)(run_.perf_cyc ? run_.perf_pix * perf_cyc_now() / run_.perf_cyc
+                                            : run_.perf_pix);
+        default:           return 0;
+        }
+    }
+
+    // START: dimensiones, inv_scale_q, banco y modo como dsa_top_seq, y la
+    // corrida entera con el modelo del core
+    void start()
+    {
+        const bool tile_en = src_w_ != 0;
+        uint32_t ow = ((img_w_ * scale_) >> 8) & 0xFFFF;
+        uint32_t oh = ((img_h_ * scale_) >> 8) & 0xFFFF;
+        ow = std::min(std::max(ow, 1u), (uint32_t)max_w_);
+        oh = std::min(std::max(oh, 1u), (uint32_t)max_h_);
+        ow = std::min(ow, img_w_);
+        oh = std::min(oh, img_h_);
+        if (tile_en)
+        {
+            ow = std::min(tile_ow_ ? tile_ow_ : 1u, (uint32_t)max_w_);
+            oh = std::min(tile_oh_ ? tile_oh_ : 1u, (uint32_t)max_h_);
+        }
+
+        core_params p;
+        p.in_w = (int)img_w_;
+        p.in_h = (int)img_h_;
+        p.out_w = (int)ow;
+        p.out_h = (int)oh;
+        p.inv_scale_q = core_inv_scale_q(scale_);
+        p.src_w = (int)(tile_en ? src_w_ : img_w_);
+        p.src_h = (int)(tile_en ? src_h_ : img_h_);
+        if (tile_en)
+        {
+            p.org_x = (int)org_x_;
+            p.org_y = (int)org_y_;
+            p.off_x = (int)off_x_;
+            p.off_y = (int)off_y_;
+        }
+        p.bram = max_pixels_;
+
+        const size_t base = (size_t)core_bank_ * max_pixels_;
+        run_ = (mode_ & 2) ? run_box_core_model(p, in_mem_.data() + base, out_mem_.data() + base)
+                           : run_core_model(p, in_mem_.data() + base, out_mem_.data() + base);
+        run_.perf_cyc &= 0xFFFFFFFFu;
+        run_cycles_ = run_.start_to_done();
+        ran_ = true;
+        ++counters_.starts;
+        counters_.core_cycles += run_.perf_cyc;
+
+        start_at_ = clk::now();
+        done_at_ = start_at_;
+        if (timing_.clk_mhz > 0)
+            done_at_ += std::chrono::duration_cast<clk::duration>(
+                std::chrono::duration<double, std::micro>(run_cycles_ / timing_.clk_mhz));
+    }
+};
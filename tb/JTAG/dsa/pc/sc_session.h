@@ -0,0 +1,254 @@
+// Sesión persistente con system-console (dsa_jtag_server.tcl).
+//
+// En vez de un std::system por imagen (arranque de system-console + claim del
+// master JTAG + carga del Tcl, varios segundos) se lanza UN proceso hijo con
+// stdin/stdout en pipes y se le mandan comandos de una línea. Cada comando
+// espera su respuesta "@@ok ..." / "@@err ..."; cualquier otra línea que
+// imprima system-console (banner, avisos) se ignora.
+//
+// El mismo protocolo lo puede hablar cualquier otro proceso (por ejemplo un
+// emulador), basta con cambiar el comando que se lanza.
+
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+class sc_session
+{
+public:
+    sc_session() = default;
+    sc_session(const sc_session &) = delete;
+    sc_session &operator=(const sc_session &) = delete;
+    ~sc_session() { close(); }
+
+    // Lanza argv[0] con argv y espera "@@ready" (hasta timeout_ms).
+    bool start(const std::vector<std::string> &argv, int timeout_ms)
+    {
+        if (argv.empty())
+            return false;
+        std::signal(SIGPIPE, SIG_IGN);   // si el hijo muere, write() da EPIPE
+
+        int in_p[2], out_p[2];
+        if (::pipe(in_p) != 0)
+            return false;
+        if (::pipe(out_p) != 0)
+        {
+            ::close(in_p[0]);
+            ::close(in_p[1]);
+            return false;
+        }
+
+        pid_ = ::fork();
+        if (pid_ < 0)
+        {
+            ::close(in_p[0]); ::close(in_p[1]);
+            ::close(out_p[0]); ::close(out_p[1]);
+            return false;
+        }
+        if (pid_ == 0)
+        {
+            ::dup2(in_p[0], STDIN_FILENO);
+            ::dup2(out_p[1], STDOUT_FILENO);
+            ::close(in_p[0]); ::close(in_p[1]);
+            ::close(out_p[0]); ::close(out_p[1]);
+
+            std::vector<char *> args;
+            for (const auto &a : argv)
+                args.push_back(const_cast<char *>(a.c_str()));
+            args.push_back(nullptr);
+            ::execvp(args[0], args.data());
+            std::perror("execvp");
+            ::_exit(127);
+        }
+
+        ::close(in_p[0]);
+        ::close(out_p[1]);
+        to_ = in_p[1];
+        from_ = out_p[0];
+        ::fcntl(to_, F_SETFD, FD_CLOEXEC);
+        ::fcntl(from_, F_SETFD, FD_CLOEXEC);
+
+        std::string line;
+        const clock::time_point deadline = deadline_in(timeout_ms);
+        while (read_line(line, deadline))
+        {
+            if (line == "@@ready")
+                return true;
+            if (line.compare(0, 6, "@@err ") == 0)
+            {
+                last_error_ = line.substr(6);
+                break;
+            }
+        }
+        if (last_error_.empty())
+            last_error_ = "el servidor no respondió @@ready";
+        shutdown(/*force=*/true);
+        return false;
+    }
+
+    bool running() const { return pid_ > 0; }
+
+    // Manda una línea y espera su respuesta. true con "@@ok", y en reply lo
+    // que viene después; false con "@@err" (reply = mensaje), timeout o si el
+    // hijo murió. timeout_ms cuenta para el comando entero, aunque el
+    // servidor siga imprimiendo otras líneas.
+    bool cmd(const std::string &line, std::string &reply, int timeout_ms)
+    {
+        reply.clear();
+        if (!running())
+        {
+            reply = "sesión cerrada";
+            return false;
+        }
+        if (!write_all(line + "\n"))
+        {
+            reply = "no se pudo escribir al servidor";
+            shutdown(/*force=*/true);
+            return false;
+        }
+
+        std::string ans;
+        const clock::time_point deadline = deadline_in(timeout_ms);
+        while (read_line(ans, deadline))
+        {
+            if (ans == "@@ok" || ans.compare(0, 5, "@@ok ") == 0)
+            {
+                reply = ans.size() > 5 ? ans.substr(5) : "";
+                return true;
+            }
+            if (ans.compare(0, 6, "@@err ") == 0)
+            {
+                reply = ans.substr(6);
+                return false;
+            }
+        }
+        reply = "sin respuesta del servidor a '" + line + "'";
+        shutdown(/*force=*/true);
+        return false;
+    }
+
+    // quit + cierra stdin del hijo y lo espera (system-console -cli sale con
+    // EOF en stdin).
+    void close() { shutdown(/*force=*/false); }
+
+    const std::string &last_error() const { return last_error_; }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    pid_t pid_ = -1;
+    int to_ = -1;     // stdin del hijo
+    int from_ = -1;   // stdout del hijo
+    std::string buf_;
+    std::string last_error_;
+
+    // Tiempo que se espera a que el hijo salga antes de matarlo
+    static const int EXIT_WAIT_MS = 5000;
+
+    void shutdown(bool force)
+    {
+        if (to_ >= 0)
+        {
+            std::string ans;
+            const clock::time_point deadline = deadline_in(EXIT_WAIT_MS);
+            if (!force && write_all("quit\n"))
+                while (read_line(ans, deadline) && ans.compare(0, 2, "@@") != 0)
+                    ;
+            ::close(to_);
+            to_ = -1;
+        }
+        if (from_ >= 0)
+        {
+            ::close(from_);
+            from_ = -1;
+        }
+        if (pid_ > 0)
+        {
+            if (force)
+                ::kill(pid_, SIGTERM);
+            int st = 0;
+            for (int waited = 0; ::waitpid(pid_, &st, WNOHANG) == 0; waited += 10)
+            {
+                if (waited >= EXIT_WAIT_MS)
+                {
+                    ::kill(pid_, SIGKILL);
+                    ::waitpid(pid_, &st, 0);
+                    break;
+                }
+                ::usleep(10 * 1000);
+            }
+            pid_ = -1;
+        }
+        buf_.clear();
+    }
+
+    bool write_all(const std::string &s)
+    {
+        size_t off = 0;
+        while (off < s.size())
+        {
+            ssize_t r = ::write(to_, s.data() + off, s.size() - off);
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r <= 0)
+                return false;
+            off += (size_t)r;
+        }
+        return true;
+    }
+
+    static clock::time_point deadline_in(int timeout_ms)
+    {
+        return clock::now() + std::chrono::milliseconds(timeout_ms);
+    }
+
+    // Una línea (sin '\n') de stdout del hijo; false con EOF o si se pasa
+    // deadline. El poll espera solo lo que falta, así un servidor que no
+    // para de imprimir no estira la espera.
+    bool read_line(std::string &line, clock::time_point deadline)
+    {
+        for (;;)
+        {
+            size_t nl = buf_.find('\n');
+            if (nl != std::string::npos)
+            {
+                line = buf_.substr(0, nl);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                buf_.erase(0, nl + 1);
+                return true;
+            }
+
+            const long long left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                       deadline - clock::now()).count();
+            if (left <= 0)
+                return false;
+            struct pollfd p = {from_, POLLIN, 0};
+            int r = ::poll(&p, 1, (int)left);
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r <= 0)
+                return false;
+
+            char tmp[4096];
+            ssize_t n = ::read(from_, tmp, sizeof tmp);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            buf_.append(tmp, (size_t)n);
+        }
+    }
+};
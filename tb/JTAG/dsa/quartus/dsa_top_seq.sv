@@ -2,9 +2,25 @@
 // Top secuencial con core bilineal escalar:
 //  - Soporta hasta 64x64 píxeles (IMG_MAX_W/H).
 //  - Entrada y salida en BRAM interna de 8 bits (1 píxel por entrada).
-//  - Usa bilinear_core_scalar como único core.
+//  - Usa bilinear_core_scalar; con MODE[1] = 1 corre box_core_scalar
+//    (promedio de área, para escalas < 0.5). El modo se latchea en START.
 //  - PERF_CYC: ciclos mientras el core está ocupado.
 //  - PERF_PIX: número de píxeles escritos por el core (wr_valid).
+//  - Tiling: con SRC_W != 0 la BRAM tiene sólo un tile (con halo) de una
+//    imagen de SRC_W x SRC_H. El core calcula las coordenadas globales desde
+//    ORG_X/ORG_Y y resta OFF_X/OFF_Y para direccionar la BRAM, así que cada
+//    tile da los mismos píxeles que la imagen entera. La salida del tile es
+//    TILE_OW x TILE_OH (la calcula el host).
+//  - Ventanas de ráfaga: cualquier escritura en IN_WIN (0x1000..) carga la
+//    palabra en in_ptr y lo incrementa, igual que IN_DATA; cualquier lectura
+//    en OUT_WIN (0x1400..) devuelve out_ptr y lo incrementa. Un
+//    master_write_32/master_read_32 con una lista de N palabras recorre
+//    direcciones consecutivas de la ventana, así que la imagen entera sube o
+//    baja en una sola transacción JTAG.
+//  - Bancos ping-pong: las BRAM de entrada y salida tienen 2 bancos.
+//    BANK[0] elige el banco que ve el host (IN_*/OUT_*), BANK[1] el que usa
+//    el core, latcheado en START. Mientras el core procesa en un banco el
+//    host carga el siguiente cuadro y lee el anterior en el otro.
 
 module dsa_top_seq #(
   parameter int ADDR_WIDTH = 16,
@@ -28,10 +44,12 @@ module dsa_top_seq #(
   // ---------------------------------------------------------
   localparam int MAX_PIXELS = IMG_MAX_W * IMG_MAX_H;            // 64x64 = 4096
   localparam int MAX_WORDS  = (MAX_PIXELS + 3) >> 2;            // 4096/4 = 1024
+  localparam int NUM_BANKS  = 2;                                // ping-pong
 
-  // Memoria de entrada/salida en píxeles de 8 bits
-  logic [7:0] in_pix_mem  [0:MAX_PIXELS-1];
-  logic [7:0] out_pix_mem [0:MAX_PIXELS-1];
+  // Memoria de entrada/salida en píxeles de 8 bits; el banco b ocupa
+  // [b*MAX_PIXELS, (b+1)*MAX_PIXELS)
+  logic [7:0] in_pix_mem  [0:NUM_BANKS*MAX_PIXELS-1];
+  logic [7:0] out_pix_mem [0:NUM_BANKS*MAX_PIXELS-1];
 
   // ---------------------------------------------------------
   // Registros de configuración / estado
@@ -41,20 +59,57 @@ module dsa_top_seq #(
   localparam logic [15:0] REG_IMG_W     = 16'h0002;
   localparam logic [15:0] REG_IMG_H     = 16'h0003;
   localparam logic [15:0] REG_SCALE     = 16'h0004;
-  localparam logic [15:0] REG_MODE      = 16'h0005;   // guardado pero no usado
+  localparam logic [15:0] REG_MODE      = 16'h0005;   // [1] = box
   localparam logic [15:0] REG_PERF_CYC  = 16'h0006;
   localparam logic [15:0] REG_PERF_PIX  = 16'h0007;
 
+  localparam logic [15:0] REG_SRC_W     = 16'h0008;   // 0 = sin tiling
+  localparam logic [15:0] REG_SRC_H     = 16'h0009;
+  localparam logic [15:0] REG_ORG_X     = 16'h000A;   // 1er píxel de salida del tile
+  localparam logic [15:0] REG_ORG_Y     = 16'h000B;
+  localparam logic [15:0] REG_OFF_X     = 16'h000C;   // píxel global en in_pix_mem[0]
+  localparam logic [15:0] REG_OFF_Y     = 16'h000D;
+  localparam logic [15:0] REG_TILE_OW   = 16'h000E;
+  localparam logic [15:0] REG_TILE_OH   = 16'h000F;
+
+  localparam logic [15:0] REG_BANK      = 16'h0010;   // [0] host, [1] core
+
   localparam logic [15:0] REG_IN_ADDR   = 16'h0020;
   localparam logic [15:0] REG_IN_DATA   = 16'h0021;
   localparam logic [15:0] REG_OUT_ADDR  = 16'h0030;
   localparam logic [15:0] REG_OUT_DATA  = 16'h0031;
 
+  // Ventanas de ráfaga (auto-incremento, la dirección dentro se ignora)
+  localparam logic [15:0] REG_IN_WIN    = 16'h1000;
+  localparam logic [15:0] REG_OUT_WIN   = 16'h1400;
+  localparam logic [15:0] WIN_WORDS     = 16'h0400;   // >= MAX_WORDS
+
   // Config
   logic [15:0] img_w;
   logic [15:0] img_h;
   logic [15:0] scale_q8_8;   // scale en Q8.8 (lo que viene de SW)
-  logic [7:0]  mode;         // guardado pero no usado
+  logic [7:0]  mode;         // [1] = box; [0] lo escriben los smoke tests viejos, sin efecto
+  logic        box_run;      // MODE[1] latcheado en START
+
+  // Tiling
+  logic [15:0] src_w;
+  logic [15:0] src_h;
+  logic [15:0] org_x;
+  logic [15:0] org_y;
+  logic [15:0] off_x;
+  logic [15:0] off_y;
+  logic [15:0] tile_ow;
+  logic [15:0] tile_oh;
+
+  wire tile_en = (src_w != 16'd0);
+
+  // Bancos
+  logic        host_bank;      // banco de IN_DATA/IN_WIN y OUT_DATA/OUT_WIN
+  logic        core_bank;      // banco pedido para el próximo START
+  logic        core_bank_run;  // banco del core, fijo durante la corrida
+
+  wire [31:0] host_base = host_bank     ? MAX_PIXELS : 0;
+  wire [31:0] core_base = core_bank_run ? MAX_PIXELS : 0;
 
   // Dimensiones de salida calculadas en HW
   logic [15:0] out_w;
@@ -71,7 +126,7 @@ module dsa_top_seq #(
   logic [31:0] perf_cyc;
   logic [31:0] perf_pix;
 
-  // Señales del core bilineal escalar
+  // Señales del core activo (bilineal o box, según box_run)
   logic        core_busy;
   logic        core_done;
   logic        core_wr_valid;
@@ -102,6 +157,23 @@ module dsa_top_seq #(
   // Condición de START detectada en la escritura al registro CTRL
   wire start_cond = (h_wr_en && (h_addr == REG_CTRL) && h_wdata[0]);
 
+  // Accesos a datos: registro de una palabra o ventana de ráfaga
+  wire in_win  = (h_addr >= REG_IN_WIN)  && (h_addr < REG_IN_WIN  + WIN_WORDS);
+  wire out_win = (h_addr >= REG_OUT_WIN) && (h_addr < REG_OUT_WIN + WIN_WORDS);
+  wire in_data_wr  = h_wr_en && ((h_addr == REG_IN_DATA)  || in_win);
+  wire out_data_rd = h_rd_en && ((h_addr == REG_OUT_DATA) || out_win);
+
+  // Salidas de cada core
+  logic        bil_busy, bil_done, bil_wr_valid;
+  logic [31:0] bil_wr_addr;
+  logic [7:0]  bil_wr_data;
+  logic [31:0] bil_rd_addr0, bil_rd_addr1, bil_rd_addr2, bil_rd_addr3;
+
+  logic        box_busy, box_done, box_wr_valid;
+  logic [31:0] box_wr_addr;
+  logic [7:0]  box_wr_data;
+  logic [31:0] box_rd_addr0;
+
   // ---------------------------------------------------------
   // Instancia del core bilineal escalar
   // ---------------------------------------------------------
@@ -112,35 +184,89 @@ module dsa_top_seq #(
     .clk        (clk),
     .rst_n      (rst_n),
 
-    .start      (start_pulse),
+    .start      (start_pulse && !box_run),
     .in_w       (img_w),
     .in_h       (img_h),
     .out_w      (out_w),
     .out_h      (out_h),
     .inv_scale_q(inv_scale_q),
 
+    // Tiling (sin tiling la BRAM tiene la imagen completa)
+    .src_w      (tile_en ? src_w : img_w),
+    .src_h      (tile_en ? src_h : img_h),
+    .org_x      (tile_en ? org_x : 16'd0),
+    .org_y      (tile_en ? org_y : 16'd0),
+    .off_x      (tile_en ? off_x : 16'd0),
+    .off_y      (tile_en ? off_y : 16'd0),
+
     // Stepping desactivado
     .step_mode  (1'b0),
     .step       (1'b0),
     .step_ack   (),
 
-    .busy       (core_busy),
-    .done       (core_done),
+    .busy       (bil_busy),
+    .done       (bil_done),
 
-    .rd_addr0   (core_rd_addr0),
-    .rd_addr1   (core_rd_addr1),
-    .rd_addr2   (core_rd_addr2),
-    .rd_addr3   (core_rd_addr3),
+    .rd_addr0   (bil_rd_addr0),
+    .rd_addr1   (bil_rd_addr1),
+    .rd_addr2   (bil_rd_addr2),
+    .rd_addr3   (bil_rd_addr3),
     .rd_data0   (core_rd_data0),
     .rd_data1   (core_rd_data1),
     .rd_data2   (core_rd_data2),
     .rd_data3   (core_rd_data3),
 
-    .wr_valid   (core_wr_valid),
-    .wr_addr    (core_wr_addr),
-    .wr_data    (core_wr_data)
+    .wr_valid   (bil_wr_valid),
+    .wr_addr    (bil_wr_addr),
+    .wr_data    (bil_wr_data)
+  );
+
+  // ---------------------------------------------------------
+  // Instancia del core box (MODE[1]); comparte BRAM y tiling
+  // ---------------------------------------------------------
+  box_core_scalar #(
+    .W_MAX(IMG_MAX_W),
+    .H_MAX(IMG_MAX_H)
+  ) core_box_u (
+    .clk        (clk),
+    .rst_n      (rst_n),
+
+    .start      (start_pulse && box_run),
+    .in_w       (img_w),
+    .in_h       (img_h),
+    .out_w      (out_w),
+    .out_h      (out_h),
+    .inv_scale_q(inv_scale_q),
+
+    .src_w      (tile_en ? src_w : img_w),
+    .src_h      (tile_en ? src_h : img_h),
+    .org_x      (tile_en ? org_x : 16'd0),
+    .org_y      (tile_en ? org_y : 16'd0),
+    .off_x      (tile_en ? off_x : 16'd0),
+    .off_y      (tile_en ? off_y : 16'd0),
+
+    .busy       (box_busy),
+    .done       (box_done),
+
+    .rd_addr0   (box_rd_addr0),
+    .rd_data0   (core_rd_data0),
+
+    .wr_valid   (box_wr_valid),
+    .wr_addr    (box_wr_addr),
+    .wr_data    (box_wr_data)
   );
 
+  // El resto del top ve un solo core
+  assign core_busy     = box_run ? box_busy     : bil_busy;
+  assign core_done     = box_run ? box_done     : bil_done;
+  assign core_wr_valid = box_run ? box_wr_valid : bil_wr_valid;
+  assign core_wr_addr  = box_run ? box_wr_addr  : bil_wr_addr;
+  assign core_wr_data  = box_run ? box_wr_data  : bil_wr_data;
+  assign core_rd_addr0 = box_run ? box_rd_addr0 : bil_rd_addr0;
+  assign core_rd_addr1 = bil_rd_addr1;
+  assign core_rd_addr2 = bil_rd_addr2;
+  assign core_rd_addr3 = bil_rd_addr3;
+
   // start_pulse dura 1 ciclo cuando se escribe CTRL con bit0=1
   always_ff @(posedge clk or negedge rst_n) begin
     if (!rst_n) begin
@@ -165,16 +291,16 @@ module dsa_top_seq #(
     rd_idx3 = core_rd_addr3;
 
     if (rd_idx0 >= 0 && rd_idx0 < MAX_PIXELS)
-      core_rd_data0 = in_pix_mem[rd_idx0];
+      core_rd_data0 = in_pix_mem[core_base + rd_idx0];
 
     if (rd_idx1 >= 0 && rd_idx1 < MAX_PIXELS)
-      core_rd_data1 = in_pix_mem[rd_idx1];
+      core_rd_data1 = in_pix_mem[core_base + rd_idx1];
 
     if (rd_idx2 >= 0 && rd_idx2 < MAX_PIXELS)
-      core_rd_data2 = in_pix_mem[rd_idx2];
+      core_rd_data2 = in_pix_mem[core_base + rd_idx2];
 
     if (rd_idx3 >= 0 && rd_idx3 < MAX_PIXELS)
-      core_rd_data3 = in_pix_mem[rd_idx3];
+      core_rd_data3 = in_pix_mem[core_base + rd_idx3];
   end
 
   // ---------------------------------------------------------
@@ -186,6 +312,20 @@ module dsa_top_seq #(
       img_h      <= 16'd0;
       scale_q8_8 <= 16'd0;
       mode       <= 8'd0;
+      box_run    <= 1'b0;
+
+      src_w      <= 16'd0;
+      src_h      <= 16'd0;
+      org_x      <= 16'd0;
+      org_y      <= 16'd0;
+      off_x      <= 16'd0;
+      off_y      <= 16'd0;
+      tile_ow    <= 16'd0;
+      tile_oh    <= 16'd0;
+
+      host_bank     <= 1'b0;
+      core_bank     <= 1'b0;
+      core_bank_run <= 1'b0;
 
       out_w      <= 16'd0;
       out_h      <= 16'd0;
@@ -200,7 +340,7 @@ module dsa_top_seq #(
       base_pix_wr <= 0;
 
       // Inicializar memorias a 0 (útil en simulación)
-      for (i = 0; i < MAX_PIXELS; i = i + 1) begin
+      for (i = 0; i < NUM_BANKS*MAX_PIXELS; i = i + 1) begin
         in_pix_mem[i]  <= 8'd0;
         out_pix_mem[i] <= 8'd0;
       end
@@ -215,35 +355,23 @@ module dsa_top_seq #(
           REG_SCALE:   scale_q8_8 <= h_wdata[15:0];
           REG_MODE:    mode       <= h_wdata[7:0];
 
+          REG_SRC_W:   src_w      <= h_wdata[15:0];
+          REG_SRC_H:   src_h      <= h_wdata[15:0];
+          REG_ORG_X:   org_x      <= h_wdata[15:0];
+          REG_ORG_Y:   org_y      <= h_wdata[15:0];
+          REG_OFF_X:   off_x      <= h_wdata[15:0];
+          REG_OFF_Y:   off_y      <= h_wdata[15:0];
+          REG_TILE_OW: tile_ow    <= h_wdata[15:0];
+          REG_TILE_OH: tile_oh    <= h_wdata[15:0];
+
+          REG_BANK: begin
+            host_bank <= h_wdata[0];
+            core_bank <= h_wdata[1];
+          end
+
           // Puntero de entrada en palabras de 32 bits
           REG_IN_ADDR: in_ptr     <= h_wdata[15:0];
 
-          // Escritura de datos de entrada (4 píxeles por palabra)
-          REG_IN_DATA: begin
-            if (in_ptr < MAX_WORDS[15:0]) begin
-              tmp_word    = h_wdata;
-              base_pix_wr = in_ptr * 4;
-
-              // b0 = píxel 0 (LSB)
-              if (base_pix_wr >= 0 && base_pix_wr < MAX_PIXELS)
-                in_pix_mem[base_pix_wr] <= tmp_word[7:0];
-
-              // b1 = píxel 1
-              if ((base_pix_wr + 1) >= 0 && (base_pix_wr + 1) < MAX_PIXELS)
-                in_pix_mem[base_pix_wr + 1] <= tmp_word[15:8];
-
-              // b2 = píxel 2
-              if ((base_pix_wr + 2) >= 0 && (base_pix_wr + 2) < MAX_PIXELS)
-                in_pix_mem[base_pix_wr + 2] <= tmp_word[23:16];
-
-              // b3 = píxel 3
-              if ((base_pix_wr + 3) >= 0 && (base_pix_wr + 3) < MAX_PIXELS)
-                in_pix_mem[base_pix_wr + 3] <= tmp_word[31:24];
-
-              in_ptr <= in_ptr + 16'd1;
-            end
-          end
-
           // Puntero de salida en palabras de 32 bits
           REG_OUT_ADDR: out_ptr   <= h_wdata[15:0];
 
@@ -257,9 +385,38 @@ module dsa_top_seq #(
       end
 
       // ==============================
-      // Autoincremento de OUT_ADDR al leer OUT_DATA
+      // Escritura de datos de entrada (4 píxeles por palabra), por IN_DATA
+      // o por la ventana IN_WIN
+      // ==============================
+      if (in_data_wr) begin
+        if (in_ptr < MAX_WORDS[15:0]) begin
+          tmp_word    = h_wdata;
+          base_pix_wr = in_ptr * 4;
+
+          // b0 = píxel 0 (LSB)
+          if (base_pix_wr >= 0 && base_pix_wr < MAX_PIXELS)
+            in_pix_mem[host_base + base_pix_wr] <= tmp_word[7:0];
+
+          // b1 = píxel 1
+          if ((base_pix_wr + 1) >= 0 && (base_pix_wr + 1) < MAX_PIXELS)
+            in_pix_mem[host_base + base_pix_wr + 1] <= tmp_word[15:8];
+
+          // b2 = píxel 2
+          if ((base_pix_wr + 2) >= 0 && (base_pix_wr + 2) < MAX_PIXELS)
+            in_pix_mem[host_base + base_pix_wr + 2] <= tmp_word[23:16];
+
+          // b3 = píxel 3
+          if ((base_pix_wr + 3) >= 0 && (base_pix_wr + 3) < MAX_PIXELS)
+            in_pix_mem[host_base + base_pix_wr + 3] <= tmp_word[31:24];
+
+          in_ptr <= in_ptr + 16'd1;
+        end
+      end
+
+      // ==============================
+      // Autoincremento de OUT_ADDR al leer OUT_DATA u OUT_WIN
       // ==============================
-      if (h_rd_en && (h_addr == REG_OUT_DATA)) begin
+      if (out_data_rd) begin
         if (out_ptr < MAX_WORDS[15:0]) begin
           out_ptr <= out_ptr + 16'd1;
         end
@@ -290,6 +447,14 @@ module dsa_top_seq #(
         if (ow > img_w) ow = img_w;
         if (oh > img_h) oh = img_h;
 
+        // Con tiling manda el tamaño del tile que pidió el host
+        if (tile_en) begin
+          ow = (tile_ow == 16'd0) ? 16'd1 : tile_ow;
+          oh = (tile_oh == 16'd0) ? 16'd1 : tile_oh;
+          if (ow > IMG_MAX_W[15:0]) ow = IMG_MAX_W[15:0];
+          if (oh > IMG_MAX_H[15:0]) oh = IMG_MAX_H[15:0];
+        end
+
         out_w <= ow;
         out_h <= oh;
 
@@ -300,6 +465,10 @@ module dsa_top_seq #(
           inv_scale_q <= (32'd65536 / scale_q8_8);
         end
 
+        // Banco y modo del core para esta corrida
+        core_bank_run <= core_bank;
+        box_run       <= mode[1];
+
         // Reset de contadores
         perf_cyc <= 32'd0;
         perf_pix <= 32'd0;
@@ -321,18 +490,47 @@ module dsa_top_seq #(
       // ==============================
       if (core_wr_valid) begin
         if (core_wr_addr < MAX_PIXELS) begin
-          out_pix_mem[core_wr_addr] <= core_wr_data;
+          out_pix_mem[core_base + core_wr_addr] <= core_wr_data;
         end
       end
     end
   end
 
+  // ---------------------------------------------------------
+  // Palabra de salida en out_ptr (OUT_DATA y OUT_WIN)
+  // ---------------------------------------------------------
+  logic [31:0] out_word;
+
+  always_comb begin
+    logic [7:0] b0, b1, b2, b3;
+
+    base_pix_rd = out_ptr * 4;
+
+    b0 = 8'd0;
+    b1 = 8'd0;
+    b2 = 8'd0;
+    b3 = 8'd0;
+
+    if (base_pix_rd >= 0 && base_pix_rd < MAX_PIXELS)
+      b0 = out_pix_mem[host_base + base_pix_rd];
+
+    if ((base_pix_rd + 1) >= 0 && (base_pix_rd + 1) < MAX_PIXELS)
+      b1 = out_pix_mem[host_base + base_pix_rd + 1];
+
+    if ((base_pix_rd + 2) >= 0 && (base_pix_rd + 2) < MAX_PIXELS)
+      b2 = out_pix_mem[host_base + base_pix_rd + 2];
+
+    if ((base_pix_rd + 3) >= 0 && (base_pix_rd + 3) < MAX_PIXELS)
+      b3 = out_pix_mem[host_base + base_pix_rd + 3];
+
+    out_word = {b3, b2, b1, b0};
+  end
+
   // ---------------------------------------------------------
   // Lecturas (CSRs + empaquetado de salida)
   // ---------------------------------------------------------
   always_comb begin
     h_rdata     = 32'd0;
-    base_pix_rd = out_ptr * 4;
 
     unique case (h_addr)
       REG_STATUS:    h_rdata = {30'd0, done, busy};
@@ -341,36 +539,26 @@ module dsa_top_seq #(
       REG_SCALE:     h_rdata = {16'd0, scale_q8_8};
       REG_MODE:      h_rdata = {24'd0, mode};
 
+      REG_SRC_W:     h_rdata = {16'd0, src_w};
+      REG_SRC_H:     h_rdata = {16'd0, src_h};
+      REG_ORG_X:     h_rdata = {16'd0, org_x};
+      REG_ORG_Y:     h_rdata = {16'd0, org_y};
+      REG_OFF_X:     h_rdata = {16'd0, off_x};
+      REG_OFF_Y:     h_rdata = {16'd0, off_y};
+      REG_TILE_OW:   h_rdata = {16'd0, tile_ow};
+      REG_TILE_OH:   h_rdata = {16'd0, tile_oh};
+
+      REG_BANK:      h_rdata = {30'd0, core_bank, host_bank};
+
       REG_PERF_CYC:  h_rdata = perf_cyc;
       REG_PERF_PIX:  h_rdata = perf_pix;
 
       REG_IN_ADDR:   h_rdata = {16'd0, in_ptr};
       REG_OUT_ADDR:  h_rdata = {16'd0, out_ptr};
 
-      REG_OUT_DATA: begin
-        logic [7:0] b0, b1, b2, b3;
-
-        b0 = 8'd0;
-        b1 = 8'd0;
-        b2 = 8'd0;
-        b3 = 8'd0;
-
-        if (base_pix_rd >= 0 && base_pix_rd < MAX_PIXELS)
-          b0 = out_pix_mem[base_pix_rd];
-
-        if ((base_pix_rd + 1) >= 0 && (base_pix_rd + 1) < MAX_PIXELS)
-          b1 = out_pix_mem[base_pix_rd + 1];
-
-        if ((base_pix_rd + 2) >= 0 && (base_pix_rd + 2) < MAX_PIXELS)
-          b2 = out_pix_mem[base_pix_rd + 2];
-
-        if ((base_pix_rd + 3) >= 0 && (base_pix_rd + 3) < MAX_PIXELS)
-          b3 = out_pix_mem[base_pix_rd + 3];
-
-        h_rdata = {b3, b2, b1, b0};
-      end
+      REG_OUT_DATA:  h_rdata = out_word;
 
-      default: ;
+      default: if (out_win) h_rdata = out_word;
     endcase
   end
 
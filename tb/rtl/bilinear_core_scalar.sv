@@ -19,6 +19,17 @@ module bilinear_core_scalar #(
     input  [15:0] out_h,
     input  [15:0] inv_scale_q,   // Q8.8 ≈ 1/scale
 
+    // Tiling: la imagen completa es src_w x src_h y este tile produce la
+    // salida desde (org_x, org_y); la BRAM de entrada (in_w x in_h) tiene el
+    // píxel global (off_x, off_y) en la dirección 0. Sin tiling: src = in y
+    // org/off = 0.
+    input  [15:0] src_w,
+    input  [15:0] src_h,
+    input  [15:0] org_x,
+    input  [15:0] org_y,
+    input  [15:0] off_x,
+    input  [15:0] off_y,
+
     // Stepping
     input        step_mode,  // 0 = corre normal, 1 = stepping
     input        step,       // pedido de paso (desde CTRL.STEP)
@@ -125,9 +136,9 @@ module bilinear_core_scalar #(
 
                         //--------------------------------------------------
                         S_ISSUE: begin
-                            // Índices enteros de salida
-                            yo_int = cur_y;
-                            xo_int = cur_x;
+                            // Índices enteros de salida (globales)
+                            yo_int = cur_y + org_y;
+                            xo_int = cur_x + org_x;
 
                             // (yo + 0.5) en Q8.8
                             yo_q = (yo_int << FRAC_BITS) + (ONE_Q/2);
@@ -139,21 +150,21 @@ module bilinear_core_scalar #(
                             temp_q_x = (xo_q * inv_scale_q) >> FRAC_BITS;
                             xs_q = temp_q_x - (ONE_Q/2);
 
-                            // Parte entera (clamp a [0, in_h-1] / [0, in_w-1])
+                            // Parte entera (clamp a [0, src_h-1] / [0, src_w-1])
                             y_int = ys_q >>> FRAC_BITS;
                             if (y_int < 0)           y_int = 0;
-                            else if (y_int > in_h-1) y_int = in_h-1;
+                            else if (y_int > src_h-1) y_int = src_h-1;
 
                             x_int = xs_q >>> FRAC_BITS;
                             if (x_int < 0)           x_int = 0;
-                            else if (x_int > in_w-1) x_int = in_w-1;
+                            else if (x_int > src_w-1) x_int = src_w-1;
 
                             y0_i = y_int;
-                            if (y_int + 1 <= in_h-1) y1_i = y_int + 1;
+                            if (y_int + 1 <= src_h-1) y1_i = y_int + 1;
                             else                     y1_i = y_int;
 
                             x0_i = x_int;
-                            if (x_int + 1 <= in_w-1) x1_i = x_int + 1;
+                            if (x_int + 1 <= src_w-1) x1_i = x_int + 1;
                             else                     x1_i = x_int;
 
                             // Parte fraccional (0..255)
@@ -164,11 +175,11 @@ module bilinear_core_scalar #(
                             if (tx_q_i < 0)     tx_q_i = 0;
                             if (tx_q_i > 255)   tx_q_i = 255;
 
-                            // Direcciones lineales: img[y][x] -> y*in_w + x
-                            rd_addr0 <= y0_i*in_w + x0_i;
-                            rd_addr1 <= y0_i*in_w + x1_i;
-                            rd_addr2 <= y1_i*in_w + x0_i;
-                            rd_addr3 <= y1_i*in_w + x1_i;
+                            // Direcciones lineales dentro del tile: img[y][x] -> (y-off_y)*in_w + (x-off_x)
+                            rd_addr0 <= (y0_i-off_y)*in_w + (x0_i-off_x);
+                            rd_addr1 <= (y0_i-off_y)*in_w + (x1_i-off_x);
+                            rd_addr2 <= (y1_i-off_y)*in_w + (x0_i-off_x);
+                            rd_addr3 <= (y1_i-off_y)*in_w + (x1_i-off_x);
 
                             state <= S_COMP;
                         end
@@ -246,8 +257,8 @@ module bilinear_core_scalar #(
                     end
 
                     S_ISSUE: begin
-                        yo_int = cur_y;
-                        xo_int = cur_x;
+                        yo_int = cur_y + org_y;
+                        xo_int = cur_x + org_x;
 
                         yo_q = (yo_int << FRAC_BITS) + (ONE_Q/2);
                         temp_q_y = (yo_q * inv_scale_q) >> FRAC_BITS;
@@ -259,18 +270,18 @@ module bilinear_core_scalar #(
 
                         y_int = ys_q >>> FRAC_BITS;
                         if (y_int < 0)           y_int = 0;
-                        else if (y_int > in_h-1) y_int = in_h-1;
+                        else if (y_int > src_h-1) y_int = src_h-1;
 
                         x_int = xs_q >>> FRAC_BITS;
                         if (x_int < 0)           x_int = 0;
-                        else if (x_int > in_w-1) x_int = in_w-1;
+                        else if (x_int > src_w-1) x_int = src_w-1;
 
                         y0_i = y_int;
-                        if (y_int + 1 <= in_h-1) y1_i = y_int + 1;
+                        if (y_int + 1 <= src_h-1) y1_i = y_int + 1;
                         else                     y1_i = y_int;
 
                         x0_i = x_int;
-                        if (x_int + 1 <= in_w-1) x1_i = x_int + 1;
+                        if (x_int + 1 <= src_w-1) x1_i = x_int + 1;
                         else                     x1_i = x_int;
 
                         ty_q_i = ys_q & (ONE_Q - 1);
@@ -280,10 +291,10 @@ module bilinear_core_scalar #(
                         if (tx_q_i < 0)     tx_q_i = 0;
                         if (tx_q_i > 255)   tx_q_i = 255;
 
-                        rd_addr0 <= y0_i*in_w + x0_i;
-                        rd_addr1 <= y0_i*in_w + x1_i;
-                        rd_addr2 <= y1_i*in_w + x0_i;
-                        rd_addr3 <= y1_i*in_w + x1_i;
+                        rd_addr0 <= (y0_i-off_y)*in_w + (x0_i-off_x);
+                        rd_addr1 <= (y0_i-off_y)*in_w + (x1_i-off_x);
+                        rd_addr2 <= (y1_i-off_y)*in_w + (x0_i-off_x);
+                        rd_addr3 <= (y1_i-off_y)*in_w + (x1_i-off_x);
 
                         state <= S_COMP;
                     end
@@ -223,6 +223,14 @@ module bilinear_top #(
         .out_h      (out_h),
         .inv_scale_q(inv_scale_q),
 
+        // sin tiling: imagen completa en la BRAM
+        .src_w      (in_w),
+        .src_h      (in_h),
+        .org_x      (16'd0),
+        .org_y      (16'd0),
+        .off_x      (16'd0),
+        .off_y      (16'd0),
+
         .step_mode  (ctrl_step_mode),
         .step       (ctrl_step),
         .step_ack   (step_ack_scalar),
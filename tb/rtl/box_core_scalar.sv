@@ -0,0 +1,197 @@
+// tb/rtl/box_core_scalar.sv
+// Núcleo secuencial en modo box (promedio de área), para escalas < 0.5.
+// Misma interfaz que bilinear_core_scalar (sin stepping) y mismo tiling.
+//
+// Cada píxel de salida promedia su huella en la imagen global:
+//   x en [(xo * inv_scale_q) >> 8, ((xo+1) * inv_scale_q) >> 8), igual en y,
+//   con clamp a src_w/src_h y al menos un píxel por eje.
+//   pix = (suma + n/2) / n,  n = ancho * alto de la huella
+// Es la misma cuenta que model/downscale_box.h, así que el modelo C++ da
+// los mismos bytes. Lee un píxel por ciclo por rd_addr0 (la BRAM responde
+// al ciclo siguiente) y divide con restas sucesivas, un bit del cociente por
+// ciclo: n + 10 ciclos por píxel de salida.
+//
+// La huella entra en la BRAM del tile, así que n <= W_MAX * H_MAX y
+// suma + n/2 < 256 * n: el cociente tiene 8 bits y el divisor solo los de n.
+
+`timescale 1ns/1ps
+
+module box_core_scalar #(
+    parameter W_MAX = 64,
+    parameter H_MAX = 64
+) (
+    input        clk,
+    input        rst_n,
+
+    // Control
+    input        start,
+    input  [15:0] in_w,
+    input  [15:0] in_h,
+    input  [15:0] out_w,
+    input  [15:0] out_h,
+    input  [15:0] inv_scale_q,   // Q8.8 ≈ 1/scale
+
+    // Tiling, igual que bilinear_core_scalar
+    input  [15:0] src_w,
+    input  [15:0] src_h,
+    input  [15:0] org_x,
+    input  [15:0] org_y,
+    input  [15:0] off_x,
+    input  [15:0] off_y,
+
+    // Estado
+    output reg   busy,
+    output reg   done,
+
+    // Lectura de BRAM de entrada (un píxel por ciclo)
+    output reg [31:0] rd_addr0,
+    input      [7:0]  rd_data0,
+
+    // Escritura de salida
+    output reg        wr_valid,
+    output reg [31:0] wr_addr,
+    output reg [7:0]  wr_data
+);
+
+    // Índices de píxel de salida (xo, yo)
+    reg [15:0] cur_x, cur_y;
+
+    // Anchos del acumulador y del divisor (ver arriba)
+    localparam MAX_PIXELS = W_MAX * H_MAX;
+    localparam CNT_W      = $clog2(MAX_PIXELS + 1);
+    localparam ACC_W      = CNT_W + 8;
+
+    // Estados de la FSM
+    localparam S_IDLE  = 3'd0;
+    localparam S_SPAN  = 3'd1;   // calcula la huella y pide el primer píxel
+    localparam S_ACC   = 3'd2;   // acumula un píxel por ciclo
+    localparam S_DIV   = 3'd3;   // un bit del cociente por ciclo (8 ciclos)
+    localparam S_WRITE = 3'd4;
+
+    reg [2:0] state;
+
+    // Huella [xb, xe) x [yb, ye) en coordenadas globales y píxel pedido
+    integer xb, xe, yb, ye;
+    integer px, py;
+    reg [ACC_W-1:0] acc;
+    reg [CNT_W-1:0] cnt;
+
+    // Divisor: rem arranca en acc + cnt/2 y le va restando cnt << div_k
+    reg [ACC_W-1:0] rem;
+    reg [7:0]       quo;
+    reg [2:0]       div_k;
+
+    // Auxiliares
+    integer xo_int, yo_int;
+
+    always @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            busy     <= 1'b0;
+            done     <= 1'b0;
+            wr_valid <= 1'b0;
+            wr_addr  <= 32'd0;
+            wr_data  <= 8'd0;
+            cur_x    <= 16'd0;
+            cur_y    <= 16'd0;
+            rd_addr0 <= 32'd0;
+            state    <= S_IDLE;
+        end else begin
+            wr_valid <= 1'b0;
+
+            case (state)
+                S_IDLE: begin
+                    busy <= 1'b0;
+                    if (start) begin
+                        busy  <= 1'b1;
+                        done  <= 1'b0;
+                        cur_x <= 16'd0;
+                        cur_y <= 16'd0;
+                        state <= S_SPAN;
+                        $display("[BOX] START t=%0t out_w=%0d out_h=%0d", $time, out_w, out_h);
+                    end
+                end
+
+                S_SPAN: begin
+                    xo_int = cur_x + org_x;
+                    yo_int = cur_y + org_y;
+
+                    xb = (xo_int * inv_scale_q) >> 8;
+                    xe = ((xo_int + 1) * inv_scale_q) >> 8;
+                    if (xb > src_w-1) xb = src_w-1;
+                    if (xe > src_w)   xe = src_w;
+                    if (xe <= xb)     xe = xb + 1;
+
+                    yb = (yo_int * inv_scale_q) >> 8;
+                    ye = ((yo_int + 1) * inv_scale_q) >> 8;
+                    if (yb > src_h-1) yb = src_h-1;
+                    if (ye > src_h)   ye = src_h;
+                    if (ye <= yb)     ye = yb + 1;
+
+                    cnt = (xe - xb) * (ye - yb);   // <= in_w * in_h
+                    acc = 0;
+                    px  = xb;
+                    py  = yb;
+
+                    rd_addr0 <= (py-off_y)*in_w + (px-off_x);
+                    state    <= S_ACC;
+                end
+
+                S_ACC: begin
+                    // rd_data0 es el píxel (px, py) pedido el ciclo anterior
+                    acc = acc + rd_data0;
+                    if (px + 1 < xe) begin
+                        px = px + 1;
+                        rd_addr0 <= (py-off_y)*in_w + (px-off_x);
+                    end else if (py + 1 < ye) begin
+                        px = xb;
+                        py = py + 1;
+                        rd_addr0 <= (py-off_y)*in_w + (px-off_x);
+                    end else begin
+                        rem   <= acc + (cnt >> 1);
+                        quo   <= 8'd0;
+                        div_k <= 3'd7;
+                        state <= S_DIV;
+                    end
+                end
+
+                S_DIV: begin
+                    if (rem >= ({{(ACC_W-CNT_W){1'b0}}, cnt} << div_k)) begin
+                        rem        <= rem - ({{(ACC_W-CNT_W){1'b0}}, cnt} << div_k);
+                        quo[div_k] <= 1'b1;
+                    end
+                    if (div_k == 3'd0)
+                        state <= S_WRITE;
+                    else
+                        div_k <= div_k - 3'd1;
+                end
+
+                S_WRITE: begin
+                    wr_addr  <= cur_y * out_w + cur_x;
+                    wr_data  <= quo;
+                    wr_valid <= 1'b1;
+
+                    if (cur_x + 1 < out_w) begin
+                        cur_x <= cur_x + 1;
+                        state <= S_SPAN;
+                    end else begin
+                        cur_x <= 16'd0;
+                        if (cur_y + 1 < out_h) begin
+                            cur_y <= cur_y + 1;
+                            state <= S_SPAN;
+                        end else begin
+                            busy  <= 1'b0;
+                            done  <= 1'b1;
+                            state <= S_IDLE;
+                            $display("[BOX] DONE t=%0t", $time);
+                        end
+                    end
+                end
+
+                default: begin
+                    state <= S_IDLE;
+                end
+            endcase
+        end
+    end
+
+endmodule
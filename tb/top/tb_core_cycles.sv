@@ -0,0 +1,172 @@
+// tb/top/tb_core_cycles.sv
+// Testbench para validar model/core_cycle_model.h contra el RTL.
+// Corre bilinear_top (escalar o SIMD según MODE) con tamaños y escala por
+// parámetro, lee PERF_CYC/PERF_PIX de los CSR y escribe la salida en OUT_FILE.
+// Lo lanza scripts/check_core_model.py con iverilog -P..., por ejemplo:
+//   iverilog -g2012 -Ptb_core_cycles.N=4 -Ptb_core_cycles.MODE=1 ...
+
+`timescale 1ns/1ps
+
+module tb_core_cycles #(
+  parameter integer N     = 4,
+  parameter integer MODE  = 0,       // 0 = escalar, 1 = SIMD
+  parameter integer IN_W  = 32,
+  parameter integer IN_H  = 32,
+  parameter integer OUT_W = 16,
+  parameter integer OUT_H = 16,
+  parameter integer INV   = 512,     // inv_scale_q (Q8.8), como lo carga dsa_top_seq
+  parameter         IN_FILE  = "vectors/patterns/grad_32x32.raw",
+  parameter         OUT_FILE = "results/out_core_cycles.raw"
+);
+
+  localparam integer MAX_CYC = 4 * OUT_W * OUT_H + 100;
+
+  reg [7:0] img_in  [0:IN_W*IN_H-1];
+  reg [7:0] img_out [0:OUT_W*OUT_H-1];
+
+  integer fin, fout;
+  integer i, ch, lane, ciclos;
+
+  reg clk = 0;
+  always #5 clk = ~clk;
+
+  reg rst_n;
+
+  // CSR
+  reg         csr_we;
+  reg  [3:0]  csr_addr;
+  reg  [31:0] csr_wdata;
+  wire [31:0] csr_rdata;
+
+  // Memoria
+  wire [N*32-1:0] rd_addr0, rd_addr1, rd_addr2, rd_addr3;
+  reg  [N*8-1:0]  rd_data0, rd_data1, rd_data2, rd_data3;
+  wire [N-1:0]    wr_valid;
+  wire [N*32-1:0] wr_addr;
+  wire [N*8-1:0]  wr_data;
+
+  bilinear_top #(
+    .N(N)
+  ) top_u (
+    .clk       (clk),
+    .rst_n     (rst_n),
+    .csr_we    (csr_we),
+    .csr_addr  (csr_addr),
+    .csr_wdata (csr_wdata),
+    .csr_rdata (csr_rdata),
+    .rd_addr0  (rd_addr0),
+    .rd_addr1  (rd_addr1),
+    .rd_addr2  (rd_addr2),
+    .rd_addr3  (rd_addr3),
+    .rd_data0  (rd_data0),
+    .rd_data1  (rd_data1),
+    .rd_data2  (rd_data2),
+    .rd_data3  (rd_data3),
+    .wr_valid  (wr_valid),
+    .wr_addr   (wr_addr),
+    .wr_data   (wr_data)
+  );
+
+  // BRAM de entrada: fuera de IN_W*IN_H se lee 0 (igual que el modelo)
+  always @* begin
+    rd_data0 = {N*8{1'b0}};
+    rd_data1 = {N*8{1'b0}};
+    rd_data2 = {N*8{1'b0}};
+    rd_data3 = {N*8{1'b0}};
+    for (lane = 0; lane < N; lane = lane+1) begin
+      if (rd_addr0[lane*32 +: 32] < IN_W*IN_H) rd_data0[lane*8 +: 8] = img_in[rd_addr0[lane*32 +: 32]];
+      if (rd_addr1[lane*32 +: 32] < IN_W*IN_H) rd_data1[lane*8 +: 8] = img_in[rd_addr1[lane*32 +: 32]];
+      if (rd_addr2[lane*32 +: 32] < IN_W*IN_H) rd_data2[lane*8 +: 8] = img_in[rd_addr2[lane*32 +: 32]];
+      if (rd_addr3[lane*32 +: 32] < IN_W*IN_H) rd_data3[lane*8 +: 8] = img_in[rd_addr3[lane*32 +: 32]];
+    end
+  end
+
+  // BRAM de salida
+  integer wl;
+  always @(posedge clk) begin
+    for (wl = 0; wl < N; wl = wl+1) begin
+      if (wr_valid[wl] && wr_addr[wl*32 +: 32] < OUT_W*OUT_H)
+        img_out[wr_addr[wl*32 +: 32]] <= wr_data[wl*8 +: 8];
+    end
+  end
+
+  task csr_write(input [3:0] a, input [31:0] d);
+    begin
+      @(posedge clk);
+      csr_we    <= 1'b1;
+      csr_addr  <= a;
+      csr_wdata <= d;
+      @(posedge clk);
+      csr_we    <= 1'b0;
+    end
+  endtask
+
+  task csr_read(input [3:0] a, output [31:0] d);
+    begin
+      csr_addr = a;
+      #1 d = csr_rdata;
+    end
+  endtask
+
+  reg [31:0] status, perf_cyc, perf_pix;
+
+  initial begin
+    rst_n  = 0;
+    csr_we = 0;
+    csr_addr = 0;
+    csr_wdata = 0;
+
+    fin = $fopen(IN_FILE, "rb");
+    if (fin == 0) begin
+      $display("ERROR: no se pudo abrir %0s", IN_FILE);
+      $finish;
+    end
+    for (i = 0; i < IN_W*IN_H; i = i+1) begin
+      ch = $fgetc(fin);
+      img_in[i] = (ch == -1) ? 8'd0 : ch[7:0];
+    end
+    $fclose(fin);
+    for (i = 0; i < OUT_W*OUT_H; i = i+1)
+      img_out[i] = 8'd0;
+
+    repeat (5) @(posedge clk);
+    rst_n = 1;
+
+    csr_write(4'h2, INV);
+    csr_write(4'h3, {IN_W[15:0], IN_H[15:0]});
+    csr_write(4'h4, {OUT_W[15:0], OUT_H[15:0]});
+    // EN | START | MODE
+    csr_write(4'h0, 32'h3 | (MODE << 2));
+
+    ciclos = 0;
+    status = 0;
+    while (!status[1] && ciclos < MAX_CYC) begin
+      @(posedge clk);
+      ciclos = ciclos + 1;
+      csr_read(4'h1, status);
+    end
+    if (!status[1]) begin
+      $display("[TB_CYC] TIMEOUT: done nunca llegó, ciclos=%0d", ciclos);
+      $finish;
+    end
+
+    // un ciclo más para la última escritura y el último PERF_PIX
+    @(posedge clk);
+    #1;
+    csr_read(4'h5, perf_cyc);
+    csr_read(4'h6, perf_pix);
+    $display("[TB_CYC] MODE=%0d N=%0d in=%0dx%0d out=%0dx%0d inv=%0d PERF_CYC=%0d PERF_PIX=%0d",
+             MODE, N, IN_W, IN_H, OUT_W, OUT_H, INV, perf_cyc, perf_pix);
+
+    fout = $fopen(OUT_FILE, "wb");
+    if (fout == 0) begin
+      $display("ERROR: no se pudo abrir %0s", OUT_FILE);
+      $finish;
+    end
+    for (i = 0; i < OUT_W*OUT_H; i = i+1)
+      $fwrite(fout, "%c", img_out[i]);
+    $fclose(fout);
+    $finish;
+  end
+
+endmodule
@@ -41,6 +41,15 @@ module tb_core_minimal;
     .out_w       (out_w),
     .out_h       (out_h),
     .inv_scale_q (inv_scale_q),
+
+    // sin tiling: imagen completa en la BRAM
+    .src_w       (in_w),
+    .src_h       (in_h),
+    .org_x       (16'd0),
+    .org_y       (16'd0),
+    .off_x       (16'd0),
+    .off_y       (16'd0),
+
     .busy        (busy),
     .done        (done),
 
@@ -62,6 +62,14 @@ module tb_top_scalar;
     .out_h       (out_h),
     .inv_scale_q (inv_scale_q),
 
+    // sin tiling: imagen completa en la BRAM
+    .src_w       (in_w),
+    .src_h       (in_h),
+    .org_x       (16'd0),
+    .org_y       (16'd0),
+    .off_x       (16'd0),
+    .off_y       (16'd0),
+
     // stepping
     .step_mode   (step_mode),
     .step        (step),
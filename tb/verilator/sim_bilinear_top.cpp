@@ -0,0 +1,349 @@
+// tb/verilator/sim_bilinear_top.cpp
+// Harness de Verilator para bilinear_top (core escalar y SIMD).
+//
+// Cada caso (tamaño, escala, modo) carga la imagen directo en el modelo de
+// BRAM del harness, programa los CSR como un host, corre hasta DONE y
+// compara en el mismo proceso:
+//   - la salida contra el modelo Q8.8 del driver (build_coord_tables_hw +
+//     downscale_u8), byte a byte;
+//   - PERF_CYC / PERF_PIX contra model/core_cycle_model.h.
+// Los casos se reparten entre hilos (--jobs); cada uno tiene su propio
+// VerilatedContext, asi que no comparten estado. Ademas el modelo puede
+// compilarse con --threads de Verilator (VL_THREADS en el Makefile).
+//
+// Compilar y correr: make verilator_run   (ver el Makefile: VL_N, VL_THREADS)
+//
+// Uso:
+//   sim_bilinear_top [--sizes 32x32,64x64] [--scales 0x80,0xB3] [--modes scalar,simd]
+//                    [--in imagen.raw] [--jobs 0] [--max-cyc 50000000]
+// Sin --in cada caso usa una imagen aleatoria (semilla fija por tamaño).
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "verilated.h"
+#include "Vbilinear_top.h"
+
+#include "../../model/core_cycle_model.h"
+#include "../../model/downscale_kernels.h"
+#include "../../model/image_io.h"
+#include "../../model/thread_pool.h"
+
+#ifndef VL_N
+#define VL_N 4   // parametro N de bilinear_top (-GN=...)
+#endif
+
+// Verilator < 5 lo pide para $time; con VerilatedContext no se usa
+double sc_time_stamp() { return 0; }
+
+// Direcciones de CSR de bilinear_top (palabras)
+enum {
+    CSR_CTRL = 0x0,
+    CSR_STATUS = 0x1,
+    CSR_SCALE_Q = 0x2,
+    CSR_IN_W_H = 0x3,
+    CSR_OUT_W_H = 0x4,
+    CSR_PERF_CYC = 0x5,
+    CSR_PERF_PIX = 0x6,
+};
+
+// -----------------------------------------------------------------------------
+// Acceso a los puertos empaquetados por lane. Verilator usa un entero hasta
+// 64 bits y un arreglo de palabras de 32 bits (VlWide) si es mas ancho.
+// -----------------------------------------------------------------------------
+
+template <class T>
+static uint32_t get_word(const T &sig, int word) {
+    if constexpr (std::is_integral<T>::value)
+        return (uint32_t)((uint64_t)sig >> (32 * word));
+    else
+        return sig[word];
+}
+
+template <class T>
+static uint8_t get_byte(const T &sig, int lane) {
+    return (uint8_t)(get_word(sig, lane / 4) >> (8 * (lane % 4)));
+}
+
+template <class T>
+static void set_byte(T &sig, int lane, uint8_t v) {
+    const int sh = 8 * (lane % 4);
+    if constexpr (std::is_integral<T>::value) {
+        const int bit = 8 * lane;
+        sig = (T)(((uint64_t)sig & ~((uint64_t)0xFF << bit)) | ((uint64_t)v << bit));
+    } else {
+        sig[lane / 4] = (sig[lane / 4] & ~(0xFFu << sh)) | ((uint32_t)v << sh);
+    }
+}
+
+template <class T>
+static bool get_bit(const T &sig, int lane) {
+    return (get_word(sig, lane / 32) >> (lane % 32)) & 1u;
+}
+
+// -----------------------------------------------------------------------------
+// Un caso
+// -----------------------------------------------------------------------------
+
+struct sim_case {
+    int w, h;
+    uint32_t scale_q8_8;
+    bool simd;
+};
+
+struct sim_result {
+    int out_w = 0, out_h = 0;
+    uint64_t cycles = 0;        // flancos simulados en total
+    uint32_t perf_cyc = 0, perf_pix = 0;
+    uint64_t model_cyc = 0, model_pix = 0;
+    long mismatches = 0;
+    std::string error;
+    double ms = 0;
+};
+
+class top_sim {
+public:
+    top_sim() : ctx_(new VerilatedContext), top_(new Vbilinear_top(ctx_.get())) {
+        top_->clk = 0;
+        top_->rst_n = 0;
+        top_->csr_we = 0;
+        top_->eval();
+        for (int i = 0; i < 4; ++i) tick();
+        top_->rst_n = 1;
+        tick();
+    }
+
+    ~top_sim() { top_->final(); }
+
+    uint64_t cycles() const { return cycles_; }
+
+    // BRAM de entrada (w x h compacta) y de salida (out_w x out_h)
+    void load(const uint8_t *pix, int w, int h, int out_w, int out_h) {
+        in_.assign(pix, pix + (size_t)w * h);
+        out_.assign((size_t)out_w * out_h, 0);
+    }
+    const std::vector<uint8_t> &output() const { return out_; }
+
+    void csr_write(int addr, uint32_t data) {
+        top_->csr_we = 1;
+        top_->csr_addr = addr;
+        top_->csr_wdata = data;
+        tick();
+        top_->csr_we = 0;
+    }
+
+    uint32_t csr_read(int addr) {
+        top_->csr_addr = addr;
+        top_->eval();
+        return top_->csr_rdata;
+    }
+
+    // Un flanco de subida: la BRAM de salida toma wr_* de antes del flanco
+    // (como el always @(posedge clk) de los tb) y la de entrada responde
+    // combinacional a las rd_addr nuevas.
+    void tick() {
+        for (int l = 0; l < VL_N; ++l) {
+            if (!get_bit(top_->wr_valid, l)) continue;
+            uint32_t a = get_word(top_->wr_addr, l);
+            if (a < out_.size()) out_[a] = get_byte(top_->wr_data, l);
+        }
+        top_->clk = 1;
+        top_->eval();
+        feed_reads();
+        top_->clk = 0;
+        top_->eval();
+        ++cycles_;
+    }
+
+private:
+    std::unique_ptr<VerilatedContext> ctx_;
+    std::unique_ptr<Vbilinear_top> top_;
+    std::vector<uint8_t> in_, out_;
+    uint64_t cycles_ = 0;
+
+    // Fuera de la imagen se lee 0, igual que tb_top_simd / tb_core_cycles
+    void feed_reads() {
+        for (int l = 0; l < VL_N; ++l) {
+            uint32_t a0 = get_word(top_->rd_addr0, l), a1 = get_word(top_->rd_addr1, l);
+            uint32_t a2 = get_word(top_->rd_addr2, l), a3 = get_word(top_->rd_addr3, l);
+            set_byte(top_->rd_data0, l, a0 < in_.size() ? in_[a0] : 0);
+            set_byte(top_->rd_data1, l, a1 < in_.size() ? in_[a1] : 0);
+            set_byte(top_->rd_data2, l, a2 < in_.size() ? in_[a2] : 0);
+            set_byte(top_->rd_data3, l, a3 < in_.size() ? in_[a3] : 0);
+        }
+        top_->eval();
+    }
+};
+
+static sim_result run_case(const sim_case &c, const uint8_t *img, uint64_t max_cyc) {
+    using clk = std::chrono::steady_clock;
+    auto t0 = clk::now();
+    sim_result r;
+    hw_out_dims(c.w, c.h, c.scale_q8_8, 0, 0, r.out_w, r.out_h);
+
+    top_sim sim;
+    sim.load(img, c.w, c.h, r.out_w, r.out_h);
+    sim.csr_write(CSR_SCALE_Q, core_inv_scale_q(c.scale_q8_8));
+    sim.csr_write(CSR_IN_W_H, ((uint32_t)c.w << 16) | (uint32_t)c.h);
+    sim.csr_write(CSR_OUT_W_H, ((uint32_t)r.out_w << 16) | (uint32_t)r.out_h);
+    sim.csr_write(CSR_CTRL, 0x3u | (c.simd ? 0x4u : 0u));   // EN | START | MODE
+
+    const uint64_t limit = sim.cycles() + max_cyc;
+    while (!(sim.csr_read(CSR_STATUS) & 0x2u)) {
+        if (sim.cycles() >= limit) {
+            r.error = "timeout esperando DONE";
+            return r;
+        }
+        sim.tick();
+    }
+    sim.tick();   // ultima escritura y ultimo PERF_PIX
+    r.perf_cyc = sim.csr_read(CSR_PERF_CYC);
+    r.perf_pix = sim.csr_read(CSR_PERF_PIX);
+    r.cycles = sim.cycles();
+
+    // Referencias en el mismo proceso
+    std::vector<uint8_t> ref((size_t)r.out_w * r.out_h);
+    coord_tables tab = build_coord_tables_hw(c.w, c.h, r.out_w, r.out_h, c.scale_q8_8);
+    downscale_u8(img, c.w, tab, ref.data());
+    const std::vector<uint8_t> &out = sim.output();
+    for (size_t i = 0; i < ref.size(); ++i)
+        r.mismatches += out[i] != ref[i];
+
+    core_params p;
+    p.lanes = c.simd ? VL_N : 1;
+    p.in_w = c.w;
+    p.in_h = c.h;
+    p.out_w = r.out_w;
+    p.out_h = r.out_h;
+    p.inv_scale_q = core_inv_scale_q(c.scale_q8_8);
+    core_stats m = run_core_model(p, nullptr, nullptr);
+    r.model_cyc = m.perf_cyc;
+    r.model_pix = m.perf_pix;
+
+    r.ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+    return r;
+}
+
+static std::vector<std::string> split_list(const std::string &s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+int main(int argc, char **argv) {
+    std::string sizes = "32x32,64x64,128x128";
+    std::string scales = "0x40,0x80,0xB3,0x100";
+    std::string modes = "scalar,simd";
+    std::string in_path;
+    int jobs = 0;
+    uint64_t max_cyc = 50000000;
+
+    bool bad_args = false;
+    for (int i = 1; i < argc && !bad_args; ++i) {
+        std::string a = argv[i];
+        if (a == "--sizes" && i+1 < argc) sizes = argv[++i];
+        else if (a == "--scales" && i+1 < argc) scales = argv[++i];
+        else if (a == "--modes" && i+1 < argc) modes = argv[++i];
+        else if (a == "--in" && i+1 < argc) in_path = argv[++i];
+        else if (a == "--jobs" && i+1 < argc) jobs = std::stoi(argv[++i]);
+        else if (a == "--max-cyc" && i+1 < argc) max_cyc = std::stoull(argv[++i]);
+        else if (a.compare(0, 1, "+") == 0) continue;   // plusargs de Verilator
+        else bad_args = true;
+    }
+    if (bad_args || jobs < 0) {
+        std::fprintf(stderr, "uso: %s [--sizes 32x32,64x64] [--scales 0x80,0xB3]"
+                     " [--modes scalar,simd] [--in imagen.raw] [--jobs 0] [--max-cyc N]\n",
+                     argv[0]);
+        return 1;
+    }
+    Verilated::commandArgs(argc, argv);
+
+    // Imagenes: una por tamaño, compartida (solo lectura) entre los casos
+    std::vector<sim_case> cases;
+    std::vector<std::vector<uint8_t>> imgs;
+    std::vector<size_t> img_of;
+    for (const auto &sz : split_list(sizes)) {
+        int W = 0, H = 0;
+        if (std::sscanf(sz.c_str(), "%dx%d", &W, &H) != 2 || W <= 0 || H <= 0 ||
+            W > 0xFFFF || H > 0xFFFF) {
+            std::fprintf(stderr, "error: tamaño invalido %s\n", sz.c_str());
+            return 1;
+        }
+        std::vector<uint8_t> img((size_t)W * H);
+        if (!in_path.empty()) {
+            try {
+                mapped_image m = map_image_u8(in_path, W, H, /*pad_short=*/true);
+                std::copy(m.pix, m.pix + img.size(), img.begin());
+            } catch (const std::exception &e) {
+                std::fprintf(stderr, "error: %s\n", e.what());
+                return 1;
+            }
+        } else {
+            std::mt19937 rng(W * 65536u + H);
+            for (auto &p : img) p = (uint8_t)rng();
+        }
+        imgs.push_back(std::move(img));
+
+        for (const auto &sc : split_list(scales)) {
+            uint32_t sq = (uint32_t)std::stoul(sc, nullptr, 0);
+            if (sq == 0 || sq > 0x100) {
+                std::fprintf(stderr, "error: escala invalida %s (0 < q <= 0x100)\n", sc.c_str());
+                return 1;
+            }
+            for (const auto &md : split_list(modes)) {
+                if (md != "scalar" && md != "simd") {
+                    std::fprintf(stderr, "error: modo desconocido %s (scalar|simd)\n", md.c_str());
+                    return 1;
+                }
+                cases.push_back({W, H, sq, md == "simd"});
+                img_of.push_back(imgs.size() - 1);
+            }
+        }
+    }
+
+    thread_pool pool(jobs);
+    std::printf("bilinear_top N=%d, %zu casos, %u hilos\n", VL_N, cases.size(), pool.size());
+
+    std::vector<sim_result> res(cases.size());
+    std::mutex print_m;
+    std::atomic<int> n_bad{0};
+    using clk = std::chrono::steady_clock;
+    auto t0 = clk::now();
+
+    pool.parallel_for((int)cases.size(), [&](int k) {
+        const sim_case &c = cases[k];
+        sim_result &r = res[k] = run_case(c, imgs[img_of[k]].data(), max_cyc);
+        const bool ok = r.error.empty() && r.mismatches == 0 &&
+                        r.perf_cyc == r.model_cyc && r.perf_pix == r.model_pix;
+        if (!ok) ++n_bad;
+
+        std::lock_guard<std::mutex> lk(print_m);
+        std::printf("%5dx%-5d 0x%03X %-6s -> %5dx%-5d ", c.w, c.h, c.scale_q8_8,
+                    c.simd ? "simd" : "scalar", r.out_w, r.out_h);
+        if (!r.error.empty()) {
+            std::printf("ERROR: %s\n", r.error.c_str());
+            return;
+        }
+        std::printf("PERF_CYC=%u (modelo %llu) PERF_PIX=%u (modelo %llu) %ld mismatches"
+                    "  %.1f ms, %.2f Mciclos/s  %s\n",
+                    r.perf_cyc, (unsigned long long)r.model_cyc,
+                    r.perf_pix, (unsigned long long)r.model_pix, r.mismatches,
+                    r.ms, r.cycles / (r.ms * 1e3), ok ? "ok" : "FAIL");
+    });
+
+    double s = std::chrono::duration<double>(clk::now() - t0).count();
+    std::printf("%zu de %zu casos ok en %.2f s\n", cases.size() - n_bad, cases.size(), s);
+    return n_bad ? 1 : 0;
+}
@@ -36,6 +36,9 @@ def main():
     run("make simd_run")
     run("make simd_check")
 
+    print("== Simulacion compilada (Verilator) en tamaños grandes ==")
+    run("make verilator_run")
+
     print("== Suite de verificacion completada sin errores ==")
 
 if __name__ == "__main__":